@@ -29,6 +29,8 @@ VERSION_STRING="$(cat "${BASEPATH}/build/VersionString")"
 _log "Resolved version string: ${VERSION_STRING}"
 _log "Compiling..."
 cmake --build . -- -j 8
+_log "Running tests..."
+ctest --output-on-failure
 _log "Staging installation..."
 make install DESTDIR=AppDir
 
@@ -0,0 +1,253 @@
+
+#include "BatchProcessor.hpp"
+#include "Utilities.hpp"
+#include "OutputFrameFormat.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <csignal>
+
+using namespace std;
+
+namespace YerFace {
+
+BatchProcessor::BatchProcessor(json config, string myExecutable, std::vector<string> myPassthroughArguments, string myManifestFile) {
+	logger = new Logger("BatchProcessor");
+	if((myMutex = YerFace_CreateMutex()) == NULL) {
+		throw runtime_error("Failed creating mutex!");
+	}
+	executable = myExecutable;
+	passthroughArguments = myPassthroughArguments;
+	manifestFile = myManifestFile;
+	concurrentJobs = config["YerFace"]["BatchProcessor"]["concurrentJobs"];
+	if(concurrentJobs < 0) {
+		throw invalid_argument("BatchProcessor concurrentJobs cannot be less than zero.");
+	}
+	if(concurrentJobs == 0) {
+		concurrentJobs = std::max(1, SDL_GetCPUCount() / 4);
+	}
+	maxConcurrentWorkers = config["YerFace"]["WorkerPoolExecutor"]["maxConcurrentWorkers"];
+	nextJob = 0;
+	logger->debug1("BatchProcessor object constructed and ready to go!");
+}
+
+BatchProcessor::~BatchProcessor() noexcept(false) {
+	logger->debug1("BatchProcessor object destructing...");
+	for(BatchProcessorJob *job : jobs) {
+		delete job;
+	}
+	YerFace_DestroyMutex(myMutex);
+	delete logger;
+}
+
+bool BatchProcessor::run(void) {
+	parseManifest();
+
+	int runners = std::min(concurrentJobs, (int)jobs.size());
+	//Unless the configuration says otherwise, concurrent jobs split the machine evenly between them.
+	int childMaxConcurrentWorkers = maxConcurrentWorkers;
+	if(childMaxConcurrentWorkers == 0) {
+		childMaxConcurrentWorkers = std::max(2, SDL_GetCPUCount() / runners);
+	}
+	for(BatchProcessorJob *job : jobs) {
+		job->arguments.push_back("--maxConcurrentWorkers=" + to_string(childMaxConcurrentWorkers));
+	}
+	workerCommand = Utilities::shellQuoteArgument(executable);
+	for(string argument : passthroughArguments) {
+		workerCommand += " " + Utilities::shellQuoteArgument(argument);
+	}
+	workerCommand += " --batchWorker --headless --childProcess --maxConcurrentWorkers=" + to_string(childMaxConcurrentWorkers);
+	logger->info("Running %zu jobs from %s, %d at a time.", (size_t)jobs.size(), manifestFile.c_str(), runners);
+
+	#ifndef WIN32
+	//A batch worker which dies takes the read end of its job pipe with it. We would rather see the write fail.
+	signal(SIGPIPE, SIG_IGN);
+	#endif
+
+	Uint32 runStart = SDL_GetTicks();
+	std::vector<SDL_Thread *> threads;
+	for(int i = 0; i < runners; i++) {
+		SDL_Thread *thread;
+		if((thread = SDL_CreateThread(BatchProcessor::runnerThread, "BatchRunner", (void *)this)) == NULL) {
+			throw runtime_error("Failed spawning batch runner thread!");
+		}
+		threads.push_back(thread);
+	}
+	for(SDL_Thread *thread : threads) {
+		SDL_WaitThread(thread, NULL);
+	}
+	double runTimeSeconds = (double)(SDL_GetTicks() - runStart) / 1000.0;
+
+	int failures = 0;
+	FrameNumber totalFrames = 0;
+	for(BatchProcessorJob *job : jobs) {
+		if(job->result != 0) {
+			failures++;
+			continue;
+		}
+		totalFrames += job->frames;
+	}
+	logger->info("Batch finished in %.02lf seconds. %zu jobs succeeded and %d failed. Overall throughput was %.02lf fps.", runTimeSeconds, (size_t)(jobs.size() - failures), failures, runTimeSeconds > 0.0 ? (double)totalFrames / runTimeSeconds : 0.0);
+	return failures == 0;
+}
+
+void BatchProcessor::parseManifest(void) {
+	json manifest;
+	try {
+		std::ifstream fileStream = std::ifstream(manifestFile);
+		if(fileStream.fail()) {
+			throw invalid_argument("Specified batch manifest failed to open.");
+		}
+		std::stringstream ssBuffer;
+		ssBuffer << fileStream.rdbuf();
+		manifest = json::parse(ssBuffer.str());
+	} catch(exception &e) {
+		logger->err("Failed to parse batch manifest \"%s\". Got exception: %s", manifestFile.c_str(), e.what());
+		throw;
+	}
+	if(!manifest.is_array() || manifest.size() < 1) {
+		throw invalid_argument("Batch manifest must be a non-empty array of jobs.");
+	}
+
+	//These are set by the BatchProcessor itself, or would make no sense inside a batch.
+	const std::vector<string> reservedArguments = { "headless", "childProcess", "maxConcurrentWorkers", "batchManifest", "batchWorker", "lowLatency" };
+	for(size_t i = 0; i < manifest.size(); i++) {
+		json jobArguments = manifest[i];
+		if(!jobArguments.is_object() || jobArguments.find("inVideo") == jobArguments.end() || jobArguments.find("outEventData") == jobArguments.end()) {
+			throw invalid_argument("Every batch manifest job must be an object with at least inVideo and outEventData.");
+		}
+		BatchProcessorJob *job = new BatchProcessorJob();
+		job->index = (int)i;
+		job->name = jobArguments["inVideo"];
+		job->outEventData = jobArguments["outEventData"];
+		job->outLogFile = job->outEventData + ".log";
+		job->result = -1;
+		job->runTimeSeconds = 0.0;
+		job->frames = 0;
+		job->mediaSeconds = 0.0;
+		job->arguments.push_back(executable);
+		for(string argument : passthroughArguments) {
+			//Arguments set by the job itself take precedence over the shared ones.
+			size_t keyStart = argument.find_first_not_of('-');
+			string key = keyStart == string::npos ? "" : argument.substr(keyStart, argument.find('=') - keyStart);
+			if(key != "configFile" && jobArguments.find(key) != jobArguments.end()) {
+				continue;
+			}
+			job->arguments.push_back(argument);
+		}
+		for(json::iterator iter = jobArguments.begin(); iter != jobArguments.end(); ++iter) {
+			if(std::find(reservedArguments.begin(), reservedArguments.end(), iter.key()) != reservedArguments.end()) {
+				delete job;
+				throw invalid_argument("Batch manifest jobs cannot set the \"" + iter.key() + "\" argument.");
+			}
+			string value = iter.value().is_string() ? (string)iter.value() : iter.value().dump();
+			if(iter.key() == "outLogFile") {
+				job->outLogFile = value;
+				continue;
+			}
+			if((iter.key() == "inVideo" || iter.key() == "inAudio") && value == "-") {
+				//The batch worker's STDIN is its job pipe.
+				delete job;
+				throw invalid_argument("Batch manifest jobs cannot read from STDIN.");
+			}
+			job->arguments.push_back("--" + iter.key() + "=" + value);
+		}
+		job->arguments.push_back("--headless");
+		job->arguments.push_back("--childProcess");
+		job->arguments.push_back("--outLogFile=" + job->outLogFile);
+		jobs.push_back(job);
+	}
+}
+
+void BatchProcessor::measureJobOutput(BatchProcessorJob *job) {
+	try {
+		OutputFrameFileReader outputReader(job->outEventData);
+		json frame;
+		double firstStartTime = 0.0, lastStartTime = 0.0;
+		while(outputReader.readFrame(&frame)) {
+			if(job->frames == 0) {
+				firstStartTime = frame["meta"]["startTime"];
+			}
+			lastStartTime = frame["meta"]["startTime"];
+			job->frames++;
+		}
+		job->mediaSeconds = lastStartTime - firstStartTime;
+	} catch(exception &e) {
+		logger->warning("Job %d output %s could not be read to measure throughput. Got exception: %s", job->index, job->outEventData.c_str(), e.what());
+	}
+}
+
+int BatchProcessor::runnerThread(void *ptr) {
+	BatchProcessor *self = (BatchProcessor *)ptr;
+	ChildProcessPipe *worker = NULL;
+	while(true) {
+		BatchProcessorJob *job = NULL;
+		YerFace_MutexLock(self->myMutex);
+		if(self->nextJob < self->jobs.size()) {
+			job = self->jobs[self->nextJob];
+			self->nextJob++;
+		}
+		YerFace_MutexUnlock(self->myMutex);
+		if(job == NULL) {
+			break;
+		}
+
+		self->logger->info("Starting job %d: %s", job->index, job->name.c_str());
+		Uint32 jobStart = SDL_GetTicks();
+		job->result = -1;
+		try {
+			if(worker == NULL) {
+				self->logger->debug1("Starting batch worker: %s", self->workerCommand.c_str());
+				worker = new ChildProcessPipe(self->workerCommand);
+			}
+			json request;
+			request["job"] = job->index;
+			request["arguments"] = job->arguments;
+			if(worker->writeLine(request.dump())) {
+				string line;
+				while(worker->readLine(&line)) {
+					json reply;
+					try {
+						reply = json::parse(line);
+					} catch(exception &e) {
+						self->logger->debug1("Ignoring unexpected batch worker output: %s", line.c_str());
+						continue;
+					}
+					if(reply.is_object() && reply.find("job") != reply.end() && reply["job"] == job->index) {
+						job->result = reply["result"];
+						break;
+					}
+				}
+			}
+		} catch(exception &e) {
+			self->logger->err("Job %d (%s) could not be handed to a batch worker. Got exception: %s", job->index, job->name.c_str(), e.what());
+		}
+		job->runTimeSeconds = (double)(SDL_GetTicks() - jobStart) / 1000.0;
+		if(job->result != 0) {
+			self->logger->err("Job %d (%s) failed with result code %d! See the log file: %s", job->index, job->name.c_str(), job->result, job->outLogFile.c_str());
+			//A failed job may have left its worker in no state to run another, so the next job gets a fresh one.
+			if(worker != NULL) {
+				int workerResult = worker->wait();
+				self->logger->debug1("Batch worker exited with result code %d.", workerResult);
+				delete worker;
+				worker = NULL;
+			}
+			continue;
+		}
+		self->measureJobOutput(job);
+		self->logger->info("Job %d (%s) finished in %.02lf seconds. " YERFACE_FRAMENUMBER_FORMAT " frames at %.02lf fps, %.02lfx real time.", job->index, job->name.c_str(), job->runTimeSeconds, job->frames, job->runTimeSeconds > 0.0 ? (double)job->frames / job->runTimeSeconds : 0.0, job->runTimeSeconds > 0.0 ? job->mediaSeconds / job->runTimeSeconds : 0.0);
+	}
+	if(worker != NULL) {
+		int workerResult = worker->wait();
+		if(workerResult != 0) {
+			self->logger->warning("Batch worker exited with result code %d.", workerResult);
+		}
+		delete worker;
+	}
+	return 0;
+}
+
+} //namespace YerFace
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Logger.hpp"
+#include "Utilities.hpp"
+
+#include <string>
+#include <vector>
+
+#include "SDL.h"
+
+using namespace std;
+
+namespace YerFace {
+
+class BatchProcessorJob {
+public:
+	int index;
+	string name;
+	string outEventData;
+	string outLogFile;
+	std::vector<string> arguments; //Complete command line for this job, as the batch worker will parse it.
+	int result;
+	double runTimeSeconds;
+	FrameNumber frames;
+	double mediaSeconds;
+};
+
+//Runs every job in a manifest, several at a time, and reports per-job throughput. Jobs are handed over a pipe to a few
+//long-lived headless yer-face batch workers, which run them one after another so that each worker loads its models once.
+class BatchProcessor {
+public:
+	BatchProcessor(json config, string myExecutable, std::vector<string> myPassthroughArguments, string myManifestFile);
+	~BatchProcessor() noexcept(false);
+	bool run(void);
+private:
+	void parseManifest(void);
+	void measureJobOutput(BatchProcessorJob *job);
+	static int runnerThread(void *ptr);
+
+	Logger *logger;
+	SDL_mutex *myMutex;
+
+	string executable;
+	std::vector<string> passthroughArguments;
+	string manifestFile;
+	string workerCommand;
+	int concurrentJobs;
+	int maxConcurrentWorkers;
+
+	std::vector<BatchProcessorJob *> jobs;
+	size_t nextJob; //Protected by myMutex.
+};
+
+}; //namespace YerFace
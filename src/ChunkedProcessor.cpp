@@ -0,0 +1,243 @@
+
+#include "ChunkedProcessor.hpp"
+#include "Utilities.hpp"
+#include "OutputFrameFormat.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <algorithm>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+using namespace std;
+
+namespace YerFace {
+
+ChunkedProcessor::ChunkedProcessor(json config, string myExecutable, std::vector<string> myPassthroughArguments, string myInVideo, string myInVideoFormat, string myOutEventData, int myNumChunks) {
+	logger = new Logger("ChunkedProcessor");
+	executable = myExecutable;
+	passthroughArguments = myPassthroughArguments;
+	inVideo = myInVideo;
+	if(inVideo.length() < 1 || inVideo == "-") {
+		throw invalid_argument("Chunked processing requires an input video file which can be seeked.");
+	}
+	inVideoFormat = myInVideoFormat;
+	outEventData = myOutEventData;
+	if(outEventData.length() < 1) {
+		throw invalid_argument("Chunked processing requires an output event data file.");
+	}
+	numChunks = myNumChunks;
+	if(numChunks < 2) {
+		throw invalid_argument("Chunked processing requires at least two chunks.");
+	}
+	warmupSeconds = config["YerFace"]["ChunkedProcessor"]["warmupSeconds"];
+	if(warmupSeconds < 0.0) {
+		throw invalid_argument("Chunked processing warmupSeconds cannot be negative.");
+	}
+	minimumChunkSeconds = config["YerFace"]["ChunkedProcessor"]["minimumChunkSeconds"];
+	if(minimumChunkSeconds <= warmupSeconds) {
+		throw invalid_argument("Chunked processing minimumChunkSeconds must be longer than warmupSeconds.");
+	}
+	maxConcurrentWorkers = config["YerFace"]["WorkerPoolExecutor"]["maxConcurrentWorkers"];
+	logger->debug1("ChunkedProcessor object constructed and ready to go!");
+}
+
+ChunkedProcessor::~ChunkedProcessor() noexcept(false) {
+	logger->debug1("ChunkedProcessor object destructing...");
+	for(ChunkedProcessorChunk *chunk : chunks) {
+		delete chunk;
+	}
+	delete logger;
+}
+
+bool ChunkedProcessor::run(void) {
+	probeChunkBoundaries();
+
+	//Unless the configuration says otherwise, the children split the machine evenly between them.
+	int childMaxConcurrentWorkers = maxConcurrentWorkers;
+	if(childMaxConcurrentWorkers == 0) {
+		childMaxConcurrentWorkers = std::max(2, SDL_GetCPUCount() / (int)chunks.size());
+	}
+
+	Uint32 runStart = SDL_GetTicks();
+	for(ChunkedProcessorChunk *chunk : chunks) {
+		char timeRange[192];
+		snprintf(timeRange, 192, "--chunkIndex=%d --chunkStartTime=%.06lf --chunkEndTime=%.06lf --maxConcurrentWorkers=%d", chunk->index, chunk->startTime, chunk->endTime, childMaxConcurrentWorkers);
+		chunk->outEventData = outEventData + ".chunk" + to_string(chunk->index);
+		chunk->outLogFile = chunk->outEventData + ".log";
+		chunk->command = Utilities::shellQuoteArgument(executable);
+		for(string argument : passthroughArguments) {
+			chunk->command += " " + Utilities::shellQuoteArgument(argument);
+		}
+		chunk->command += " --headless --childProcess " + Utilities::shellQuoteArgument("--outEventData=" + chunk->outEventData) + " " + Utilities::shellQuoteArgument("--outLogFile=" + chunk->outLogFile) + " " + timeRange;
+		chunk->result = -1;
+		chunk->runTimeSeconds = 0.0;
+		chunk->processor = this;
+		logger->debug1("Chunk %d command: %s", chunk->index, chunk->command.c_str());
+		if((chunk->thread = SDL_CreateThread(ChunkedProcessor::runChunkThread, "Chunk", (void *)chunk)) == NULL) {
+			throw runtime_error("Failed spawning chunk thread!");
+		}
+	}
+
+	bool success = true;
+	for(ChunkedProcessorChunk *chunk : chunks) {
+		SDL_WaitThread(chunk->thread, NULL);
+		if(chunk->result != 0) {
+			logger->err("Chunk %d failed with result code %d! See the log file: %s", chunk->index, chunk->result, chunk->outLogFile.c_str());
+			success = false;
+		}
+	}
+	if(!success) {
+		return false;
+	}
+	double runTimeSeconds = (double)(SDL_GetTicks() - runStart) / 1000.0;
+	logger->info("All %lu chunks finished in %.02lf seconds.", chunks.size(), runTimeSeconds);
+
+	if(!stitchOutput()) {
+		return false;
+	}
+	for(ChunkedProcessorChunk *chunk : chunks) {
+		remove(chunk->outEventData.c_str());
+		remove(chunk->outLogFile.c_str());
+	}
+	return true;
+}
+
+void ChunkedProcessor::probeChunkBoundaries(void) {
+	int ret;
+	AVInputFormat *inputFormat = NULL;
+	if(inVideoFormat.length() > 0) {
+		if((inputFormat = av_find_input_format(inVideoFormat.c_str())) == NULL) {
+			throw invalid_argument("specified input video format could not be resolved");
+		}
+	}
+	AVFormatContext *formatContext = NULL;
+	if((ret = avformat_open_input(&formatContext, inVideo.c_str(), inputFormat, NULL)) < 0) {
+		throw runtime_error("Failed opening input video for chunk probing!");
+	}
+	if((ret = avformat_find_stream_info(formatContext, NULL)) < 0) {
+		avformat_close_input(&formatContext);
+		throw runtime_error("Failed finding stream info for chunk probing!");
+	}
+	int streamIndex = av_find_best_stream(formatContext, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+	if(streamIndex < 0 || formatContext->duration == AV_NOPTS_VALUE) {
+		avformat_close_input(&formatContext);
+		throw runtime_error("Input video has no video stream or no known duration, so it cannot be chunked.");
+	}
+	AVStream *stream = formatContext->streams[streamIndex];
+	double timeBase = av_q2d(stream->time_base);
+	double formatStartSeconds = 0.0;
+	if(formatContext->start_time != AV_NOPTS_VALUE) {
+		formatStartSeconds = (double)formatContext->start_time / (double)AV_TIME_BASE;
+	}
+	double durationSeconds = (double)formatContext->duration / (double)AV_TIME_BASE;
+
+	//Snap each nominal boundary back to the nearest preceding keyframe, so every child starts decoding close to its own range.
+	std::vector<double> boundaries;
+	boundaries.push_back(0.0);
+	AVPacket *packet = av_packet_alloc();
+	for(int i = 1; i < numChunks; i++) {
+		double nominal = durationSeconds * (double)i / (double)numChunks;
+		int64_t target = (int64_t)((nominal + formatStartSeconds) / timeBase);
+		if(av_seek_frame(formatContext, streamIndex, target, AVSEEK_FLAG_BACKWARD) < 0) {
+			logger->warning("Failed seeking to %.02lf seconds while probing for keyframes. Skipping this boundary.", nominal);
+			continue;
+		}
+		double keyframe = -1.0;
+		while(av_read_frame(formatContext, packet) >= 0) {
+			if(packet->stream_index == streamIndex && (packet->flags & AV_PKT_FLAG_KEY)) {
+				int64_t pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+				keyframe = ((double)pts * timeBase) - formatStartSeconds;
+				av_packet_unref(packet);
+				break;
+			}
+			av_packet_unref(packet);
+		}
+		if(keyframe - boundaries.back() < minimumChunkSeconds || durationSeconds - keyframe < minimumChunkSeconds) {
+			logger->debug1("Keyframe boundary at %.02lf seconds would make a chunk shorter than %.02lf seconds. Skipping it.", keyframe, minimumChunkSeconds);
+			continue;
+		}
+		boundaries.push_back(keyframe);
+	}
+	av_packet_free(&packet);
+	avformat_close_input(&formatContext);
+
+	for(size_t i = 0; i < boundaries.size(); i++) {
+		ChunkedProcessorChunk *chunk = new ChunkedProcessorChunk();
+		chunk->index = (int)i;
+		chunk->startTime = boundaries[i];
+		chunk->endTime = i + 1 < boundaries.size() ? boundaries[i + 1] : -1.0;
+		chunk->thread = NULL;
+		chunks.push_back(chunk);
+		logger->info("Chunk %d covers %.02lf to %.02lf seconds.", chunk->index, chunk->startTime, chunk->endTime >= 0.0 ? chunk->endTime : durationSeconds);
+	}
+	if(chunks.size() < (size_t)numChunks) {
+		logger->notice("Input is only long enough for %lu chunks, rather than the %d requested.", chunks.size(), numChunks);
+	}
+}
+
+bool ChunkedProcessor::stitchOutput(void) {
+	ofstream outputFilestream;
+	outputFilestream.open(outEventData, ofstream::out | ofstream::binary | ofstream::trunc);
+	if(outputFilestream.fail()) {
+		logger->err("Could not open %s for writing!", outEventData.c_str());
+		return false;
+	}
+
+	//Each child numbers its frames starting from one, so frame numbers are reassigned as we go.
+	//The children all share our configuration, so the stitched output keeps whichever format they wrote.
+	FrameNumber frameNumber = 0;
+	double lastStartTime = -1.0;
+	OutputFrameBinarySchema binarySchema = OutputFrameFormat::getBinarySchema();
+	bool headerWritten = false;
+	for(ChunkedProcessorChunk *chunk : chunks) {
+		OutputFrameFileReader *chunkReader;
+		try {
+			chunkReader = new OutputFrameFileReader(chunk->outEventData);
+		} catch(exception &e) {
+			logger->err("Could not open chunk %d event data %s for reading! Got exception: %s", chunk->index, chunk->outEventData.c_str(), e.what());
+			return false;
+		}
+		bool binary = chunkReader->getFormat() == OUTPUT_FRAME_FORMAT_BINARY;
+		if(binary && !headerWritten) {
+			outputFilestream << OutputFrameFormat::encodeBinaryHeader(binarySchema);
+			headerWritten = true;
+		}
+		json frame;
+		while(chunkReader->readFrame(&frame)) {
+			double startTime = frame["meta"]["startTime"];
+			if(startTime <= lastStartTime) {
+				logger->warning("Chunk %d produced a frame at %.04lf which overlaps the previous chunk. Dropping it.", chunk->index, startTime);
+				continue;
+			}
+			lastStartTime = startTime;
+			frameNumber++;
+			frame["meta"]["frameNumber"] = frameNumber;
+			if(binary) {
+				outputFilestream << OutputFrameFormat::encodeBinaryFrame(OutputFrameFormat::recordFromJSON(frame));
+			} else {
+				outputFilestream << frame.dump(-1, ' ', true) << "\n";
+			}
+		}
+		delete chunkReader;
+	}
+	outputFilestream.close();
+	logger->info("Stitched " YERFACE_FRAMENUMBER_FORMAT " frames from %lu chunks into %s", frameNumber, chunks.size(), outEventData.c_str());
+	return true;
+}
+
+int ChunkedProcessor::runChunkThread(void *ptr) {
+	ChunkedProcessorChunk *chunk = (ChunkedProcessorChunk *)ptr;
+	ChunkedProcessor *self = chunk->processor;
+	self->logger->info("Starting chunk %d...", chunk->index);
+	Uint32 chunkStart = SDL_GetTicks();
+	chunk->result = std::system(chunk->command.c_str());
+	chunk->runTimeSeconds = (double)(SDL_GetTicks() - chunkStart) / 1000.0;
+	self->logger->info("Chunk %d finished in %.02lf seconds.", chunk->index, chunk->runTimeSeconds);
+	return 0;
+}
+
+} //namespace YerFace
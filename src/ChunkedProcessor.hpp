@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Logger.hpp"
+#include "Utilities.hpp"
+
+#include <string>
+#include <vector>
+
+#include "SDL.h"
+
+using namespace std;
+
+namespace YerFace {
+
+class ChunkedProcessor;
+
+class ChunkedProcessorChunk {
+public:
+	int index;
+	double startTime, endTime; //Output time range for this chunk. An end time of -1.0 means "until the end of the input."
+	string outEventData;
+	string outLogFile;
+	string command;
+	int result;
+	double runTimeSeconds;
+	SDL_Thread *thread;
+	ChunkedProcessor *processor;
+};
+
+//Splits a single offline input into keyframe-aligned time ranges and processes each range in a child
+//yer-face process, then stitches the child event data back together in frame order.
+//Child processes (rather than threads) are necessary because the pipeline relies on process-wide state.
+class ChunkedProcessor {
+public:
+	ChunkedProcessor(json config, string myExecutable, std::vector<string> myPassthroughArguments, string myInVideo, string myInVideoFormat, string myOutEventData, int myNumChunks);
+	~ChunkedProcessor() noexcept(false);
+	bool run(void);
+private:
+	void probeChunkBoundaries(void);
+	bool stitchOutput(void);
+	static int runChunkThread(void *ptr);
+
+	Logger *logger;
+
+	string executable;
+	std::vector<string> passthroughArguments;
+	string inVideo, inVideoFormat, outEventData;
+	int numChunks;
+	double warmupSeconds;
+	double minimumChunkSeconds;
+	int maxConcurrentWorkers;
+
+	std::vector<ChunkedProcessorChunk *> chunks;
+};
+
+}; //namespace YerFace
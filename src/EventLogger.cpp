@@ -7,11 +7,14 @@ namespace YerFace {
 
 EventLogger::EventLogger(json config, string myEventFile, double myEventFileStartSeconds, Status *myStatus, OutputDriver *myOutputDriver, FrameServer *myFrameServer) {
 	replayWorkerPool = NULL;
+	eventReader = NULL;
+	lastReplayedFrameNumber = -1;
 	eventFilename = myEventFile;
 	eventFileStartSeconds = myEventFileStartSeconds;
 	if(eventFileStartSeconds < 0.0) {
 		throw invalid_argument("you probably don't want your start seconds to be negative");
 	}
+	replayStartTime = -1.0;
 	status = myStatus;
 	if(status == NULL) {
 		throw invalid_argument("status cannot be NULL");
@@ -26,25 +29,23 @@ EventLogger::EventLogger(json config, string myEventFile, double myEventFileStar
 	}
 	logger = new Logger("EventLogger");
 
-	if((myMutex = SDL_CreateMutex()) == NULL) {
+	if((myMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
 
-	outputDriver->registerFrameData("events");
+	outputDriver->registerFrameData(OUTPUT_FRAME_DATA_EVENTS);
 
 	eventReplay = false;
 	frameEvents.clear();
 	pendingReplayFrames.clear();
 	if(eventFilename.length() > 0) {
-		eventFilestream.open(eventFilename, ifstream::in | ifstream::binary);
-		if(eventFilestream.fail()) {
-			throw invalid_argument("could not open inEvents for reading");
-		}
+		//Replay files may be either JSON or binary output. The reader works out which.
+		eventReader = new OutputFrameFileReader(eventFilename);
 		nextPacket = json::object();
 		eventReplay = true;
 
 		//We also want to introduce a checkpoint so that frames cannot TRANSITION AWAY from FRAME_STATUS_PREPROCESS without our blessing.
-		frameServer->registerFrameStatusCheckpoint(FRAME_STATUS_PREPROCESS, "eventLogger.ran");
+		preprocessCheckpoint = frameServer->registerFrameStatusCheckpoint(FRAME_STATUS_PREPROCESS, "eventLogger.ran");
 
 		WorkerPoolParameters workerPoolParameters;
 		workerPoolParameters.name = "EventLogger.Replay";
@@ -88,7 +89,11 @@ EventLogger::~EventLogger() noexcept(false) {
 	}
 	YerFace_MutexUnlock(myMutex);
 
-	SDL_DestroyMutex(myMutex);
+	if(eventReader != NULL) {
+		delete eventReader;
+	}
+
+	YerFace_DestroyMutex(myMutex);
 	delete logger;
 }
 
@@ -107,6 +112,12 @@ void EventLogger::registerEventType(EventType eventType) {
 	YerFace_MutexUnlock(myMutex);
 }
 
+void EventLogger::setReplayStartTime(double startTime) {
+	YerFace_MutexLock(myMutex);
+	replayStartTime = startTime;
+	YerFace_MutexUnlock(myMutex);
+}
+
 void EventLogger::logEvent(string eventName, json payload, FrameTimestamps frameTimestamps, bool propagate, json sourcePacket) {
 	// logger->info("Got logEvent() at frame #" YERFACE_FRAMENUMBER_FORMAT " of type [%s] with payload: %s", frameTimestamps.frameNumber, eventName.c_str(), payload.dump(-1, ' ', true).c_str());
 	YerFace_MutexLock(myMutex);
@@ -124,8 +135,7 @@ void EventLogger::logEvent(string eventName, json payload, FrameTimestamps frame
 		YerFace_MutexUnlock(myMutex);
 		return;
 	}
-	auto frameEventsIter = frameEvents.find(frameTimestamps.frameNumber);
-	if(frameEventsIter == frameEvents.end()) {
+	if(!frameEvents.contains(frameTimestamps.frameNumber)) {
 		YerFace_MutexUnlock(myMutex);
 		throw invalid_argument("logEvent() called with bad frame number!");
 	}
@@ -157,6 +167,12 @@ void EventLogger::processNextPacket(FrameTimestamps frameTimestamps) {
 		double frameEnd = frameTimestamps.estimatedEndTimestamp - frameDurationHalf;
 		double packetTime = nextPacket["meta"]["startTime"];
 		packetTime -= eventFileStartSeconds;
+		//When the input starts part way through, packets from before the start belong to frames we will never see. Without this they would all pile onto our first frame.
+		if(replayStartTime >= 0.0 && packetTime < replayStartTime - frameDurationHalf) {
+			logger->debug4("Skipping event replay packet at %lf because it is before the replay start time %lf.", packetTime, replayStartTime);
+			nextPacket = json::object();
+			return;
+		}
 		// if(nextPacket.find("events") != nextPacket.end()) {
 		// 	logger->info("==== EVENT REPLAY ATTEMPT: [packetTime: %lf, currentFrameNumber: " YERFACE_FRAMENUMBER_FORMAT ", currentFrameStart: %lf, currentFrameEnd: %lf]; Candidate Packet Events: %s", packetTime, frameTimestamps.frameNumber, frameStart, frameEnd, nextPacket["events"].dump(-1, ' ', true).c_str());
 		// }
@@ -218,7 +234,7 @@ void EventLogger::handleFrameStatusChange(void *userdata, WorkingFrameStatus new
 			break;
 		case FRAME_STATUS_LATE_PROCESSING:
 			YerFace_MutexLock(self->myMutex);
-			self->outputDriver->insertFrameData("events", self->frameEvents[frameNumber], frameNumber);
+			self->outputDriver->insertFrameEvents(self->frameEvents[frameNumber], frameNumber);
 			YerFace_MutexUnlock(self->myMutex);
 			break;
 		case FRAME_STATUS_GONE:
@@ -232,7 +248,6 @@ void EventLogger::handleFrameStatusChange(void *userdata, WorkingFrameStatus new
 bool EventLogger::replayWorkerHandler(WorkerPoolWorker *worker) {
 	EventLogger *self = (EventLogger *)worker->ptr;
 
-	static FrameNumber lastFrameNumber = -1;
 	bool didWork = false;
 	FrameNumber myFrameNumber = -1;
 	FrameTimestamps frameTimestamps;
@@ -256,10 +271,10 @@ bool EventLogger::replayWorkerHandler(WorkerPoolWorker *worker) {
 
 	//// DO THE WORK ////
 	if(myFrameNumber > 0) {
-		if(myFrameNumber <= lastFrameNumber) {
+		if(myFrameNumber <= self->lastReplayedFrameNumber) {
 			throw logic_error("EventLogger handling frames out of order!");
 		}
-		lastFrameNumber = myFrameNumber;
+		self->lastReplayedFrameNumber = myFrameNumber;
 
 		self->eventReplayHold = false;
 
@@ -267,9 +282,9 @@ bool EventLogger::replayWorkerHandler(WorkerPoolWorker *worker) {
 
 		YerFace_MutexLock(self->myMutex);
 		self->processNextPacket(frameTimestamps);
-		string line;
-		while(!self->eventReplayHold && getline(self->eventFilestream, line)) {
-			self->nextPacket = json::parse(line);
+		json packet;
+		while(!self->eventReplayHold && self->eventReader->readFrame(&packet)) {
+			self->nextPacket = packet;
 			self->processNextPacket(frameTimestamps);
 		}
 		if(self->eventReplayHold) {
@@ -279,7 +294,7 @@ bool EventLogger::replayWorkerHandler(WorkerPoolWorker *worker) {
 
 		self->logger->debug4("DONE EVENT REPLAY: Finished frame #" YERFACE_FRAMENUMBER_FORMAT " at time: %lf-%lf", frameTimestamps.frameNumber, frameTimestamps.startTimestamp, frameTimestamps.estimatedEndTimestamp);
 
-		self->frameServer->setWorkingFrameStatusCheckpoint(myFrameNumber, FRAME_STATUS_PREPROCESS, "eventLogger.ran");
+		self->frameServer->setWorkingFrameStatusCheckpoint(myFrameNumber, FRAME_STATUS_PREPROCESS, self->preprocessCheckpoint);
 
 		didWork = true;
 	}
@@ -32,6 +32,7 @@ public:
 	EventLogger(json config, string myEventFile, double myEventFileStartSeconds, Status *myStatus, OutputDriver *myOutputDriver, FrameServer *myFrameServer);
 	~EventLogger() noexcept(false);
 	void registerEventType(EventType eventType);
+	void setReplayStartTime(double startTime);
 	void logEvent(string eventName, json payload, FrameTimestamps frameTimestamps, bool propagate = false, json sourcePacket = json::object());
 private:
 	void processNextPacket(FrameTimestamps frameTimestamps);
@@ -39,19 +40,22 @@ private:
 	static bool replayWorkerHandler(WorkerPoolWorker *worker);
 	string eventFilename;
 	double eventFileStartSeconds;
+	double replayStartTime; //Replay packets from before this time are skipped. Negative means no packets are skipped.
 	Status *status;
 	OutputDriver *outputDriver;
 	FrameServer *frameServer;
+	FrameStatusCheckpoint preprocessCheckpoint;
 
 	Logger *logger;
 
-	ifstream eventFilestream;
+	OutputFrameFileReader *eventReader;
 
 	WorkerPool *replayWorkerPool;
 	SDL_mutex *myMutex;
 	list<EventType> registeredEventTypes;
-	unordered_map<FrameNumber, json> frameEvents;
+	FrameSlotRing<json> frameEvents;
 	unordered_map<FrameNumber, EventLoggerReplayTask> pendingReplayFrames;
+	FrameNumber lastReplayedFrameNumber;
 	bool eventReplay, eventReplayHold;
 	json nextPacket;
 };
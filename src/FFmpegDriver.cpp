@@ -4,6 +4,7 @@
 #include "Utilities.hpp"
 
 #include <exception>
+#include <cstring>
 #include <stdexcept>
 
 using namespace std;
@@ -28,6 +29,8 @@ MediaInputContext::MediaInputContext(void) {
 	audioStreamIndex = -1;
 	audioStream = NULL;
 	demuxerDraining = false;
+	videoPastEndTime = false;
+	audioPastEndTime = false;
 	demuxerThread = NULL;
 	demuxerMutex = NULL;
 	demuxerThreadRunning = false;
@@ -47,7 +50,79 @@ MediaOutputContext::MediaOutputContext(void) {
 	initialized = false;
 }
 
-FFmpegDriver::FFmpegDriver(Status *myStatus, FrameServer *myFrameServer, bool myLowLatency, bool myListAllAvailableOptions) {
+AudioFrameRing::AudioFrameRing(size_t myCapacity, int initialBufferSize) {
+	//Power of two, so slot indices are a mask of the ever-increasing head and tail counters.
+	capacity = 1;
+	while(capacity < myCapacity) {
+		capacity = capacity << 1;
+	}
+	slots = new AudioFrame[capacity];
+	for(size_t i = 0; i < capacity; i++) {
+		if((slots[i].buf = (uint8_t *)av_malloc(initialBufferSize)) == NULL) {
+			throw runtime_error("unable to allocate memory for audio frame");
+		}
+		slots[i].bufferSize = initialBufferSize;
+		slots[i].pos = 0;
+		slots[i].audioSamples = 0;
+		slots[i].audioBytes = 0;
+		slots[i].timestamp = 0.0;
+	}
+	head = 0;
+	tail = 0;
+}
+
+AudioFrameRing::~AudioFrameRing() {
+	for(size_t i = 0; i < capacity; i++) {
+		av_freep(&slots[i].buf);
+	}
+	delete[] slots;
+}
+
+bool AudioFrameRing::pushFrame(uint8_t *buf, int audioSamples, int audioBytes, double timestamp) {
+	size_t myHead = head.load(std::memory_order_relaxed);
+	if(myHead - tail.load(std::memory_order_acquire) >= capacity) {
+		return false;
+	}
+	AudioFrame *slot = &slots[myHead & (capacity - 1)];
+	if(slot->bufferSize < audioBytes) {
+		//Not using realloc because it does not support guaranteed buffer alignment.
+		av_freep(&slot->buf);
+		if((slot->buf = (uint8_t *)av_malloc(audioBytes)) == NULL) {
+			throw runtime_error("unable to allocate memory for audio frame");
+		}
+		slot->bufferSize = audioBytes;
+	}
+	memcpy(slot->buf, buf, audioBytes);
+	slot->pos = 0;
+	slot->audioSamples = audioSamples;
+	slot->audioBytes = audioBytes;
+	slot->timestamp = timestamp;
+	head.store(myHead + 1, std::memory_order_release);
+	return true;
+}
+
+AudioFrame *AudioFrameRing::peekFrame(void) {
+	size_t myTail = tail.load(std::memory_order_relaxed);
+	if(myTail == head.load(std::memory_order_acquire)) {
+		return NULL;
+	}
+	return &slots[myTail & (capacity - 1)];
+}
+
+void AudioFrameRing::popFrame(void) {
+	size_t myTail = tail.load(std::memory_order_relaxed);
+	if(myTail == head.load(std::memory_order_acquire)) {
+		throw logic_error("popFrame() called on an empty AudioFrameRing!");
+	}
+	tail.store(myTail + 1, std::memory_order_release);
+}
+
+size_t AudioFrameRing::size(void) {
+	size_t myTail = tail.load(std::memory_order_acquire);
+	return head.load(std::memory_order_acquire) - myTail;
+}
+
+FFmpegDriver::FFmpegDriver(json config, Status *myStatus, FrameServer *myFrameServer, bool myLowLatency, bool myListAllAvailableOptions) {
 	videoCaptureWorkerPool = NULL;
 	logger = new Logger("FFmpegDriver");
 
@@ -59,9 +134,25 @@ FFmpegDriver::FFmpegDriver(Status *myStatus, FrameServer *myFrameServer, bool my
 	if(frameServer == NULL) {
 		throw invalid_argument("frameServer cannot be NULL");
 	}
+	frameServer->setFFmpegDriver(this);
 	lowLatency = myLowLatency;
 
 	swsContext = NULL;
+	swsDetectionContext = NULL;
+	inputStartTime = -1.0;
+	inputEndTime = -1.0;
+	syntheticVideoFrameRate = 0.0;
+	syntheticVideoNextTimestamp = 0.0;
+	videoDestData[0] = NULL;
+	scalerFlags = resolveScalerFlags(config["YerFace"]["FFmpegDriver"]["scalerQuality"]);
+	detectionScalerFlags = resolveScalerFlags(config["YerFace"]["FFmpegDriver"]["detectionScalerQuality"]);
+	decoderThreadCount = config["YerFace"]["FFmpegDriver"]["decoderThreadCount"];
+	if(decoderThreadCount < 0) {
+		throw invalid_argument("Decoder Thread Count is invalid.");
+	}
+	decoderThreadType = resolveDecoderThreadType(config["YerFace"]["FFmpegDriver"]["decoderThreadType"]);
+	videoDecodeMetrics = new Metrics(config, "FFmpegDriver.VideoDecode");
+	audioDecodeMetrics = new Metrics(config, "FFmpegDriver.AudioDecode");
 	newestVideoFrameTimestamp = -1.0;
 	newestVideoFrameEstimatedEndTimestamp = 0.0;
 	newestAudioFrameTimestamp = -1.0;
@@ -75,24 +166,24 @@ FFmpegDriver::FFmpegDriver(Status *myStatus, FrameServer *myFrameServer, bool my
 	#endif
 	avformat_network_init();
 
-	if((videoFrameBufferMutex = SDL_CreateMutex()) == NULL) {
+	if((videoFrameBufferMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating video frame buffer mutex!");
 	}
-	if((audioFrameHandlersMutex = SDL_CreateMutex()) == NULL) {
+	if((audioFrameHandlersMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating video frame buffer mutex!");
 	}
-	if((videoStreamMutex = SDL_CreateMutex()) == NULL) {
+	if((videoStreamMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
-	if((audioStreamMutex = SDL_CreateMutex()) == NULL) {
+	if((audioStreamMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
 
-	if((videoInContext.demuxerMutex = SDL_CreateMutex()) == NULL) {
+	if((videoInContext.demuxerMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating video demuxer mutex!");
 	}
 	videoInContext.frameNumber = 0;
-	if((audioInContext.demuxerMutex = SDL_CreateMutex()) == NULL) {
+	if((audioInContext.demuxerMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating audio demuxer mutex!");
 	}
 	audioInContext.frameNumber = 0;
@@ -115,10 +206,10 @@ FFmpegDriver::~FFmpegDriver() noexcept(false) {
 	destroyDemuxerThread(&audioInContext);
 	destroyMuxerThread();
 
-	SDL_DestroyMutex(videoFrameBufferMutex);
-	SDL_DestroyMutex(audioFrameHandlersMutex);
-	SDL_DestroyMutex(videoStreamMutex);
-	SDL_DestroyMutex(audioStreamMutex);
+	YerFace_DestroyMutex(videoFrameBufferMutex);
+	YerFace_DestroyMutex(audioFrameHandlersMutex);
+	YerFace_DestroyMutex(videoStreamMutex);
+	YerFace_DestroyMutex(audioStreamMutex);
 	for(MediaInputContext *inputContext : {&videoInContext, &audioInContext}) {
 		string contextName = "UNKNOWN";
 		if(inputContext == &videoInContext) {
@@ -148,6 +239,10 @@ FFmpegDriver::~FFmpegDriver() noexcept(false) {
 		av_frame_free(&backing->frameBGR);
 		// logger->debug3("Calling av_free(backing->buffer)");
 		av_free(backing->buffer);
+		// logger->debug3("Calling av_frame_free(&backing->frameDetection)");
+		av_frame_free(&backing->frameDetection);
+		// logger->debug3("Calling av_free(backing->detectionBuffer)");
+		av_free(backing->detectionBuffer);
 		delete backing;
 	}
 	for(AudioFrameHandler *handler : audioFrameHandlers) {
@@ -167,6 +262,10 @@ FFmpegDriver::~FFmpegDriver() noexcept(false) {
 	}
 	// logger->debug3("Calling sws_freeContext(swsContext)");
 	sws_freeContext(swsContext);
+	// logger->debug3("Calling sws_freeContext(swsDetectionContext)");
+	sws_freeContext(swsDetectionContext);
+	delete videoDecodeMetrics;
+	delete audioDecodeMetrics;
 	delete logger;
 
 	//This helps force the AV logs to flush. (Note the \n at the end of the line.)
@@ -307,10 +406,25 @@ void FFmpegDriver::openInputMedia(string inFile, enum AVMediaType type, string i
 		}
 
 		pixelFormatBacking = AV_PIX_FMT_BGR24;
-		if((swsContext = sws_getContext(width, height, pixelFormat, width, height, pixelFormatBacking, SWS_BICUBIC, NULL, NULL, NULL)) == NULL) {
+		if((swsContext = sws_getContext(width, height, pixelFormat, width, height, pixelFormatBacking, scalerFlags, NULL, NULL, NULL)) == NULL) {
 			throw runtime_error("failed creating software scaling context");
 		}
 
+		//The detection frame is scaled straight from the decoder's output rather than from the full size BGR frame,
+		//so we never have to read the full size BGR frame back out of memory just to shrink it.
+		//For planar YUV inputs, a grayscale detection frame only touches the luma plane.
+		cv::Size detectionSize = frameServer->getDetectionFrameSize(cv::Size(width, height));
+		detectionWidth = detectionSize.width;
+		detectionHeight = detectionSize.height;
+		pixelFormatDetection = frameServer->getDetectionGrayscale() ? AV_PIX_FMT_GRAY8 : AV_PIX_FMT_BGR24;
+		if(detectionWidth <= 0 || detectionHeight <= 0) {
+			throw runtime_error("detection frame size is invalid");
+		}
+		if((swsDetectionContext = sws_getContext(width, height, pixelFormat, detectionWidth, detectionHeight, pixelFormatDetection, detectionScalerFlags, NULL, NULL, NULL)) == NULL) {
+			throw runtime_error("failed creating software scaling context for detection frames");
+		}
+		logger->debug1("Decoding <%dx%d> %s to <%dx%d> %s for display and <%dx%d> %s for detection.", width, height, av_get_pix_fmt_name(pixelFormat), width, height, av_get_pix_fmt_name(pixelFormatBacking), detectionWidth, detectionHeight, av_get_pix_fmt_name(pixelFormatDetection));
+
 		for(int i = 0; i < YERFACE_INITIAL_VIDEO_BACKING_FRAMES; i++) {
 			allocateNewVideoFrameBacking();
 		}
@@ -335,6 +449,40 @@ void FFmpegDriver::openInputMedia(string inFile, enum AVMediaType type, string i
 	}
 }
 
+void FFmpegDriver::openSyntheticVideo(double frameRate) {
+	if(frameRate <= 0.0) {
+		throw invalid_argument("Synthetic video frame rate must be greater than zero.");
+	}
+	if(videoInContext.initialized || audioInContext.videoDecoderContext != NULL) {
+		throw logic_error("Synthetic video cannot be combined with input video.");
+	}
+	if(!audioInContext.initialized || audioInContext.audioStream == NULL) {
+		throw logic_error("Synthetic video needs input audio to follow.");
+	}
+	if(audioInContext.demuxerThread != NULL) {
+		throw logic_error("Synthetic video must be opened before the demuxer threads are running.");
+	}
+	syntheticVideoFrameRate = frameRate;
+
+	//Synthetic frames are small and blank, since nothing will look for faces in them.
+	width = YERFACE_SYNTHETIC_VIDEO_WIDTH;
+	height = YERFACE_SYNTHETIC_VIDEO_HEIGHT;
+	pixelFormat = AV_PIX_FMT_BGR24;
+	pixelFormatBacking = AV_PIX_FMT_BGR24;
+	cv::Size detectionSize = frameServer->getDetectionFrameSize(cv::Size(width, height));
+	detectionWidth = detectionSize.width;
+	detectionHeight = detectionSize.height;
+	pixelFormatDetection = frameServer->getDetectionGrayscale() ? AV_PIX_FMT_GRAY8 : AV_PIX_FMT_BGR24;
+	if(detectionWidth <= 0 || detectionHeight <= 0) {
+		throw runtime_error("detection frame size is invalid");
+	}
+	logger->info("Synthesizing blank <%dx%d> video frames at %.02lf fps to follow the input audio.", width, height, syntheticVideoFrameRate);
+
+	for(int i = 0; i < YERFACE_INITIAL_VIDEO_BACKING_FRAMES; i++) {
+		allocateNewVideoFrameBacking();
+	}
+}
+
 void FFmpegDriver::openOutputMedia(string outFile) {
 	int ret;
 	if(outFile.length() < 1) {
@@ -346,7 +494,7 @@ void FFmpegDriver::openOutputMedia(string outFile) {
 		throw runtime_error("double initialization of media output context!");
 	}
 
-	if((outputContext.multiplexerMutex = SDL_CreateMutex()) == NULL) {
+	if((outputContext.multiplexerMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating multiplexer mutex!");
 	}
 	if((outputContext.multiplexerCond = SDL_CreateCond()) == NULL) {
@@ -443,11 +591,24 @@ void FFmpegDriver::openCodecContext(int *streamIndex, AVCodecContext **decoderCo
 		throw runtime_error("failed to copy codec parameters to decoder context");
 	}
 
+	//Zero threads lets libav pick a thread count based on the number of CPUs.
+	(*decoderContext)->thread_count = decoderThreadCount;
+	(*decoderContext)->thread_type = decoderThreadType;
+
 	av_dict_set(&options, "refcounted_frames", "1", 0);
 	if((ret = avcodec_open2(*decoderContext, decoder, &options)) < 0) {
 		logAVErr("failed to open codec", ret);
 		throw runtime_error("failed to open codec");
 	}
+	string activeThreadType = "none";
+	if((*decoderContext)->active_thread_type == (FF_THREAD_FRAME | FF_THREAD_SLICE)) {
+		activeThreadType = "frame+slice";
+	} else if((*decoderContext)->active_thread_type & FF_THREAD_FRAME) {
+		activeThreadType = "frame";
+	} else if((*decoderContext)->active_thread_type & FF_THREAD_SLICE) {
+		activeThreadType = "slice";
+	}
+	logger->debug1("Opened %s decoder \"%s\" with thread count %d and thread type: %s", av_get_media_type_string(type), decoder->name, (*decoderContext)->thread_count, activeThreadType.c_str());
 
 	*streamIndex = myStreamIndex;
 }
@@ -500,8 +661,32 @@ bool FFmpegDriver::pollForNextVideoFrame(VideoFrame *videoFrame) {
 }
 
 void FFmpegDriver::releaseVideoFrame(VideoFrame videoFrame) {
+	releaseVideoFrameBacking(videoFrame.frameBacking);
+}
+
+void FFmpegDriver::acquireVideoFrameBacking(VideoFrameBacking *backing) {
+	if(backing == NULL) {
+		throw invalid_argument("backing cannot be NULL");
+	}
 	YerFace_MutexLock(videoFrameBufferMutex);
-	videoFrame.frameBacking->inUse = false;
+	if(backing->referenceCount < 1) {
+		YerFace_MutexUnlock(videoFrameBufferMutex);
+		throw logic_error("Tried to acquire a video frame backing which was already returned to the pool!");
+	}
+	backing->referenceCount++;
+	YerFace_MutexUnlock(videoFrameBufferMutex);
+}
+
+void FFmpegDriver::releaseVideoFrameBacking(VideoFrameBacking *backing) {
+	if(backing == NULL) {
+		throw invalid_argument("backing cannot be NULL");
+	}
+	YerFace_MutexLock(videoFrameBufferMutex);
+	if(backing->referenceCount < 1) {
+		YerFace_MutexUnlock(videoFrameBufferMutex);
+		throw logic_error("Tried to release a video frame backing which was already returned to the pool!");
+	}
+	backing->referenceCount--;
 	YerFace_MutexUnlock(videoFrameBufferMutex);
 }
 
@@ -522,15 +707,44 @@ void FFmpegDriver::logAVErr(string msg, int err) {
 	logger->err("%s AVERROR: (%d) %s", msg.c_str(), err, errbuf);
 }
 
+int FFmpegDriver::resolveDecoderThreadType(string threadType) {
+	if(threadType == "auto") {
+		//Frame threading adds a frame of latency per thread, so low latency mode only gets slice threading.
+		return lowLatency ? FF_THREAD_SLICE : (FF_THREAD_FRAME | FF_THREAD_SLICE);
+	} else if(threadType == "frame") {
+		return FF_THREAD_FRAME;
+	} else if(threadType == "slice") {
+		return FF_THREAD_SLICE;
+	} else if(threadType == "frame+slice") {
+		return FF_THREAD_FRAME | FF_THREAD_SLICE;
+	}
+	throw invalid_argument("Decoder thread type must be one of: auto, frame, slice, frame+slice");
+}
+
+int FFmpegDriver::resolveScalerFlags(string scalerQuality) {
+	if(scalerQuality == "fast_bilinear") {
+		return SWS_FAST_BILINEAR;
+	} else if(scalerQuality == "bilinear") {
+		return SWS_BILINEAR;
+	} else if(scalerQuality == "bicubic") {
+		return SWS_BICUBIC;
+	} else if(scalerQuality == "area") {
+		return SWS_AREA;
+	} else if(scalerQuality == "lanczos") {
+		return SWS_LANCZOS;
+	}
+	throw invalid_argument("Scaler quality must be one of: fast_bilinear, bilinear, bicubic, area, lanczos");
+}
+
 VideoFrameBacking *FFmpegDriver::getNextAvailableVideoFrameBacking(void) {
 	YerFace_MutexLock(videoFrameBufferMutex);
 	VideoFrameBacking *myBacking = NULL;
 	unsigned int availableBackings = 0;
 	for(VideoFrameBacking *backing : allocatedVideoFrameBackings) {
-		if(!backing->inUse) {
+		if(backing->referenceCount == 0) {
 			availableBackings++;
 			if(myBacking == NULL) {
-				backing->inUse = true;
+				backing->referenceCount = 1;
 				myBacking = backing;
 			}
 		}
@@ -539,7 +753,7 @@ VideoFrameBacking *FFmpegDriver::getNextAvailableVideoFrameBacking(void) {
 	if(myBacking == NULL) {
 		logger->notice("Out of spare frames in the video frame buffer! Allocating a new one.");
 		myBacking = allocateNewVideoFrameBacking();
-		myBacking->inUse = true;
+		myBacking->referenceCount = 1;
 	}
 	YerFace_MutexUnlock(videoFrameBufferMutex);
 	return myBacking;
@@ -547,7 +761,7 @@ VideoFrameBacking *FFmpegDriver::getNextAvailableVideoFrameBacking(void) {
 
 VideoFrameBacking *FFmpegDriver::allocateNewVideoFrameBacking(void) {
 	VideoFrameBacking *backing = new VideoFrameBacking();
-	backing->inUse = false;
+	backing->referenceCount = 0;
 	if(!(backing->frameBGR = av_frame_alloc())) {
 		throw runtime_error("failed allocating backing video frame");
 	}
@@ -561,6 +775,25 @@ VideoFrameBacking *FFmpegDriver::allocateNewVideoFrameBacking(void) {
 	backing->frameBGR->width = width;
 	backing->frameBGR->height = height;
 	backing->frameBGR->format = pixelFormat;
+
+	if(!(backing->frameDetection = av_frame_alloc())) {
+		throw runtime_error("failed allocating backing detection frame");
+	}
+	bufferSize = av_image_get_buffer_size(pixelFormatDetection, detectionWidth, detectionHeight, 1);
+	if((backing->detectionBuffer = (uint8_t *)av_malloc(bufferSize*sizeof(uint8_t))) == NULL) {
+		throw runtime_error("failed allocating buffer for backing detection frame");
+	}
+	if(av_image_fill_arrays(backing->frameDetection->data, backing->frameDetection->linesize, backing->detectionBuffer, pixelFormatDetection, detectionWidth, detectionHeight, 1) < 0) {
+		throw runtime_error("failed assigning buffer for backing detection frame");
+	}
+	backing->frameDetection->width = detectionWidth;
+	backing->frameDetection->height = detectionHeight;
+	backing->frameDetection->format = pixelFormatDetection;
+	if(syntheticVideoFrameRate > 0.0) {
+		//Nothing ever draws into synthetic frames, so they only need to be blanked once.
+		memset(backing->buffer, 0, av_image_get_buffer_size(pixelFormatBacking, width, height, 1));
+		memset(backing->detectionBuffer, 0, bufferSize);
+	}
 	allocatedVideoFrameBackings.push_front(backing);
 	return backing;
 }
@@ -570,6 +803,7 @@ bool FFmpegDriver::decodePacket(MediaInputContext *inputContext, int streamIndex
 
 	if(inputContext->videoStream != NULL && streamIndex == inputContext->videoStreamIndex) {
 		logger->debug3("Got video %s. Sending to codec...", drain ? "flush call" : "packet");
+		MetricsTick tick = videoDecodeMetrics->startClock();
 		if(avcodec_send_packet(inputContext->videoDecoderContext, drain ? NULL : inputContext->packet) < 0) {
 			logger->err("Error decoding video frame");
 			return false;
@@ -582,22 +816,36 @@ bool FFmpegDriver::decodePacket(MediaInputContext *inputContext, int streamIndex
 				return false;
 			}
 
-			inputContext->frameNumber++;
-
 			VideoFrame videoFrame;
 			videoFrame.timestamp = resolveFrameTimestamp(inputContext, AVMEDIA_TYPE_VIDEO);
-			videoFrame.timestamp.frameNumber = inputContext->frameNumber;
-			videoFrame.frameBacking = getNextAvailableVideoFrameBacking();
-			videoFrame.valid = true;
 
 			YerFace_MutexLock(videoStreamMutex);
 			newestVideoFrameTimestamp = videoFrame.timestamp.startTimestamp;
 			newestVideoFrameEstimatedEndTimestamp = videoFrame.timestamp.estimatedEndTimestamp;
 			YerFace_MutexUnlock(videoStreamMutex);
+
+			//Seeking lands on a keyframe at or before the start time, so there may be frames to discard before we get there.
+			if(inputStartTime >= 0.0 && videoFrame.timestamp.startTimestamp < inputStartTime) {
+				logger->debug4("Discarding VideoFrame at %.04lf because it is before the input start time.", videoFrame.timestamp.startTimestamp);
+				av_frame_unref(inputContext->frame);
+				continue;
+			}
+			if(inputEndTime >= 0.0 && videoFrame.timestamp.startTimestamp >= inputEndTime) {
+				inputContext->videoPastEndTime = true;
+				av_frame_unref(inputContext->frame);
+				continue;
+			}
+
+			inputContext->frameNumber++;
+			videoFrame.timestamp.frameNumber = inputContext->frameNumber;
+			videoFrame.frameBacking = getNextAvailableVideoFrameBacking();
+			videoFrame.valid = true;
 			logger->debug4("Inserted a VideoFrame with timestamps: %.04lf - (estimated) %.04lf", videoFrame.timestamp.startTimestamp, videoFrame.timestamp.estimatedEndTimestamp);
 
 			sws_scale(swsContext, inputContext->frame->data, inputContext->frame->linesize, 0, height, videoFrame.frameBacking->frameBGR->data, videoFrame.frameBacking->frameBGR->linesize);
 			videoFrame.frameCV = Mat(height, width, CV_8UC3, videoFrame.frameBacking->frameBGR->data[0]);
+			sws_scale(swsDetectionContext, inputContext->frame->data, inputContext->frame->linesize, 0, height, videoFrame.frameBacking->frameDetection->data, videoFrame.frameBacking->frameDetection->linesize);
+			videoFrame.detectionFrameCV = Mat(detectionHeight, detectionWidth, pixelFormatDetection == AV_PIX_FMT_GRAY8 ? CV_8UC1 : CV_8UC3, videoFrame.frameBacking->frameDetection->data[0]);
 
 			YerFace_MutexLock(videoFrameBufferMutex);
 			if(lowLatency) {
@@ -616,9 +864,11 @@ bool FFmpegDriver::decodePacket(MediaInputContext *inputContext, int streamIndex
 
 			av_frame_unref(inputContext->frame);
 		}
+		videoDecodeMetrics->endClock(tick);
 	}
 	if(inputContext->audioStream != NULL && streamIndex == inputContext->audioStreamIndex) {
 		logger->debug3("Got audio %s. Sending to codec...", drain ? "flush call" : "packet");
+		MetricsTick tick = audioDecodeMetrics->startClock();
 		if((ret = avcodec_send_packet(inputContext->audioDecoderContext, drain ? NULL : inputContext->packet)) < 0) {
 			logAVErr("Sending packet to audio codec.", ret);
 			return false;
@@ -632,6 +882,16 @@ bool FFmpegDriver::decodePacket(MediaInputContext *inputContext, int streamIndex
 			newestAudioFrameEstimatedEndTimestamp = timestamps.estimatedEndTimestamp;
 			YerFace_MutexUnlock(audioStreamMutex);
 
+			if(inputStartTime >= 0.0 && timestamps.estimatedEndTimestamp <= inputStartTime) {
+				av_frame_unref(inputContext->frame);
+				continue;
+			}
+			if(inputEndTime >= 0.0 && timestamps.startTimestamp >= inputEndTime) {
+				inputContext->audioPastEndTime = true;
+				av_frame_unref(inputContext->frame);
+				continue;
+			}
+
 			YerFace_MutexLock(audioFrameHandlersMutex);
 			for(AudioFrameHandler *handler : audioFrameHandlers) {
 				if(handler->resampler.swrContext == NULL) {
@@ -695,6 +955,7 @@ bool FFmpegDriver::decodePacket(MediaInputContext *inputContext, int streamIndex
 
 			av_frame_unref(inputContext->frame);
 		}
+		audioDecodeMetrics->endClock(tick);
 	}
 
 	return true;
@@ -762,7 +1023,7 @@ void FFmpegDriver::destroyDemuxerThread(MediaInputContext *inputContext) {
 			SDL_WaitThread(inputContext->demuxerThread, NULL);
 		}
 
-		SDL_DestroyMutex(inputContext->demuxerMutex);
+		YerFace_DestroyMutex(inputContext->demuxerMutex);
 	}
 }
 
@@ -796,7 +1057,7 @@ void FFmpegDriver::destroyMuxerThread(void) {
 		logger->err("Multiplexer thread failed to multiplex all of the output packets!");
 	}
 
-	SDL_DestroyMutex(outputContext.multiplexerMutex);
+	YerFace_DestroyMutex(outputContext.multiplexerMutex);
 	SDL_DestroyCond(outputContext.multiplexerCond);
 }
 
@@ -857,7 +1118,7 @@ int FFmpegDriver::innerMuxerLoop(void) {
 
 		//Sleep, waiting for work.
 		if(!didWork) {
-			int result = SDL_CondWaitTimeout(outputContext.multiplexerCond, outputContext.multiplexerMutex, 100);
+			int result = YerFace_CondWaitTimeout(outputContext.multiplexerCond, outputContext.multiplexerMutex, 100);
 			if(result < 0) {
 				throw runtime_error("CondWaitTimeout() failed!");
 			} else if(result == SDL_MUTEX_TIMEDOUT) {
@@ -878,8 +1139,8 @@ int FFmpegDriver::innerMuxerLoop(void) {
 int FFmpegDriver::innerDemuxerLoop(MediaInputContext *inputContext) {
 	bool blockedWarning = false;
 	const char *demuxerName = inputContext == &videoInContext ? "VIDEO" : "AUDIO";
-	bool videoIsMyResponsibility = inputContext->videoStream != NULL;
 	bool audioIsMyResponsibility = inputContext->audioStream != NULL;
+	bool videoIsMyResponsibility = inputContext->videoStream != NULL || (audioIsMyResponsibility && syntheticVideoFrameRate > 0.0);
 
 	YerFace_MutexLock(inputContext->demuxerMutex);
 	while(inputContext->demuxerThreadRunning) {
@@ -948,6 +1209,10 @@ int FFmpegDriver::innerDemuxerLoop(MediaInputContext *inputContext) {
 					// logger->debug3("%s Demuxer Finished pumping AUDIO stream.", demuxerName);
 				}
 
+				if(syntheticVideoFrameRate > 0.0) {
+					synthesizeVideoFrames();
+				}
+
 				flushAudioHandlers(getIsAudioDraining());
 			}
 		}
@@ -1006,11 +1271,16 @@ void FFmpegDriver::pumpDemuxer(MediaInputContext *inputContext, enum AVMediaType
 	inputContext->packet = av_packet_alloc();
 	av_init_packet(inputContext->packet);
 	try {
-		Uint32 readStart = SDL_GetTicks();
-		ret = av_read_frame(inputContext->formatContext, inputContext->packet);
-		Uint32 readEnd = SDL_GetTicks();
-		if(readEnd - readStart > YERFACE_MAX_PUMPTIME && lowLatency) {
-			logger->warning("av_read_frame() %s took longer than expected! (%.04lfs) This will cause all sorts of problems.", type == AVMEDIA_TYPE_VIDEO ? "VIDEO" : "AUDIO", ((double)readEnd - (double)readStart) / (double)1000.0);
+		if(getIsInputPastEndTime(inputContext)) {
+			logger->info("Demuxer thread reached the input end time.");
+			ret = AVERROR_EOF;
+		} else {
+			Uint32 readStart = SDL_GetTicks();
+			ret = av_read_frame(inputContext->formatContext, inputContext->packet);
+			Uint32 readEnd = SDL_GetTicks();
+			if(readEnd - readStart > YERFACE_MAX_PUMPTIME && lowLatency) {
+				logger->warning("av_read_frame() %s took longer than expected! (%.04lfs) This will cause all sorts of problems.", type == AVMEDIA_TYPE_VIDEO ? "VIDEO" : "AUDIO", ((double)readEnd - (double)readStart) / (double)1000.0);
+			}
 		}
 		if(ret < 0) {
 			logger->info("Demuxer thread encountered End of Stream! Going into draining mode...");
@@ -1099,6 +1369,59 @@ void FFmpegDriver::pumpDemuxer(MediaInputContext *inputContext, enum AVMediaType
 	}
 }
 
+void FFmpegDriver::synthesizeVideoFrames(void) {
+	//Frames are only synthesized once the audio they cover has been decoded, so audio handlers get their audio just as promptly
+	//as they would alongside real video, and the demuxer still blocks whenever the pipeline has all of the frame backings.
+	bool audioDraining = getIsAudioDraining();
+	YerFace_MutexLock(audioStreamMutex);
+	double audioEndTimestamp = newestAudioFrameEstimatedEndTimestamp;
+	YerFace_MutexUnlock(audioStreamMutex);
+	if(inputEndTime >= 0.0 && audioEndTimestamp > inputEndTime) {
+		audioEndTimestamp = inputEndTime;
+	}
+	if(syntheticVideoNextTimestamp < inputStartTime) {
+		syntheticVideoNextTimestamp = inputStartTime;
+	}
+
+	double frameDuration = 1.0 / syntheticVideoFrameRate;
+	while(!getIsAllocatedVideoFrameBackingsFull()) {
+		VideoFrame videoFrame;
+		videoFrame.timestamp.startTimestamp = syntheticVideoNextTimestamp;
+		videoFrame.timestamp.estimatedEndTimestamp = syntheticVideoNextTimestamp + frameDuration;
+		//Until the audio is drained, a frame has to wait for all of its audio. After that, any frame which starts before the audio ends is fair game.
+		if(audioDraining ? videoFrame.timestamp.startTimestamp >= audioEndTimestamp : videoFrame.timestamp.estimatedEndTimestamp > audioEndTimestamp) {
+			break;
+		}
+
+		YerFace_MutexLock(videoStreamMutex);
+		newestVideoFrameTimestamp = videoFrame.timestamp.startTimestamp;
+		newestVideoFrameEstimatedEndTimestamp = videoFrame.timestamp.estimatedEndTimestamp;
+		YerFace_MutexUnlock(videoStreamMutex);
+
+		videoInContext.frameNumber++;
+		syntheticVideoNextTimestamp = (double)videoInContext.frameNumber * frameDuration;
+		if(inputStartTime > 0.0) {
+			syntheticVideoNextTimestamp += inputStartTime;
+		}
+		videoFrame.timestamp.frameNumber = videoInContext.frameNumber;
+		videoFrame.frameBacking = getNextAvailableVideoFrameBacking();
+		videoFrame.valid = true;
+		videoFrame.frameCV = Mat(height, width, CV_8UC3, videoFrame.frameBacking->frameBGR->data[0]);
+		videoFrame.detectionFrameCV = Mat(detectionHeight, detectionWidth, pixelFormatDetection == AV_PIX_FMT_GRAY8 ? CV_8UC1 : CV_8UC3, videoFrame.frameBacking->frameDetection->data[0]);
+		logger->debug4("Inserted a synthetic VideoFrame with timestamps: %.04lf - %.04lf", videoFrame.timestamp.startTimestamp, videoFrame.timestamp.estimatedEndTimestamp);
+
+		YerFace_MutexLock(videoFrameBufferMutex);
+		readyVideoFrameBuffer.push_front(videoFrame);
+		YerFace_MutexUnlock(videoFrameBufferMutex);
+	}
+
+	if(audioDraining && syntheticVideoNextTimestamp >= audioEndTimestamp) {
+		YerFace_MutexLock(videoStreamMutex);
+		videoInContext.demuxerDraining = true;
+		YerFace_MutexUnlock(videoStreamMutex);
+	}
+}
+
 bool FFmpegDriver::flushAudioHandlers(bool draining) {
 	bool completelyFlushed = true;
 	YerFace_MutexLock(audioFrameHandlersMutex);
@@ -1211,11 +1534,70 @@ void FFmpegDriver::recursivelyListAllAVOptions(void *obj, string depth) {
 	}
 }
 
+void FFmpegDriver::setInputTimeRange(double startTime, double endTime) {
+	if(startTime < 0.0) {
+		throw invalid_argument("Input start time cannot be negative.");
+	}
+	if(endTime >= 0.0 && endTime <= startTime) {
+		throw invalid_argument("Input end time must be after the input start time.");
+	}
+	if(videoInContext.demuxerThread != NULL || audioInContext.demuxerThread != NULL) {
+		throw logic_error("Input time range must be set before the demuxer threads are running.");
+	}
+	inputStartTime = startTime;
+	inputEndTime = endTime;
+	if(endTime >= 0.0) {
+		logger->info("Processing input from %.04lf to %.04lf seconds.", inputStartTime, inputEndTime);
+	} else {
+		logger->info("Processing input from %.04lf seconds to the end.", inputStartTime);
+	}
+	if(inputStartTime > 0.0) {
+		seekInputContext(&videoInContext);
+		seekInputContext(&audioInContext);
+	}
+}
+
+void FFmpegDriver::seekInputContext(MediaInputContext *inputContext) {
+	int ret;
+	if(!inputContext->initialized) {
+		return;
+	}
+	double formatStartSeconds = 0.0;
+	if(inputContext->formatContext->start_time != AV_NOPTS_VALUE) {
+		formatStartSeconds = (double)inputContext->formatContext->start_time / (double)AV_TIME_BASE;
+	}
+	//Ask for the nearest keyframe at or before the start time. Anything decoded before the start time is discarded in decodePacket().
+	int64_t target = (int64_t)((inputStartTime + formatStartSeconds) * (double)AV_TIME_BASE);
+	if((ret = avformat_seek_file(inputContext->formatContext, -1, INT64_MIN, target, target, 0)) < 0) {
+		logAVErr("Failed seeking input media.", ret);
+		throw runtime_error("Failed seeking input media!");
+	}
+	if(inputContext->videoDecoderContext != NULL) {
+		avcodec_flush_buffers(inputContext->videoDecoderContext);
+	}
+	if(inputContext->audioDecoderContext != NULL) {
+		avcodec_flush_buffers(inputContext->audioDecoderContext);
+	}
+}
+
+bool FFmpegDriver::getIsInputPastEndTime(MediaInputContext *inputContext) {
+	if(inputEndTime < 0.0) {
+		return false;
+	}
+	if(inputContext->videoStream != NULL && !inputContext->videoPastEndTime) {
+		return false;
+	}
+	if(inputContext->audioStream != NULL && !inputContext->audioPastEndTime) {
+		return false;
+	}
+	return true;
+}
+
 bool FFmpegDriver::getIsAllocatedVideoFrameBackingsFull(void) {
 	bool isFull = true;
 	YerFace_MutexLock(videoFrameBufferMutex);
 	for(VideoFrameBacking *backing : allocatedVideoFrameBackings) {
-		if(!backing->inUse) {
+		if(backing->referenceCount == 0) {
 			isFull = false;
 			break;
 		}
@@ -1327,6 +1709,6 @@ void FFmpegDriver::logAVWrapper(int level, const char *fmt, ...) {
 }
 
 Logger *FFmpegDriver::avLogger = new Logger("AVLib");
-SDL_mutex *FFmpegDriver::avLoggerMutex = SDL_CreateMutex();
+SDL_mutex *FFmpegDriver::avLoggerMutex = YerFace_CreateMutex();
 
 }; //namespace YerFace
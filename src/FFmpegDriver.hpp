@@ -2,11 +2,13 @@
 
 #include "Logger.hpp"
 #include "Utilities.hpp"
+#include "Metrics.hpp"
 #include "FrameServer.hpp"
 #include "WorkerPool.hpp"
 
 #include <string>
 #include <list>
+#include <atomic>
 
 extern "C" {
 #include <libavutil/imgutils.h>
@@ -23,6 +25,10 @@ namespace YerFace {
 
 #define YERFACE_FRAME_DURATION_ESTIMATE_BUFFER 10
 #define YERFACE_INITIAL_VIDEO_BACKING_FRAMES 60
+#define YERFACE_SYNTHETIC_VIDEO_WIDTH 320
+#define YERFACE_SYNTHETIC_VIDEO_HEIGHT 180
+#define YERFACE_AUDIO_FRAME_RING_CAPACITY 256
+#define YERFACE_AUDIO_FRAME_RING_INITIAL_BYTES 32768
 #define YERFACE_MAX_PUMPTIME 67 //If a/v stream pumping is taking longer than 1/15th of a second, we may have a hardware problem.
 
 #define YERFACE_AVLOG_LEVELMAP_MIN 0		//Less than this gets dropped.
@@ -76,6 +82,7 @@ public:
 	int64_t audioMuxLastDTS;
 
 	bool demuxerDraining;
+	bool videoPastEndTime, audioPastEndTime; //Set once decoding has passed FFmpegDriver's input end time.
 
 	SDL_mutex *demuxerMutex;
 	SDL_Thread *demuxerThread;
@@ -112,7 +119,9 @@ class VideoFrameBacking {
 public:
 	AVFrame *frameBGR;
 	uint8_t *buffer;
-	bool inUse;
+	AVFrame *frameDetection; //Scaled down (and possibly grayscale) copy for FrameServer's detectionFrame, produced from the same decoded frame.
+	uint8_t *detectionBuffer;
+	int referenceCount; //Backing is available for reuse when this drops to zero. (Protected by videoFrameBufferMutex.)
 };
 
 class VideoFrame {
@@ -121,6 +130,7 @@ public:
 	FrameTimestamps timestamp;
 	VideoFrameBacking *frameBacking;
 	cv::Mat frameCV;
+	cv::Mat detectionFrameCV;
 };
 
 class AudioFrameCallback {
@@ -141,6 +151,36 @@ public:
 	int audioSamples, audioBytes;
 };
 
+//A single slot in an AudioFrameRing.
+class AudioFrame {
+public:
+	uint8_t *buf;
+	int bufferSize;
+	int pos; //Free for the consumer to use, for consumers which drain a frame over several calls.
+	int audioSamples, audioBytes;
+	double timestamp;
+};
+
+//AudioFrameRing is a lock-free single-producer/single-consumer queue of audio frames, for handing audio from our demuxer thread to
+//exactly one consumer thread (such as a real-time audio callback) without either side ever blocking. Slot buffers are allocated up
+//front and reused, and are only reallocated if a frame larger than any the slot has held before arrives. When the ring is full,
+//pushFrame() fails and the producer decides whether to drop the frame or wait.
+class AudioFrameRing {
+public:
+	AudioFrameRing(size_t myCapacity = YERFACE_AUDIO_FRAME_RING_CAPACITY, int initialBufferSize = YERFACE_AUDIO_FRAME_RING_INITIAL_BYTES);
+	~AudioFrameRing();
+	AudioFrameRing(const AudioFrameRing &) = delete;
+	AudioFrameRing &operator=(const AudioFrameRing &) = delete;
+	bool pushFrame(uint8_t *buf, int audioSamples, int audioBytes, double timestamp); //Producer only.
+	AudioFrame *peekFrame(void); //Consumer only. Returns the oldest frame (or NULL) which stays valid until popFrame().
+	void popFrame(void); //Consumer only.
+	size_t size(void);
+private:
+	size_t capacity;
+	AudioFrame *slots;
+	std::atomic<size_t> head, tail; //Head is only advanced by the producer, and tail is only advanced by the consumer.
+};
+
 class AudioFrameResampler {
 public:
 	int numChannels;
@@ -158,10 +198,12 @@ public:
 
 class FFmpegDriver {
 public:
-	FFmpegDriver(Status *myStatus, FrameServer *myFrameServer, bool myLowLatency, bool myListAllAvailableOptions);
+	FFmpegDriver(json config, Status *myStatus, FrameServer *myFrameServer, bool myLowLatency, bool myListAllAvailableOptions);
 	~FFmpegDriver() noexcept(false);
 	void openInputMedia(string inFile, enum AVMediaType type, string inFormat, string inSize, string inChannels, string inRate, string inCodec, string inputAudioChannelMap, bool tryAudio);
 	void openOutputMedia(string outFile);
+	void openSyntheticVideo(double frameRate);
+	void setInputTimeRange(double startTime, double endTime = -1.0);
 	void setVideoCaptureWorkerPool(WorkerPool *workerPool);
 	void rollWorkerThreads(void);
 	bool getIsAudioInputPresent(void);
@@ -169,10 +211,14 @@ public:
 	VideoFrame getNextVideoFrame(void);
 	bool pollForNextVideoFrame(VideoFrame *videoFrame);
 	void releaseVideoFrame(VideoFrame videoFrame);
+	void acquireVideoFrameBacking(VideoFrameBacking *backing);
+	void releaseVideoFrameBacking(VideoFrameBacking *backing);
 	void registerAudioFrameCallback(AudioFrameCallback audioFrameCallback);
 	void stopAudioCallbacksNow(void);
 private:
 	void logAVErr(string msg, int err);
+	int resolveDecoderThreadType(string threadType);
+	int resolveScalerFlags(string scalerQuality);
 	void openCodecContext(int *streamIndex, AVCodecContext **decoderContext, AVFormatContext *myFormatContext, enum AVMediaType type);
 	VideoFrameBacking *getNextAvailableVideoFrameBacking(void);
 	VideoFrameBacking *allocateNewVideoFrameBacking(void);
@@ -184,12 +230,15 @@ private:
 	int innerDemuxerLoop(MediaInputContext *inputContext);
 	int innerMuxerLoop(void);
 	void pumpDemuxer(MediaInputContext *inputContext, enum AVMediaType type);
+	void synthesizeVideoFrames(void);
 	bool flushAudioHandlers(bool draining);
 	bool getIsAudioDraining(void);
 	bool getIsVideoDraining(void);
 	FrameTimestamps resolveFrameTimestamp(MediaInputContext *inputContext, enum AVMediaType type);
 	void recursivelyListAllAVOptions(void *obj, string depth = "-");
 	bool getIsAllocatedVideoFrameBackingsFull(void);
+	void seekInputContext(MediaInputContext *inputContext);
+	bool getIsInputPastEndTime(MediaInputContext *inputContext);
 	int64_t applyPTSOffset(int64_t pts, int64_t offset);
 	static void logAVCallback(void *ptr, int level, const char *fmt, va_list args);
 	static void logAVWrapper(int level, const char *fmt, ...);
@@ -198,6 +247,9 @@ private:
 	FrameServer *frameServer;
 	bool lowLatency;
 	WorkerPool *videoCaptureWorkerPool;
+	int decoderThreadCount;
+	int decoderThreadType;
+	Metrics *videoDecodeMetrics, *audioDecodeMetrics;
 
 	Logger *logger;
 
@@ -209,6 +261,14 @@ private:
 	int width, height;
 	enum AVPixelFormat pixelFormat, pixelFormatBacking;
 	struct SwsContext *swsContext;
+	double inputStartTime, inputEndTime; //Negative means unbounded.
+	double syntheticVideoFrameRate; //Zero unless blank video frames are being synthesized to follow the audio timeline.
+	double syntheticVideoNextTimestamp;
+	int scalerFlags;
+	int detectionWidth, detectionHeight;
+	enum AVPixelFormat pixelFormatDetection;
+	struct SwsContext *swsDetectionContext;
+	int detectionScalerFlags;
 
 	SDL_mutex *videoStreamMutex;
 	double videoStreamTimeBase;
@@ -24,17 +24,102 @@ template <typename SUBNET> using rcon5  = dlib::relu<dlib::affine<con5<45,SUBNET
 
 using FaceDetectionModel = dlib::loss_mmod<dlib::con<1,9,9,1,1,rcon5<rcon5<rcon5<downsampler<dlib::input_rgb_image_pyramid<dlib::pyramid_down<6>>>>>>>>;
 
+class FaceDetectorSharedModel {
+public:
+	FaceDetectorSharedModel(string myFileName);
+	~FaceDetectorSharedModel() noexcept(false);
+	FaceDetectionModel *acquireNetwork(void);
+	void returnNetwork(FaceDetectionModel *network);
+
+	string fileName;
+	size_t fileSize;
+private:
+	const FaceDetectionModel parsedNetwork; //Never evaluated, so it stays a read-only template for the evaluation instances.
+	std::vector<FaceDetectionModel *> idleNetworks; //Evaluation instances not in use by any detection call. Protected by myMutex.
+	size_t totalNetworks;
+	SDL_mutex *myMutex;
+};
+
 class FaceDetectorWorker {
 public:
 	FaceDetector *self;
 
 	dlib::frontal_face_detector frontalFaceDetector;
-	FaceDetectionModel faceDetectionModel;
+
+	//Scratch buffers, reused from frame to frame instead of reallocated. (dlib's detectors still allocate internally.)
+	dlib::matrix<dlib::rgb_pixel> imageMatrix;
+	std::vector<dlib::mmod_rect> detections;
+	std::vector<dlib::matrix<dlib::rgb_pixel>> batchImageMatrices;
+	std::vector<std::vector<dlib::mmod_rect>> batchDetections;
+	std::vector<dlib::rectangle> faces;
+	std::vector<Rect2d> faceBoxes;
+	Mat roiFrame;
+	std::vector<FaceDetectionTask> tasks, staleTasks;
 };
 
-FaceDetector::FaceDetector(json config, Status *myStatus, FrameServer *myFrameServer) {
+static FaceDetectionModel parseFaceDetectionModel(string fileName, size_t *fileSize) {
+	FaceDetectionModel network;
+	MappedFileBuffer modelBuffer(fileName);
+	std::istream modelStream(&modelBuffer);
+	deserialize(network, modelStream);
+	*fileSize = modelBuffer.getSize();
+	return network;
+}
+
+FaceDetectorSharedModel::FaceDetectorSharedModel(string myFileName) : parsedNetwork(parseFaceDetectionModel(myFileName, &fileSize)) {
+	fileName = myFileName;
+	totalNetworks = 0;
+	if((myMutex = SDL_CreateMutex()) == NULL) {
+		throw runtime_error("Failed creating mutex!");
+	}
+}
+
+FaceDetectorSharedModel::~FaceDetectorSharedModel() noexcept(false) {
+	YerFace_MutexLock_Trivial(myMutex);
+	if(idleNetworks.size() != totalNetworks) {
+		throw logic_error("FaceDetectorSharedModel destructing while a detection network is still checked out!");
+	}
+	for(FaceDetectionModel *network : idleNetworks) {
+		delete network;
+	}
+	idleNetworks.clear();
+	YerFace_MutexUnlock_Trivial(myMutex);
+	SDL_DestroyMutex(myMutex);
+}
+
+FaceDetectionModel *FaceDetectorSharedModel::acquireNetwork(void) {
+	//A dlib network keeps its forward pass outputs inside itself, so it can't be evaluated by two threads at once.
+	//Detection calls check out an evaluation instance for just the duration of the call, so we only ever hold as
+	//many instances as there have been simultaneous calls, rather than one per worker thread.
+	YerFace_MutexLock_Trivial(myMutex);
+	if(idleNetworks.size() > 0) {
+		FaceDetectionModel *network = idleNetworks.back();
+		idleNetworks.pop_back();
+		YerFace_MutexUnlock_Trivial(myMutex);
+		return network;
+	}
+	totalNetworks++;
+	idleNetworks.reserve(totalNetworks);
+	YerFace_MutexUnlock_Trivial(myMutex);
+	return new FaceDetectionModel(parsedNetwork);
+}
+
+void FaceDetectorSharedModel::returnNetwork(FaceDetectionModel *network) {
+	YerFace_MutexLock_Trivial(myMutex);
+	idleNetworks.push_back(network);
+	YerFace_MutexUnlock_Trivial(myMutex);
+}
+
+FaceDetectorSharedModel *FaceDetector::cachedModel = NULL;
+
+FaceDetector::FaceDetector(json config, Status *myStatus, FrameServer *myFrameServer, bool myLowLatency) {
 	detectionWorkerPool = NULL;
 	assignmentWorkerPool = NULL;
+	sharedModel = NULL;
+	assignmentLastFrameNumber = -1;
+	assignmentFrameNumber = -1;
+	assignmentLastDetectionRequested = -1;
+	assignmentLastFrameBlockedWarning = -1;
 	status = myStatus;
 	if(status == NULL) {
 		throw invalid_argument("status cannot be NULL");
@@ -43,14 +128,15 @@ FaceDetector::FaceDetector(json config, Status *myStatus, FrameServer *myFrameSe
 	if(frameServer == NULL) {
 		throw invalid_argument("frameServer cannot be NULL");
 	}
+	lowLatency = myLowLatency;
 	logger = new Logger("FaceDetector");
-	if((detectionsMutex = SDL_CreateMutex()) == NULL) {
+	if((detectionsMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
-	if((myMutex = SDL_CreateMutex()) == NULL) {
+	if((myMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
-	if((myAssignmentMutex = SDL_CreateMutex()) == NULL) {
+	if((myAssignmentMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
 	metrics = new Metrics(config, "FaceDetector.Detections");
@@ -65,14 +151,61 @@ FaceDetector::FaceDetector(json config, Status *myStatus, FrameServer *myFrameSe
 		throw invalid_argument("faceBoxSizeAdjustment cannot be less than zero.");
 	}
 
+	regionOfInterestEnabled = config["YerFace"]["FaceDetector"]["regionOfInterest"]["enabled"];
+	regionOfInterestExpansion = config["YerFace"]["FaceDetector"]["regionOfInterest"]["expansion"];
+	if(regionOfInterestExpansion < 1.0) {
+		throw invalid_argument("regionOfInterest expansion cannot be less than one.");
+	}
+	regionOfInterestBoundingBox = config["YerFace"]["FaceDetector"]["regionOfInterest"]["boundingBox"];
+	if(regionOfInterestBoundingBox <= 0) {
+		throw invalid_argument("regionOfInterest boundingBox must be greater than zero.");
+	}
+	trackingAssistedDetection = config["YerFace"]["FaceDetector"]["trackingAssistedDetection"]["enabled"];
+	fullDetectionEveryNFrames = config["YerFace"]["FaceDetector"]["trackingAssistedDetection"]["fullDetectionEveryNFrames"];
+	if(fullDetectionEveryNFrames < 1) {
+		throw invalid_argument("fullDetectionEveryNFrames cannot be less than one.");
+	}
+	landmarkBoxSizeAdjustment = config["YerFace"]["FaceDetector"]["trackingAssistedDetection"]["landmarkBoxSizeAdjustment"];
+	if(landmarkBoxSizeAdjustment <= 0.0) {
+		throw invalid_argument("landmarkBoxSizeAdjustment must be greater than zero.");
+	}
+	framesSinceFullDetection = 0;
+	fullDetectionRequestedFrame = -1;
+	trackerWaitLastFrame = -1;
+	trackerWaitFrames = 0;
+	trackerWaitStartTicks = 0;
+	trackerWaitTotalTicks = 0;
+	detectionBatchSize = config["YerFace"]["FaceDetector"]["dlibFaceDetectorBatchSize"];
+	if(detectionBatchSize < 1) {
+		throw invalid_argument("dlibFaceDetectorBatchSize cannot be less than one.");
+	}
+
 	if(faceDetectionModelFileName.length() > 0) {
 		usingDNNFaceDetection = true;
 	} else {
 		usingDNNFaceDetection = false;
 	}
+	if(usingDNNFaceDetection) {
+		//Parse the model file once here. Detection calls borrow evaluation instances of it from the shared model.
+		//The shared model is kept after we're gone, so a batch worker's next job can skip parsing it.
+		if(cachedModel != NULL && cachedModel->fileName == faceDetectionModelFileName) {
+			logger->debug1("Reusing the face detection model loaded by a previous job.");
+		} else {
+			releaseCachedModels();
+			Uint32 loadStart = SDL_GetTicks();
+			cachedModel = new FaceDetectorSharedModel(faceDetectionModelFileName);
+			logger->debug1("Loaded %lu byte face detection model in %u milliseconds.", cachedModel->fileSize, SDL_GetTicks() - loadStart);
+		}
+		sharedModel = cachedModel;
+	}
+	//Tracking assisted detection only ever needs one frame detected at a time, so there would be nothing to batch.
+	batchDetection = usingDNNFaceDetection && !lowLatency && !trackingAssistedDetection && detectionBatchSize > 1;
 	latestDetection.run = false;
 	latestDetection.set = false;
 	latestDetectionLostWarning = false;
+	trackingHint.set = false;
+	trackingHint.good = false;
+	previousTrackingHint = trackingHint;
 
 	//Hook into the frame lifecycle.
 
@@ -88,7 +221,7 @@ FaceDetector::FaceDetector(json config, Status *myStatus, FrameServer *myFrameSe
 	frameServer->onFrameStatusChangeEvent(frameStatusChangeCallback);
 
 	//We also want to introduce a checkpoint so that frames cannot TRANSITION AWAY from FRAME_STATUS_DETECTION without our blessing.
-	frameServer->registerFrameStatusCheckpoint(FRAME_STATUS_DETECTION, "faceDetector.ran");
+	detectionCheckpoint = frameServer->registerFrameStatusCheckpoint(FRAME_STATUS_DETECTION, "faceDetector.ran");
 
 	WorkerPoolParameters workerPoolParameters;
 	workerPoolParameters.name = "FaceDetector.Detect";
@@ -106,10 +239,10 @@ FaceDetector::FaceDetector(json config, Status *myStatus, FrameServer *myFrameSe
 	workerPoolParameters.initializer = NULL;
 	workerPoolParameters.deinitializer = NULL;
 	workerPoolParameters.usrPtr = (void *)this;
-	workerPoolParameters.handler = assignmentWorkerHandler;
+	workerPoolParameters.handler = NULL; //Assignment passes are submitted as tasks, whenever something they wait on changes.
 	assignmentWorkerPool = new WorkerPool(config, status, frameServer, workerPoolParameters);
 
-	logger->debug1("FaceDetector object constructed with Face Detection Method: %s", usingDNNFaceDetection ? "DNN" : "HOG");
+	logger->debug1("FaceDetector object constructed with Face Detection Method: %s, Tracking Assisted Detection: %s, Batch Size: %d", usingDNNFaceDetection ? "DNN" : "HOG", trackingAssistedDetection ? "ENABLED" : "DISABLED", batchDetection ? detectionBatchSize : 1);
 }
 
 FaceDetector::~FaceDetector() noexcept(false) {
@@ -121,18 +254,32 @@ FaceDetector::~FaceDetector() noexcept(false) {
 	if(assignmentFrameNumbers.size() > 0) {
 		logger->err("Assignment Frames are still pending! Woe is me!");
 	}
+	if(trackerWaitFrames > 0) {
+		//Offline tracking assisted detection serializes each frame's assignment behind FaceTracker's result for the frame before it.
+		logger->info("%d frames waited on FaceTracker for the previous frame, for a total of %u milliseconds.", trackerWaitFrames, trackerWaitTotalTicks);
+	}
 	if(detectionTasks.size() > 0) {
 		logger->err("Detection Tasks are still pending! Woe is me!");
+		for(FaceDetectionTask &task : detectionTasks) {
+			releaseTask(task);
+		}
 	}
 
-	SDL_DestroyMutex(myMutex);
-	SDL_DestroyMutex(myAssignmentMutex);
-	SDL_DestroyMutex(detectionsMutex);
+	YerFace_DestroyMutex(myMutex);
+	YerFace_DestroyMutex(myAssignmentMutex);
+	YerFace_DestroyMutex(detectionsMutex);
 	delete logger;
 	delete assignmentMetrics;
 	delete metrics;
 }
 
+void FaceDetector::releaseCachedModels(void) {
+	if(cachedModel != NULL) {
+		delete cachedModel;
+		cachedModel = NULL;
+	}
+}
+
 FacialDetectionBox FaceDetector::getFacialDetection(FrameNumber frameNumber) {
 	FacialDetectionBox detection;
 	YerFace_MutexLock(detectionsMutex);
@@ -157,38 +304,208 @@ void FaceDetector::renderPreviewHUD(Mat previewFrame, FrameNumber frameNumber, i
 	}
 }
 
-void FaceDetector::doDetectFace(WorkerPoolWorker *workerPoolWorker, FaceDetectionTask task) {
-	FaceDetectorWorker *worker = (FaceDetectorWorker *)workerPoolWorker->ptr;
-	dlib::cv_image<dlib::bgr_pixel> dlibDetectionFrame = cv_image<bgr_pixel>(task.detectionFrame);
-	std::vector<dlib::rectangle> faces;
+void FaceDetector::reportTrackingResult(FrameTimestamps frameTimestamps, const std::vector<cv::Point2d> &landmarks, bool good) {
+	if(!trackingAssistedDetection) {
+		return;
+	}
+	FaceDetectorTrackingHint hint;
+	hint.timestamps = frameTimestamps;
+	hint.set = true;
+	hint.good = good && landmarks.size() > 0;
+	if(hint.good) {
+		double minX = landmarks[0].x, maxX = landmarks[0].x, minY = landmarks[0].y, maxY = landmarks[0].y;
+		for(cv::Point2d landmark : landmarks) {
+			minX = std::min(minX, landmark.x);
+			maxX = std::max(maxX, landmark.x);
+			minY = std::min(minY, landmark.y);
+			maxY = std::max(maxY, landmark.y);
+		}
+		hint.boxNormalSize = Utilities::insetBox(Rect2d(minX, minY, maxX - minX, maxY - minY), landmarkBoxSizeAdjustment);
+	}
+
+	YerFace_MutexLock(detectionsMutex);
+	if(!trackingHint.set || trackingHint.timestamps.frameNumber < hint.timestamps.frameNumber) {
+		previousTrackingHint = trackingHint;
+		trackingHint = hint;
+	}
+	YerFace_MutexUnlock(detectionsMutex);
+
+	//The assignment worker may be waiting on us.
+	if(assignmentWorkerPool != NULL) {
+		assignmentWorkerPool->submitTask(assignmentWorkerTask);
+	}
+}
+
+bool FaceDetector::predictTrackingBox(FrameTimestamps frameTimestamps, cv::Size frameSize, cv::Rect2d *boxNormalSize) {
+	//NOTE: Caller must hold detectionsMutex.
+	if(!trackingHint.set || !trackingHint.good) {
+		return false;
+	}
+	double hintAge = frameTimestamps.startTimestamp - trackingHint.timestamps.startTimestamp;
+	if(hintAge < 0.0 || hintAge > resultGoodForSeconds) {
+		return false;
+	}
+	Rect2d box = trackingHint.boxNormalSize;
+
+	//Extrapolate the face's motion across the last two tracked frames.
+	if(previousTrackingHint.set && previousTrackingHint.good) {
+		double hintInterval = trackingHint.timestamps.startTimestamp - previousTrackingHint.timestamps.startTimestamp;
+		if(hintInterval > 0.0 && hintInterval <= resultGoodForSeconds) {
+			Point2d velocity = (Utilities::centerRect(trackingHint.boxNormalSize) - Utilities::centerRect(previousTrackingHint.boxNormalSize)) / hintInterval;
+			box.x += velocity.x * hintAge;
+			box.y += velocity.y * hintAge;
+		}
+	}
+
+	box = box & Rect2d(0.0, 0.0, frameSize.width, frameSize.height);
+	if(box.area() <= 0.0) {
+		return false;
+	}
+	*boxNormalSize = box;
+	return true;
+}
+
+void FaceDetector::doPrepareRegionOfInterest(WorkingFrame *workingFrame, FaceDetectionTask *task) {
+	task->roiSet = false;
+	if(!regionOfInterestEnabled) {
+		return;
+	}
+
+	YerFace_MutexLock(detectionsMutex);
+	FacialDetectionBox lastDetection = latestDetection;
+	YerFace_MutexUnlock(detectionsMutex);
+	if(!lastDetection.set || task->myFrameTimestamps.startTimestamp - lastDetection.timestamps.startTimestamp > resultGoodForSeconds) {
+		return;
+	}
+
+	Size frameSize = workingFrame->frame.size();
+	Rect2d roi = Utilities::insetBox(lastDetection.boxNormalSize, regionOfInterestExpansion) & Rect2d(0.0, 0.0, frameSize.width, frameSize.height);
+	Rect roiPixels = roi;
+	if(roiPixels.area() <= 0) {
+		return;
+	}
+
+	//Scale the crop to fit the ROI bounding box, but never search at a lower resolution than the full frame would get.
+	double roiScaleFactor = (double)regionOfInterestBoundingBox / (double)std::max(roiPixels.width, roiPixels.height);
+	roiScaleFactor = std::min(1.0, std::max(roiScaleFactor, task->myDetectionScaleFactor));
+
+	//The crop itself is made by the detection worker, into its own scratch buffer.
+	task->roiNormalSize = Rect2d(roiPixels);
+	task->roiScaleFactor = roiScaleFactor;
+	task->roiSet = true;
+}
+
+void FaceDetector::doRunDetector(FaceDetectorWorker *worker, Mat frame, std::vector<Rect2d> &faceBoxes) {
+	//Detection frames may arrive as grayscale (see FrameServer detectionGrayscale) which saves HOG a color conversion.
+	bool grayscale = frame.channels() == 1;
+	worker->faces.clear();
 
 	if(usingDNNFaceDetection) {
 		//Using dlib's CNN-based face detector which can (optimistically) be pushed out to the GPU
-		dlib::matrix<dlib::rgb_pixel> imageMatrix;
-		dlib::assign_image(imageMatrix, dlibDetectionFrame);
-		std::vector<dlib::mmod_rect> detections = worker->faceDetectionModel(imageMatrix);
-		for(dlib::mmod_rect detection : detections) {
-			faces.push_back(detection.rect);
+		//NOTE: assign_image() only reallocates imageMatrix when the frame size changes.
+		if(grayscale) {
+			dlib::assign_image(worker->imageMatrix, cv_image<unsigned char>(frame));
+		} else {
+			dlib::assign_image(worker->imageMatrix, cv_image<bgr_pixel>(frame));
+		}
+		FaceDetectionModel *network = sharedModel->acquireNetwork();
+		(*network)(&worker->imageMatrix, &worker->imageMatrix + 1, &worker->detections);
+		sharedModel->returnNetwork(network);
+		for(dlib::mmod_rect &detection : worker->detections) {
+			worker->faces.push_back(detection.rect);
 		}
 	} else {
 		//Using dlib's built-in HOG face detector instead of a CNN-based detector
-		faces = worker->frontalFaceDetector(dlibDetectionFrame);
+		if(grayscale) {
+			worker->faces = worker->frontalFaceDetector(cv_image<unsigned char>(frame));
+		} else {
+			worker->faces = worker->frontalFaceDetector(cv_image<bgr_pixel>(frame));
+		}
 	}
 
+	faceBoxes.clear();
+	for(dlib::rectangle &face : worker->faces) {
+		faceBoxes.push_back(Rect2d(face.left(), face.top(), face.right() - face.left(), face.bottom() - face.top()));
+	}
+}
+
+void FaceDetector::doDetectFace(WorkerPoolWorker *workerPoolWorker, FaceDetectionTask task) {
+	FaceDetectorWorker *worker = (FaceDetectorWorker *)workerPoolWorker->ptr;
+	std::vector<Rect2d> &faceBoxes = worker->faceBoxes;
+	faceBoxes.clear();
+
+	if(task.roiSet) {
+		//Search around where the face was last seen, then map the results back into detectionFrame coordinates.
+		resize(task.frame(Rect(task.roiNormalSize)), worker->roiFrame, Size(), task.roiScaleFactor, task.roiScaleFactor);
+		doRunDetector(worker, worker->roiFrame, faceBoxes);
+		for(Rect2d &face : faceBoxes) {
+			face = Utilities::scaleRect(face, 1.0 / task.roiScaleFactor);
+			face.x += task.roiNormalSize.x;
+			face.y += task.roiNormalSize.y;
+			face = Utilities::scaleRect(face, task.myDetectionScaleFactor);
+		}
+		if(faceBoxes.size() == 0) {
+			logger->debug3("Region of interest search missed on frame #" YERFACE_FRAMENUMBER_FORMAT ". Falling back to the full frame.", task.myFrameNumber);
+		}
+	}
+	if(faceBoxes.size() == 0) {
+		doRunDetector(worker, task.detectionFrame, faceBoxes);
+	}
+
+	recordDetection(workerPoolWorker, task, faceBoxes);
+	releaseTask(task);
+}
+
+void FaceDetector::doDetectFaceBatch(WorkerPoolWorker *workerPoolWorker, std::vector<FaceDetectionTask> &tasks) {
+	FaceDetectorWorker *worker = (FaceDetectorWorker *)workerPoolWorker->ptr;
+
+	//The CNN evaluates the whole batch in a single pass, but every image in the batch must be the same size.
+	if(worker->batchImageMatrices.size() < tasks.size()) {
+		worker->batchImageMatrices.resize(tasks.size());
+		worker->batchDetections.resize(tasks.size());
+	}
+	for(size_t i = 0; i < tasks.size(); i++) {
+		if(tasks[i].detectionFrame.channels() == 1) {
+			dlib::assign_image(worker->batchImageMatrices[i], cv_image<unsigned char>(tasks[i].detectionFrame));
+		} else {
+			dlib::assign_image(worker->batchImageMatrices[i], cv_image<bgr_pixel>(tasks[i].detectionFrame));
+		}
+	}
+	FaceDetectionModel *network = sharedModel->acquireNetwork();
+	(*network)(worker->batchImageMatrices.begin(), worker->batchImageMatrices.begin() + tasks.size(), worker->batchDetections.begin());
+	sharedModel->returnNetwork(network);
+
+	std::vector<Rect2d> &faceBoxes = worker->faceBoxes;
+	for(size_t i = 0; i < tasks.size(); i++) {
+		faceBoxes.clear();
+		for(dlib::mmod_rect &detection : worker->batchDetections[i]) {
+			faceBoxes.push_back(Rect2d(detection.rect.left(), detection.rect.top(), detection.rect.right() - detection.rect.left(), detection.rect.bottom() - detection.rect.top()));
+		}
+		recordDetection(workerPoolWorker, tasks[i], faceBoxes);
+		releaseTask(tasks[i]);
+	}
+}
+
+void FaceDetector::releaseTask(FaceDetectionTask &task) {
+	task.frame.release();
+	task.detectionFrame.release();
+	if(task.frameBacking != NULL) {
+		frameServer->releaseFrameBackingLease(task.frameBacking);
+		task.frameBacking = NULL;
+	}
+}
+
+void FaceDetector::recordDetection(WorkerPoolWorker *workerPoolWorker, FaceDetectionTask task, std::vector<Rect2d> &faces) {
 	bool bestFaceSet = false;
-	int bestFaceArea = -1;
+	double bestFaceArea = -1.0;
 	Size2d detectionFrameSize = task.detectionFrame.size();
 	Rect2d detectionFrameBox = Rect2d(0.0, 0.0, detectionFrameSize.width, detectionFrameSize.height);
 	Rect2d bestFaceBox, bestFaceBoxNormalSize;
-	for(dlib::rectangle face : faces) {
-		if((int)face.area() > bestFaceArea) {
+	for(Rect2d face : faces) {
+		if(face.area() > bestFaceArea) {
 			bestFaceSet = true;
 			bestFaceArea = face.area();
-			bestFaceBox.x = face.left();
-			bestFaceBox.y = face.top();
-			bestFaceBox.width = face.right() - bestFaceBox.x;
-			bestFaceBox.height = face.bottom() - bestFaceBox.y;
-			bestFaceBox = Utilities::insetBox(bestFaceBox, faceBoxSizeAdjustment) & detectionFrameBox;
+			bestFaceBox = Utilities::insetBox(face, faceBoxSizeAdjustment) & detectionFrameBox;
 			bestFaceBoxNormalSize = Utilities::scaleRect(bestFaceBox, 1.0 / task.myDetectionScaleFactor);
 		}
 	}
@@ -206,6 +523,14 @@ void FaceDetector::doDetectFace(WorkerPoolWorker *workerPoolWorker, FaceDetectio
 
 	bool resultUsed = false;
 	YerFace_MutexLock(detectionsMutex);
+	if(batchDetection) {
+		//Every frame gets its own detection, and the assignment worker is waiting for exactly this one.
+		FacialDetectionBox *frameDetection = detections.find(detection.timestamps.frameNumber);
+		if(frameDetection != NULL) {
+			*frameDetection = detection;
+			resultUsed = true;
+		}
+	}
 	if(!latestDetection.run || latestDetection.timestamps.startTimestamp < detection.timestamps.startTimestamp) {
 		latestDetection = detection;
 		resultUsed = true;
@@ -221,7 +546,7 @@ void FaceDetector::doDetectFace(WorkerPoolWorker *workerPoolWorker, FaceDetectio
 	YerFace_MutexUnlock(detectionsMutex);
 
 	if(resultUsed && assignmentWorkerPool != NULL) {
-		assignmentWorkerPool->sendWorkerSignal();
+		assignmentWorkerPool->submitTask(assignmentWorkerTask);
 	} else {
 		logger->notice("Detection performed, but it was of no use!");
 	}
@@ -249,12 +574,30 @@ void FaceDetector::handleFrameStatusChange(void *userdata, WorkingFrameStatus ne
 			YerFace_MutexUnlock(self->myAssignmentMutex);
 			break;
 		case FRAME_STATUS_DETECTION:
+			if(self->batchDetection) {
+				//No need to clone the detection frame, because this frame can't leave FRAME_STATUS_DETECTION until the detection is finished.
+				WorkingFrame *workingFrame = self->frameServer->getWorkingFrame(frameNumber);
+				FaceDetectionTask task;
+				task.myFrameNumber = frameNumber;
+				task.myFrameTimestamps = frameTimestamps;
+				task.myDetectionScaleFactor = workingFrame->detectionScaleFactor;
+				task.frameBacking = NULL;
+				task.frame = workingFrame->frame;
+				task.detectionFrame = workingFrame->detectionFrame;
+				task.roiSet = false;
+				YerFace_MutexLock(self->myMutex);
+				self->detectionTasks.push_back(task);
+				YerFace_MutexUnlock(self->myMutex);
+				if(self->detectionWorkerPool != NULL) {
+					self->detectionWorkerPool->sendWorkerSignal();
+				}
+			}
 			YerFace_MutexLock(self->myAssignmentMutex);
 			self->assignmentFrameNumbers[frameNumber].readyForAssignment = true;
 			self->logger->debug4("handleFrameStatusChange() Frame #" YERFACE_FRAMENUMBER_FORMAT " waiting on me. Queue depth is now %lu", frameNumber, self->assignmentFrameNumbers.size());
 			YerFace_MutexUnlock(self->myAssignmentMutex);
 			if(self->assignmentWorkerPool != NULL) {
-				self->assignmentWorkerPool->sendWorkerSignal();
+				self->assignmentWorkerPool->submitTask(assignmentWorkerTask);
 			}
 			break;
 		case FRAME_STATUS_GONE:
@@ -269,9 +612,11 @@ void FaceDetector::detectionWorkerInitializer(WorkerPoolWorker *worker, void *pt
 	FaceDetector *self = (FaceDetector *)ptr;
 	FaceDetectorWorker *innerWorker = new FaceDetectorWorker();
 	innerWorker->self = self;
-	if(self->usingDNNFaceDetection) {
-		deserialize(self->faceDetectionModelFileName.c_str()) >> innerWorker->faceDetectionModel;
-	} else {
+	if(self->batchDetection) {
+		innerWorker->batchImageMatrices.resize(self->detectionBatchSize);
+		innerWorker->batchDetections.resize(self->detectionBatchSize);
+	}
+	if(!self->usingDNNFaceDetection) {
 		innerWorker->frontalFaceDetector = get_frontal_face_detector();
 	}
 	worker->ptr = (void *)innerWorker;
@@ -283,25 +628,44 @@ bool FaceDetector::detectionWorkerHandler(WorkerPoolWorker *worker) {
 	bool didWork = false;
 
 	//// CHECK FOR WORK ////
-	bool taskSet = false;
-	FaceDetectionTask task;
+	std::vector<FaceDetectionTask> &tasks = innerWorker->tasks;
+	std::vector<FaceDetectionTask> &staleTasks = innerWorker->staleTasks;
+	tasks.clear();
 	YerFace_MutexLock(self->myMutex);
-	if(self->detectionTasks.size() > 0) {
-		taskSet = true;
+	if(self->batchDetection) {
+		//In batch mode detectionTasks is a FIFO queue. Take as many same-sized frames off the front as will fit in a batch.
+		while(tasks.size() < self->detectionTasks.size() && tasks.size() < (size_t)self->detectionBatchSize) {
+			if(tasks.size() > 0 && self->detectionTasks[tasks.size()].detectionFrame.size() != tasks.front().detectionFrame.size()) {
+				break;
+			}
+			tasks.push_back(self->detectionTasks[tasks.size()]);
+		}
+		self->detectionTasks.erase(self->detectionTasks.begin(), self->detectionTasks.begin() + tasks.size());
+	} else if(self->detectionTasks.size() > 0) {
 		//Operate on the back of detectionTasks (not a FIFO queue!) because the most recent detection task is always the most urgent.
-		task = self->detectionTasks.back();
-		self->detectionTasks.clear();
+		tasks.push_back(self->detectionTasks.back());
+		self->detectionTasks.pop_back();
+		//Swapping keeps both buffers, so neither side has to grow again next time.
+		staleTasks.swap(self->detectionTasks);
 	}
 	YerFace_MutexUnlock(self->myMutex);
+	for(FaceDetectionTask &task : staleTasks) {
+		self->releaseTask(task);
+	}
+	staleTasks.clear();
 
 	//// DO THE WORK ////
-	if(taskSet) {
-		self->logger->debug4("Thread #%d handling frame #" YERFACE_FRAMENUMBER_FORMAT, worker->num, task.myFrameNumber);
+	if(tasks.size() > 0) {
+		self->logger->debug4("Thread #%d handling frame #" YERFACE_FRAMENUMBER_FORMAT " (Batch of %lu)", worker->num, tasks.front().myFrameNumber, tasks.size());
 		MetricsTick tick = self->metrics->startClock();
 
-		// self->logger->verbose("Thread #%d, Frame #" YERFACE_FRAMENUMBER_FORMAT " - RUNNING Detection", worker->num, task.myFrameNumber);
-		self->doDetectFace(worker, task);
-		// self->logger->verbose("Thread #%d, Frame #" YERFACE_FRAMENUMBER_FORMAT " - FINISHED Detection", worker->num, task.myFrameNumber);
+		// self->logger->verbose("Thread #%d, Frame #" YERFACE_FRAMENUMBER_FORMAT " - RUNNING Detection", worker->num, tasks.front().myFrameNumber);
+		if(tasks.size() > 1) {
+			self->doDetectFaceBatch(worker, tasks);
+		} else {
+			self->doDetectFace(worker, tasks.front());
+		}
+		// self->logger->verbose("Thread #%d, Frame #" YERFACE_FRAMENUMBER_FORMAT " - FINISHED Detection", worker->num, tasks.front().myFrameNumber);
 
 		self->metrics->endClock(tick);
 		didWork = true;
@@ -309,15 +673,20 @@ bool FaceDetector::detectionWorkerHandler(WorkerPoolWorker *worker) {
 	return didWork;
 }
 
+void FaceDetector::assignmentWorkerTask(WorkerPoolWorker *worker) {
+	//Submitted whenever a frame arrives, a detection lands, or FaceTracker reports back. Assign as far as we can get.
+	while(assignmentWorkerHandler(worker));
+}
+
 bool FaceDetector::assignmentWorkerHandler(WorkerPoolWorker *worker) {
 	FaceDetector *self = (FaceDetector *)worker->ptr;
 	bool didWork = false;
 
-	static FrameNumber lastFrameNumber = -1;
-	static FrameNumber myFrameNumber = -1;
-	static FrameNumber lastDetectionRequested = -1;
-	static FrameNumber lastFrameBlockedWarning = -1;
-	static MetricsTick tick;
+	FrameNumber &lastFrameNumber = self->assignmentLastFrameNumber;
+	FrameNumber &myFrameNumber = self->assignmentFrameNumber;
+	FrameNumber &lastDetectionRequested = self->assignmentLastDetectionRequested;
+	FrameNumber &lastFrameBlockedWarning = self->assignmentLastFrameBlockedWarning;
+	MetricsTick &tick = self->assignmentTick;
 
 	YerFace_MutexLock(self->myAssignmentMutex);
 	//// CHECK FOR WORK ////
@@ -349,25 +718,77 @@ bool FaceDetector::assignmentWorkerHandler(WorkerPoolWorker *worker) {
 		FrameTimestamps myFrameTimestamps = workingFrame->frameTimestamps;
 
 		bool frameAssigned = false;
+		bool detectionRequestNeeded = true;
+		bool waitingOnTracker = false;
 		YerFace_MutexLock(self->detectionsMutex);
-		if(self->latestDetection.run) {
+		if(self->batchDetection) {
+			//This frame's detection was queued when it entered FRAME_STATUS_DETECTION. We just wait for it to land.
+			FacialDetectionBox *frameDetection = self->detections.find(myFrameNumber);
+			if(frameDetection != NULL && frameDetection->run) {
+				frameAssigned = true;
+			}
+			detectionRequestNeeded = false;
+		}
+		//Between full detections, reuse the box FaceTracker's landmarks gave us for the previous frame.
+		//In low latency mode a due full detection runs in the background, and we carry on with tracked boxes until
+		//the detection for that frame (or a later one) lands, rather than falling back on an older detection.
+		bool fullDetectionDue = self->framesSinceFullDetection >= self->fullDetectionEveryNFrames;
+		bool fullDetectionPending = self->fullDetectionRequestedFrame >= 0 && (!self->latestDetection.run || self->latestDetection.timestamps.frameNumber < self->fullDetectionRequestedFrame);
+		if(self->trackingAssistedDetection && self->framesSinceFullDetection > 0 && (!fullDetectionDue || (self->lowLatency && (self->fullDetectionRequestedFrame < 0 || fullDetectionPending)))) {
+			Rect2d trackedBox;
+			if(!self->lowLatency && (!self->trackingHint.set || self->trackingHint.timestamps.frameNumber < myFrameNumber - 1)) {
+				//Offline, we can afford to wait for the tracker to finish with the previous frame.
+				//NOTE: This means each frame's assignment waits on the previous frame's landmarks, so detection and tracking don't overlap.
+				waitingOnTracker = true;
+			} else if(self->predictTrackingBox(myFrameTimestamps, workingFrame->frame.size(), &trackedBox)) {
+				FacialDetectionBox detection;
+				detection.timestamps = myFrameTimestamps;
+				detection.run = false;
+				detection.set = true;
+				detection.boxNormalSize = trackedBox;
+				detection.box = Utilities::scaleRect(trackedBox, workingFrame->detectionScaleFactor);
+				self->detections[myFrameNumber] = detection;
+				self->framesSinceFullDetection++;
+				frameAssigned = true;
+				detectionRequestNeeded = false;
+				if(fullDetectionDue && self->fullDetectionRequestedFrame < 0) {
+					self->fullDetectionRequestedFrame = myFrameNumber;
+					detectionRequestNeeded = true;
+				}
+			}
+		}
+		if(!frameAssigned && !waitingOnTracker && !self->batchDetection && self->latestDetection.run) {
 			double latestDetectionUsableUntil = self->latestDetection.timestamps.startTimestamp + self->resultGoodForSeconds;
-			if(myFrameTimestamps.startTimestamp <= latestDetectionUsableUntil) {
+			//Offline, a tracking assisted full detection must come from this very frame.
+			bool latestDetectionCurrent = self->lowLatency || !self->trackingAssistedDetection || self->latestDetection.timestamps.frameNumber >= myFrameNumber;
+			if(myFrameTimestamps.startTimestamp <= latestDetectionUsableUntil && latestDetectionCurrent) {
 				self->detections[myFrameNumber] = self->latestDetection;
 				frameAssigned = true;
+				self->framesSinceFullDetection = self->latestDetection.set ? 1 : 0;
+				self->fullDetectionRequestedFrame = -1;
 				// self->logger->verbose("==== SUCCESSFUL ASSIGNMENT ON FRAME #" YERFACE_FRAMENUMBER_FORMAT " (LD Frame #" YERFACE_FRAMENUMBER_FORMAT ")", myFrameNumber, self->latestDetection.timestamps.frameNumber);
 			}
 		}
+		if(!frameAssigned && !waitingOnTracker) {
+			//Tracking was lost, or it's time for a full detection. Either way, start counting over.
+			self->framesSinceFullDetection = 0;
+		}
 		YerFace_MutexUnlock(self->detectionsMutex);
 
-		if(myFrameNumber != lastDetectionRequested) {
+		if(detectionRequestNeeded && !waitingOnTracker && myFrameNumber != lastDetectionRequested) {
 			// self->logger->verbose("==== REQUESTING A DETECTION ON FRAME #" YERFACE_FRAMENUMBER_FORMAT, myFrameNumber);
 			lastDetectionRequested = myFrameNumber;
 			FaceDetectionTask task;
 			task.myFrameNumber = myFrameNumber;
 			task.myFrameTimestamps = myFrameTimestamps;
 			task.myDetectionScaleFactor = workingFrame->detectionScaleFactor;
-			task.detectionFrame = workingFrame->detectionFrame.clone();
+			//The frame may move on before the detection runs, so hold a lease on its backing instead of copying it.
+			YerFace_AllocationCheckBegin(taskAllocations);
+			task.frameBacking = self->frameServer->leaseFrameBacking(workingFrame);
+			task.frame = workingFrame->frame;
+			task.detectionFrame = workingFrame->detectionFrame;
+			self->doPrepareRegionOfInterest(workingFrame, &task);
+			YerFace_AllocationCheckEnd(self->logger, taskAllocations, "Detection task preparation");
 			YerFace_MutexLock(self->myMutex);
 			self->detectionTasks.push_back(task);
 			YerFace_MutexUnlock(self->myMutex);
@@ -377,11 +798,23 @@ bool FaceDetector::assignmentWorkerHandler(WorkerPoolWorker *worker) {
 		}
 
 		if(frameAssigned) {
+			if(self->trackerWaitLastFrame == myFrameNumber) {
+				self->trackerWaitTotalTicks += SDL_GetTicks() - self->trackerWaitStartTicks;
+			}
 			lastFrameNumber = myFrameNumber;
-			self->frameServer->setWorkingFrameStatusCheckpoint(myFrameNumber, FRAME_STATUS_DETECTION, "faceDetector.ran");
+			self->frameServer->setWorkingFrameStatusCheckpoint(myFrameNumber, FRAME_STATUS_DETECTION, self->detectionCheckpoint);
 			self->assignmentMetrics->endClock(tick);
 			myFrameNumber = -1;
 			didWork = true;
+		} else if(waitingOnTracker) {
+			self->logger->debug4("Frame #" YERFACE_FRAMENUMBER_FORMAT " is waiting on FaceTracker results for the previous frame.", myFrameNumber);
+			if(self->trackerWaitLastFrame != myFrameNumber) {
+				self->trackerWaitLastFrame = myFrameNumber;
+				self->trackerWaitFrames++;
+				self->trackerWaitStartTicks = SDL_GetTicks();
+			}
+		} else if(self->batchDetection) {
+			self->logger->debug4("Frame #" YERFACE_FRAMENUMBER_FORMAT " is waiting on its batched detection.", myFrameNumber);
 		} else {
 			if(lastFrameBlockedWarning != myFrameNumber) {
 				self->logger->warning("Uh-oh! We are blocked on a Face Detection Task for frame #" YERFACE_FRAMENUMBER_FORMAT ". If this happens a lot, consider some tuning.", myFrameNumber);
@@ -12,12 +12,19 @@ using namespace std;
 
 namespace YerFace {
 
+class FaceDetectorSharedModel;
+
 class FaceDetectionTask {
 public:
 	FrameNumber myFrameNumber;
 	FrameTimestamps myFrameTimestamps;
 	double myDetectionScaleFactor;
-	cv::Mat detectionFrame;
+	VideoFrameBacking *frameBacking; //Our lease on the frame's backing, if the frame might move on before we're done with it. Otherwise NULL.
+	cv::Mat frame; //Native resolution view into the frame backing. (READ ONLY.)
+	cv::Mat detectionFrame; //View into the frame backing. (READ ONLY.)
+	bool roiSet; //Should we search around roiNormalSize before falling back to detectionFrame?
+	cv::Rect2d roiNormalSize; //The region of the native resolution frame around the last known face location.
+	double roiScaleFactor; //The crop is scaled by this much before searching, usually to a higher resolution than detectionFrame.
 };
 
 class FaceDetectorWorker;
@@ -31,6 +38,14 @@ public:
 	bool set; //Is the box valid?
 };
 
+class FaceDetectorTrackingHint {
+public:
+	cv::Rect2d boxNormalSize; //Bounding box of the landmarks found by FaceTracker, at the native resolution of the frame.
+	FrameTimestamps timestamps; //The timestamp (including frame number) to which these landmarks belong.
+	bool good; //Did FaceTracker trust this result? (All landmarks found, and the pose was not rejected.)
+	bool set;
+};
+
 class FaceDetectorAssignmentTask {
 public:
 	FrameNumber frameNumber;
@@ -39,24 +54,52 @@ public:
 
 class FaceDetector {
 public:
-	FaceDetector(json config, Status *myStatus, FrameServer *myFrameServer);
+	FaceDetector(json config, Status *myStatus, FrameServer *myFrameServer, bool myLowLatency);
 	~FaceDetector() noexcept(false);
 	FacialDetectionBox getFacialDetection(FrameNumber frameNumber);
 	void renderPreviewHUD(cv::Mat previewFrame, FrameNumber frameNumber, int density, bool mirrorMode);
+	void reportTrackingResult(FrameTimestamps frameTimestamps, const std::vector<cv::Point2d> &landmarks, bool good);
+	static void releaseCachedModels(void);
 private:
+	bool predictTrackingBox(FrameTimestamps frameTimestamps, cv::Size frameSize, cv::Rect2d *boxNormalSize);
+	void doPrepareRegionOfInterest(WorkingFrame *workingFrame, FaceDetectionTask *task);
+	void doRunDetector(FaceDetectorWorker *worker, cv::Mat frame, std::vector<cv::Rect2d> &faceBoxes);
 	void doDetectFace(WorkerPoolWorker *worker, FaceDetectionTask task);
+	void doDetectFaceBatch(WorkerPoolWorker *worker, std::vector<FaceDetectionTask> &tasks);
+	void recordDetection(WorkerPoolWorker *worker, FaceDetectionTask task, std::vector<cv::Rect2d> &faces);
+	void releaseTask(FaceDetectionTask &task);
 	static void handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps);
 	static void detectionWorkerInitializer(WorkerPoolWorker *worker, void *ptr);
 	static bool detectionWorkerHandler(WorkerPoolWorker *worker);
 	static bool assignmentWorkerHandler(WorkerPoolWorker *worker);
+	static void assignmentWorkerTask(WorkerPoolWorker *worker);
 
 	string faceDetectionModelFileName;
+	FaceDetectorSharedModel *sharedModel; //Deserialized once. Lends detection calls an evaluation instance of the network.
+	static FaceDetectorSharedModel *cachedModel; //Owns sharedModel, and outlives us. Only one FaceDetector may exist at a time.
 	double resultGoodForSeconds, faceBoxSizeAdjustment;
 
 	bool usingDNNFaceDetection;
+	bool lowLatency;
+	int detectionBatchSize;
+	bool batchDetection; //Offline only. Every frame is queued for its own detection, and the CNN runs them in batches.
+
+	bool regionOfInterestEnabled;
+	double regionOfInterestExpansion;
+	int regionOfInterestBoundingBox;
+
+	bool trackingAssistedDetection;
+	int fullDetectionEveryNFrames;
+	double landmarkBoxSizeAdjustment;
+	int framesSinceFullDetection; //Only touched by the assignment worker.
+	FrameNumber fullDetectionRequestedFrame; //Low latency only. The due full detection we are carrying on with tracked boxes until, or -1.
+	FrameNumber trackerWaitLastFrame; //Offline only. Last frame which had to wait on FaceTracker for the previous frame.
+	int trackerWaitFrames;
+	Uint32 trackerWaitStartTicks, trackerWaitTotalTicks;
 
 	Status *status;
 	FrameServer *frameServer;
+	FrameStatusCheckpoint detectionCheckpoint;
 
 	Metrics *metrics, *assignmentMetrics;
 
@@ -65,15 +108,19 @@ private:
 	Logger *logger;
 	
 	SDL_mutex *myMutex;
-	list<FaceDetectionTask> detectionTasks;
+	std::vector<FaceDetectionTask> detectionTasks; //A vector rather than a list, so queueing a task doesn't allocate once it has grown.
 
 	SDL_mutex *detectionsMutex;
-	unordered_map<FrameNumber, FacialDetectionBox> detections;
+	FrameSlotRing<FacialDetectionBox> detections;
 	FacialDetectionBox latestDetection;
 	bool latestDetectionLostWarning;
+	FaceDetectorTrackingHint trackingHint, previousTrackingHint;
 
 	SDL_mutex *myAssignmentMutex;
 	unordered_map<FrameNumber, FaceDetectorAssignmentTask> assignmentFrameNumbers;
+	FrameNumber assignmentLastFrameNumber, assignmentFrameNumber;
+	FrameNumber assignmentLastDetectionRequested, assignmentLastFrameBlockedWarning;
+	MetricsTick assignmentTick;
 
 	WorkerPool *detectionWorkerPool, *assignmentWorkerPool;
 };
@@ -12,6 +12,7 @@ namespace YerFace {
 
 FaceMapper::FaceMapper(json config, Status *myStatus, FrameServer *myFrameServer, FaceTracker *myFaceTracker, PreviewHUD *myPreviewHUD) {
 	workerPool = NULL;
+	lastFrameNumber = -1;
 	status = myStatus;
 	if(status == NULL) {
 		throw invalid_argument("status cannot be NULL");
@@ -77,7 +78,7 @@ FaceMapper::FaceMapper(json config, Status *myStatus, FrameServer *myFrameServer
 
 	pendingFrames.clear();
 
-	if((myMutex = SDL_CreateMutex()) == NULL) {
+	if((myMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
 
@@ -95,7 +96,7 @@ FaceMapper::FaceMapper(json config, Status *myStatus, FrameServer *myFrameServer
 	frameServer->onFrameStatusChangeEvent(frameStatusChangeCallback);
 
 	//We also want to introduce a checkpoint so that frames cannot TRANSITION AWAY from FRAME_STATUS_MAPPING without our blessing.
-	frameServer->registerFrameStatusCheckpoint(FRAME_STATUS_MAPPING, "faceMapper.ran");
+	mappingCheckpoint = frameServer->registerFrameStatusCheckpoint(FRAME_STATUS_MAPPING, "faceMapper.ran");
 
 	WorkerPoolParameters workerPoolParameters;
 	workerPoolParameters.name = "FaceMapper";
@@ -104,7 +105,7 @@ FaceMapper::FaceMapper(json config, Status *myStatus, FrameServer *myFrameServer
 	workerPoolParameters.initializer = NULL;
 	workerPoolParameters.deinitializer = NULL;
 	workerPoolParameters.usrPtr = (void *)this;
-	workerPoolParameters.handler = workerHandler;
+	workerPoolParameters.handler = NULL; //Mapping passes are submitted as tasks. (See handleFrameStatusChange.)
 	workerPool = new WorkerPool(config, status, frameServer, workerPoolParameters);
 
 	logger->debug1("FaceMapper object constructed and ready to go!");
@@ -126,7 +127,7 @@ FaceMapper::~FaceMapper() noexcept(false) {
 			delete markerTracker;
 		}
 	}
-	SDL_DestroyMutex(myMutex);
+	YerFace_DestroyMutex(myMutex);
 	delete metrics;
 	delete logger;
 }
@@ -200,7 +201,7 @@ void FaceMapper::handleFrameStatusChange(void *userdata, WorkingFrameStatus newS
 			self->pendingFrames[frameNumber].hasEnteredMapping = true;
 			YerFace_MutexUnlock(self->myMutex);
 			if(self->workerPool != NULL) {
-				self->workerPool->sendWorkerSignal();
+				self->workerPool->submitTask(workerTask);
 			}
 			break;
 		case FRAME_STATUS_GONE:
@@ -214,10 +215,15 @@ void FaceMapper::handleFrameStatusChange(void *userdata, WorkingFrameStatus newS
 	}
 }
 
+void FaceMapper::workerTask(WorkerPoolWorker *worker) {
+	//Whichever frame woke us may not be next in line, so keep mapping until the lowest pending frame isn't ready.
+	while(workerHandler(worker));
+}
+
 bool FaceMapper::workerHandler(WorkerPoolWorker *worker) {
 	FaceMapper *self = (FaceMapper *)worker->ptr;
 	bool didWork = false;
-	static FrameNumber lastFrameNumber = -1;
+	FrameNumber &lastFrameNumber = self->lastFrameNumber;
 
 	YerFace_MutexLock(self->myMutex);
 	//// CHECK FOR WORK ////
@@ -248,7 +254,7 @@ bool FaceMapper::workerHandler(WorkerPoolWorker *worker) {
 		}
 		self->metrics->endClock(tick);
 
-		self->frameServer->setWorkingFrameStatusCheckpoint(myFrameNumber, FRAME_STATUS_MAPPING, "faceMapper.ran");
+		self->frameServer->setWorkingFrameStatusCheckpoint(myFrameNumber, FRAME_STATUS_MAPPING, self->mappingCheckpoint);
 		YerFace_MutexLock(self->myMutex);
 		self->pendingFrames[myFrameNumber].hasCompletedMapping = true;
 		YerFace_MutexUnlock(self->myMutex);
@@ -32,9 +32,11 @@ public:
 private:
 	static void handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps);
 	static bool workerHandler(WorkerPoolWorker *worker);
+	static void workerTask(WorkerPoolWorker *worker);
 
 	Status *status;
 	FrameServer *frameServer;
+	FrameStatusCheckpoint mappingCheckpoint;
 	FaceTracker *faceTracker;
 	PreviewHUD *previewHUD;
 
@@ -67,7 +69,8 @@ private:
 	std::vector<MarkerTracker *> trackers;
 
 	SDL_mutex *myMutex;
-	std::unordered_map<FrameNumber, FaceMapperPendingFrame> pendingFrames;
+	FrameSlotRing<FaceMapperPendingFrame> pendingFrames;
+	FrameNumber lastFrameNumber;
 	WorkerPool *workerPool;
 };
 
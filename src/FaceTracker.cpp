@@ -29,17 +29,20 @@ public:
 class FaceTrackerWorker {
 public:
 	FaceTracker *self;
-
-	dlib::shape_predictor shapePredictor;
 };
 
 
 // Pose recovery approach largely informed by the following sources:
 //  - https://www.learnopencv.com/head-pose-estimation-using-opencv-and-dlib/
 //  - https://github.com/severin-lemaignan/gazr/
+dlib::shape_predictor *FaceTracker::cachedShapePredictor = NULL;
+string FaceTracker::cachedShapePredictorFileName = "";
+
 FaceTracker::FaceTracker(json config, Status *myStatus, SDLDriver *mySDLDriver, FrameServer *myFrameServer, FaceDetector *myFaceDetector) {
 	predictorWorkerPool = NULL;
 	assignmentWorkerPool = NULL;
+	shapePredictor = NULL;
+	assignmentLastFrameNumber = -1;
 
 	featureDetectionModelFileName = Utilities::fileValidPathOrDie(config["YerFace"]["FaceTracker"]["dlibFaceLandmarks"]);
 	useFullSizedFrameForLandmarkDetection = config["YerFace"]["FaceTracker"]["useFullSizedFrameForLandmarkDetection"];
@@ -125,13 +128,30 @@ FaceTracker::FaceTracker(json config, Status *myStatus, SDLDriver *mySDLDriver,
 	depthSliceH = config["YerFace"]["FaceTracker"]["depthSlices"]["H"];
 
 	logger = new Logger("FaceTracker");
+
+	//Prediction with a shape_predictor doesn't modify it, so every worker can share one copy of the model.
+	//It is kept after we're gone, so a batch worker's next job can skip loading it.
+	if(cachedShapePredictor != NULL && cachedShapePredictorFileName == featureDetectionModelFileName) {
+		logger->debug1("Reusing the landmark model loaded by a previous job.");
+	} else {
+		releaseCachedModels();
+		Uint32 loadStart = SDL_GetTicks();
+		cachedShapePredictor = new dlib::shape_predictor();
+		cachedShapePredictorFileName = featureDetectionModelFileName;
+		MappedFileBuffer modelBuffer(featureDetectionModelFileName);
+		std::istream modelStream(&modelBuffer);
+		deserialize(*cachedShapePredictor, modelStream);
+		logger->debug1("Loaded %lu byte landmark model in %u milliseconds.", modelBuffer.getSize(), SDL_GetTicks() - loadStart);
+	}
+	shapePredictor = cachedShapePredictor;
+
 	metricsPredictor = new Metrics(config, "FaceTracker.Predictor");
 	metricsAssignment = new Metrics(config, "FaceTracker.Assignment");
 
-	if((myMutex = SDL_CreateMutex()) == NULL) {
+	if((myMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
-	if((myAssignmentMutex = SDL_CreateMutex()) == NULL) {
+	if((myAssignmentMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
 
@@ -147,7 +167,7 @@ FaceTracker::FaceTracker(json config, Status *myStatus, SDLDriver *mySDLDriver,
 	frameServer->onFrameStatusChangeEvent(frameStatusChangeCallback);
 
 	//We also want to introduce a checkpoint so that frames cannot TRANSITION AWAY from FRAME_STATUS_TRACKING without our blessing.
-	frameServer->registerFrameStatusCheckpoint(FRAME_STATUS_TRACKING, "faceTracker.ran");
+	trackingCheckpoint = frameServer->registerFrameStatusCheckpoint(FRAME_STATUS_TRACKING, "faceTracker.ran");
 
 	WorkerPoolParameters workerPoolParameters;
 	workerPoolParameters.name = "FaceTracker.Predictor";
@@ -156,7 +176,7 @@ FaceTracker::FaceTracker(json config, Status *myStatus, SDLDriver *mySDLDriver,
 	workerPoolParameters.initializer = predictorWorkerInitializer;
 	workerPoolParameters.deinitializer = NULL;
 	workerPoolParameters.usrPtr = (void *)this;
-	workerPoolParameters.handler = predictorWorkerHandler;
+	workerPoolParameters.handler = NULL; //Prediction work is submitted as tasks. (See handleFrameStatusChange.)
 	predictorWorkerPool = new WorkerPool(config, status, frameServer, workerPoolParameters);
 
 	workerPoolParameters.name = "FaceTracker.Assignment";
@@ -165,7 +185,7 @@ FaceTracker::FaceTracker(json config, Status *myStatus, SDLDriver *mySDLDriver,
 	workerPoolParameters.initializer = NULL;
 	workerPoolParameters.deinitializer = NULL;
 	workerPoolParameters.usrPtr = (void *)this;
-	workerPoolParameters.handler = assignmentWorkerHandler;
+	workerPoolParameters.handler = NULL; //Assignment passes are submitted as tasks. (See predictorWorkerTask.)
 	assignmentWorkerPool = new WorkerPool(config, status, frameServer, workerPoolParameters);
 
 	logger->debug1("FaceTracker object constructed and ready to go!");
@@ -177,9 +197,6 @@ FaceTracker::~FaceTracker() noexcept(false) {
 	delete predictorWorkerPool;
 
 	YerFace_MutexLock(myMutex);
-	if(pendingPredictionFrameNumbers.size() > 0) {
-		logger->err("Frames are still pending! Woe is me!");
-	}
 	if(outputFrames.size() > 0) {
 		logger->err("Outputs are still pending! Woe is me!");
 	}
@@ -191,14 +208,13 @@ FaceTracker::~FaceTracker() noexcept(false) {
 	}
 	YerFace_MutexUnlock(myAssignmentMutex);
 
-	SDL_DestroyMutex(myMutex);
-	SDL_DestroyMutex(myAssignmentMutex);
+	YerFace_DestroyMutex(myMutex);
+	YerFace_DestroyMutex(myAssignmentMutex);
 	delete metricsPredictor;
 	delete logger;
 }
 
 void FaceTracker::doIdentifyFeatures(WorkerPoolWorker *worker, WorkingFrame *workingFrame, FaceTrackerOutput *output) {
-	FaceTrackerWorker *innerWorker = (FaceTrackerWorker *)worker->ptr;
 	FacialDetectionBox facialDetection = faceDetector->getFacialDetection(output->frameNumber);
 	if(!facialDetection.set) {
 		return;
@@ -217,16 +233,23 @@ void FaceTracker::doIdentifyFeatures(WorkerPoolWorker *worker, WorkingFrame *wor
 		searchRect = facialDetection.box;
 	}
 
-	dlib::cv_image<dlib::bgr_pixel> dlibSearchFrame = cv_image<bgr_pixel>(searchFrame);
 	dlib::rectangle dlibSearchBox = dlib::rectangle(searchRect.x, searchRect.y, (searchRect.width + searchRect.x), (searchRect.height + searchRect.y));
 
-	full_object_detection result = innerWorker->shapePredictor(dlibSearchFrame, dlibSearchBox);
+	full_object_detection result;
+	if(searchFrame.channels() == 1) {
+		result = (*shapePredictor)(cv_image<unsigned char>(searchFrame), dlibSearchBox);
+	} else {
+		result = (*shapePredictor)(cv_image<bgr_pixel>(searchFrame), dlibSearchBox);
+	}
 
 	output->facialFeatures.featuresExposed.features.clear();
 	output->facialFeatures.featuresExposed.features.resize(result.num_parts());
 
+	//Seven correlation points plus the stommion.
 	output->facialFeatures.features.clear();
+	output->facialFeatures.features.reserve(8);
 	output->facialFeatures.features3D.clear();
+	output->facialFeatures.features3D.reserve(8);
 	DlibPointPointer partPointer;
 	dlib::point part;
 	Point2d partPoint;
@@ -308,10 +331,10 @@ void FaceTracker::doInitializeCameraModel(WorkingFrame *workingFrame) {
 	YerFace_MutexUnlock(myAssignmentMutex);
 }
 
-void FaceTracker::doCalculateFacialTransformation(WorkerPoolWorker *worker, WorkingFrame *workingFrame, FaceTrackerOutput *output) {
+bool FaceTracker::doCalculateFacialTransformation(WorkerPoolWorker *worker, WorkingFrame *workingFrame, FaceTrackerOutput *output) {
 	if(!output->facialFeatures.set) {
 		previouslyReportedFacialPose.set = false;
-		return;
+		return false;
 	}
 
 	FacialCameraModel camera = facialCameraModel;
@@ -321,14 +344,13 @@ void FaceTracker::doCalculateFacialTransformation(WorkerPoolWorker *worker, Work
 	FacialPose tempPose;
 	tempPose.timestamp = frameTimestamp;
 	tempPose.set = false;
-	Mat tempRotationVector;
 
 	//// DO FACIAL POSE SOLUTION ////
 
-	solvePnP(output->facialFeatures.features3D, output->facialFeatures.features, camera.cameraMatrix, camera.distortionCoefficients, tempRotationVector, tempPose.translationVector);
-	tempRotationVector.at<double>(0) = tempRotationVector.at<double>(0) * -1.0;
-	tempRotationVector.at<double>(1) = tempRotationVector.at<double>(1) * -1.0;
-	Rodrigues(tempRotationVector, tempPose.rotationMatrix);
+	solvePnP(output->facialFeatures.features3D, output->facialFeatures.features, camera.cameraMatrix, camera.distortionCoefficients, poseRotationVector, tempPose.translationVector);
+	poseRotationVector.at<double>(0) = poseRotationVector.at<double>(0) * -1.0;
+	poseRotationVector.at<double>(1) = poseRotationVector.at<double>(1) * -1.0;
+	Rodrigues(poseRotationVector, tempPose.rotationMatrix);
 
 	//// REJECT BAD / OUT OF BOUNDS FACIAL POSES ////
 
@@ -367,43 +389,51 @@ void FaceTracker::doCalculateFacialTransformation(WorkerPoolWorker *worker, Work
 		} else {
 			output->facialPose.set = false;
 		}
-		return;
+		return false;
 	}
 
 	//// DO FACIAL POSE SMOOTHING ////
 
-	facialPoseSmoothingBuffer.push_back(tempPose);
+	//Once the smoothing buffer has grown to size, nothing from here down to the published pose should touch the heap.
+	YerFace_AllocationCheckBegin(smoothingAllocations);
+	FacialPoseSample sample;
+	sample.timestamp = tempPose.timestamp;
+	sample.translationVector = tempPose.translationVector;
+	sample.rotationMatrix = tempPose.rotationMatrix;
+	facialPoseSmoothingBuffer.push_back(sample);
 	while(facialPoseSmoothingBuffer.front().timestamp <= (frameTimestamp - poseSmoothingOverSeconds)) {
-		facialPoseSmoothingBuffer.pop_front();
+		facialPoseSmoothingBuffer.erase(facialPoseSmoothingBuffer.begin());
 	}
 
-	tempPose.translationVector = (Mat_<double>(3,1) << 0.0, 0.0, 0.0);
-	tempPose.rotationMatrix = (Mat_<double>(3,3) <<
-			0.0, 0.0, 0.0,
-			0.0, 0.0, 0.0,
-			0.0, 0.0, 0.0);
-
+	Matx31d smoothedTranslationVector = Matx31d::zeros();
+	Matx33d smoothedRotationMatrix = Matx33d::zeros();
 	double combinedWeights = 0.0;
-	for(FacialPose pose : facialPoseSmoothingBuffer) {
+	for(const FacialPoseSample &pose : facialPoseSmoothingBuffer) {
 		double progress = (pose.timestamp - (frameTimestamp - poseSmoothingOverSeconds)) / poseSmoothingOverSeconds;
 		double weight = std::pow(progress, (double)poseSmoothingExponent) - combinedWeights;
 		combinedWeights += weight;
-		for(int j = 0; j < 3; j++) {
-			tempPose.translationVector.at<double>(j) += pose.translationVector.at<double>(j) * weight;
-		}
-		for(int j = 0; j < 9; j++) {
-			tempPose.rotationMatrix.at<double>(j) += pose.rotationMatrix.at<double>(j) * weight;
-		}
+		smoothedTranslationVector += pose.translationVector * weight;
+		smoothedRotationMatrix += pose.rotationMatrix * weight;
 	}
 
+	//The raw solution is safe in the smoothing buffer, so the smoothed pose can overwrite this frame's (not yet published) matrices in place.
+	for(int j = 0; j < 3; j++) {
+		tempPose.translationVector.at<double>(j) = smoothedTranslationVector.val[j];
+	}
+	for(int j = 0; j < 9; j++) {
+		tempPose.rotationMatrix.at<double>(j) = smoothedRotationMatrix.val[j];
+	}
+	YerFace_AllocationCheckEnd(logger, smoothingAllocations, "Facial pose smoothing");
+
 	tempPose.set = true;
 	angles = Utilities::rotationMatrixToEulerAngles(tempPose.rotationMatrix);
 	logger->debug3("Facial Pose Angle: <%.02f, %.02f, %.02f>; Translation: <%.02f, %.02f, %.02f>", angles[0], angles[1], angles[2], tempPose.translationVector.at<double>(0), tempPose.translationVector.at<double>(1), tempPose.translationVector.at<double>(2));
 
 	//// REJECT NOISY SOLUTIONS ////
 
-	tempPose.rotationMatrixInternal = tempPose.rotationMatrix.clone();
-	tempPose.translationVectorInternal = tempPose.translationVector.clone();
+	// NOTE: Pose matrices are never modified in place once they're published, so we can share them rather than cloning.
+	tempPose.rotationMatrixInternal = tempPose.rotationMatrix;
+	tempPose.translationVectorInternal = tempPose.translationVector;
 	if(previouslyReportedFacialPose.set) {
 		// Do de-noising (low motion rejection) first for the externally-facing matrices
 		scaledRotationThreshold = poseRotationLowRejectionThreshold * timeScale;
@@ -411,11 +441,11 @@ void FaceTracker::doCalculateFacialTransformation(WorkerPoolWorker *worker, Work
 
 		degreesDifference = Utilities::degreesDifferenceBetweenTwoRotationMatrices(previouslyReportedFacialPose.rotationMatrix, tempPose.rotationMatrix);
 		if(degreesDifference < scaledRotationThreshold) {
-			tempPose.rotationMatrix = previouslyReportedFacialPose.rotationMatrix.clone();
+			tempPose.rotationMatrix = previouslyReportedFacialPose.rotationMatrix;
 		}
 		distance = Utilities::lineDistance(Point3d(tempPose.translationVector), Point3d(previouslyReportedFacialPose.translationVector));
 		if(distance < scaledTranslationThreshold) {
-			tempPose.translationVector = previouslyReportedFacialPose.translationVector.clone();
+			tempPose.translationVector = previouslyReportedFacialPose.translationVector;
 		}
 
 		// Do de-noising (low motion rejection) again, but for the internally-facing matrices
@@ -424,25 +454,25 @@ void FaceTracker::doCalculateFacialTransformation(WorkerPoolWorker *worker, Work
 
 		degreesDifference = Utilities::degreesDifferenceBetweenTwoRotationMatrices(previouslyReportedFacialPose.rotationMatrixInternal, tempPose.rotationMatrixInternal);
 		if(degreesDifference < scaledRotationThreshold) {
-			tempPose.rotationMatrixInternal = previouslyReportedFacialPose.rotationMatrixInternal.clone();
+			tempPose.rotationMatrixInternal = previouslyReportedFacialPose.rotationMatrixInternal;
 		}
 		distance = Utilities::lineDistance(Point3d(tempPose.translationVectorInternal), Point3d(previouslyReportedFacialPose.translationVectorInternal));
 		if(distance < scaledTranslationThreshold) {
-			tempPose.translationVectorInternal = previouslyReportedFacialPose.translationVectorInternal.clone();
+			tempPose.translationVectorInternal = previouslyReportedFacialPose.translationVectorInternal;
 		}
 	}
 
 	output->facialPose = tempPose;
 	previouslyReportedFacialPose = output->facialPose;
+	return true;
 }
 
 void FaceTracker::doPrecalculateFacialPlaneNormal(WorkerPoolWorker *worker, WorkingFrame *workingFrame, FaceTrackerOutput *output) {
 	if(!output->facialPose.set) {
 		return;
 	}
-	Mat planeNormalMat = (Mat_<double>(3, 1) << 0.0, 0.0, -1.0);
-	planeNormalMat = output->facialPose.rotationMatrixInternal * planeNormalMat;
-	output->facialPose.facialPlaneNormal = Vec3d(planeNormalMat.at<double>(0), planeNormalMat.at<double>(1), planeNormalMat.at<double>(2));
+	Matx33d rotationMatrix = output->facialPose.rotationMatrixInternal;
+	output->facialPose.facialPlaneNormal = rotationMatrix * Vec3d(0.0, 0.0, -1.0);
 }
 
 bool FaceTracker::doConvertLandmarkPointToImagePoint(DlibPointPointer pointPointer, Point2d *dst, double detectionScaleFactor) {
@@ -456,9 +486,17 @@ bool FaceTracker::doConvertLandmarkPointToImagePoint(DlibPointPointer pointPoint
 	return true;
 }
 
+void FaceTracker::releaseCachedModels(void) {
+	if(cachedShapePredictor != NULL) {
+		delete cachedShapePredictor;
+		cachedShapePredictor = NULL;
+	}
+	cachedShapePredictorFileName = "";
+}
+
 void FaceTracker::renderPreviewHUD(Mat frame, FrameNumber frameNumber, int density, bool mirrorMode) {
 	YerFace_MutexLock(myMutex);
-	if(frameNumber < 0 || outputFrames.find(frameNumber) == outputFrames.end()) {
+	if(frameNumber < 0 || !outputFrames.contains(frameNumber)) {
 		YerFace_MutexUnlock(myMutex);
 		throw invalid_argument("FaceTracker::renderPreviewHUD() passed invalid frame number");
 	}
@@ -542,7 +580,7 @@ void FaceTracker::renderPreviewHUD(Mat frame, FrameNumber frameNumber, int densi
 FacialFeatures FaceTracker::getFacialFeatures(FrameNumber frameNumber) {
 	FacialFeatures val;
 	YerFace_MutexLock(myMutex);
-	if(frameNumber < 0 || outputFrames.find(frameNumber) == outputFrames.end()) {
+	if(frameNumber < 0 || !outputFrames.contains(frameNumber)) {
 		YerFace_MutexUnlock(myMutex);
 		throw invalid_argument("FaceTracker::getFacialFeatures() passed invalid frame number");
 	}
@@ -562,7 +600,7 @@ FacialCameraModel FaceTracker::getFacialCameraModel(void) {
 FacialPose FaceTracker::getFacialPose(FrameNumber frameNumber) {
 	FacialPose val;
 	YerFace_MutexLock(myMutex);
-	if(frameNumber < 0 || outputFrames.find(frameNumber) == outputFrames.end()) {
+	if(frameNumber < 0 || !outputFrames.contains(frameNumber)) {
 		YerFace_MutexUnlock(myMutex);
 		throw invalid_argument("FaceTracker::getFacialPose() passed invalid frame number");
 	}
@@ -574,7 +612,7 @@ FacialPose FaceTracker::getFacialPose(FrameNumber frameNumber) {
 FacialPlane FaceTracker::getCalculatedFacialPlaneForWorkingFacialPose(FrameNumber frameNumber, MarkerType markerType) {
 	FacialPose facialPose;
 	YerFace_MutexLock(myMutex);
-	if(frameNumber < 0 || outputFrames.find(frameNumber) == outputFrames.end()) {
+	if(frameNumber < 0 || !outputFrames.contains(frameNumber)) {
 		YerFace_MutexUnlock(myMutex);
 		throw invalid_argument("FaceTracker::getCalculatedFacialPlaneForWorkingFacialPose() passed invalid frame number");
 	}
@@ -658,13 +696,13 @@ void FaceTracker::handleFrameStatusChange(void *userdata, WorkingFrameStatus new
 			YerFace_MutexUnlock(self->myAssignmentMutex);
 			break;
 		case FRAME_STATUS_TRACKING:
-			self->logger->debug4("handleFrameStatusChange() Frame #" YERFACE_FRAMENUMBER_FORMAT " waiting on me. Queue depth is now %lu", frameNumber, self->pendingPredictionFrameNumbers.size());
-			YerFace_MutexLock(self->myMutex);
-			self->pendingPredictionFrameNumbers.push_back(frameNumber);
-			YerFace_MutexUnlock(self->myMutex);
-			if(self->predictorWorkerPool != NULL) {
-				self->predictorWorkerPool->sendWorkerSignal();
+			self->logger->debug4("handleFrameStatusChange() Frame #" YERFACE_FRAMENUMBER_FORMAT " waiting on me. Submitting prediction task.", frameNumber);
+			if(self->predictorWorkerPool == NULL) {
+				throw logic_error("Frame entered FRAME_STATUS_TRACKING, but the predictor worker pool does not exist!");
 			}
+			self->predictorWorkerPool->submitTask([frameNumber](WorkerPoolWorker *worker) {
+				predictorWorkerTask(worker, frameNumber);
+			});
 			break;
 		case FRAME_STATUS_GONE:
 			YerFace_MutexLock(self->myMutex);
@@ -678,56 +716,44 @@ void FaceTracker::predictorWorkerInitializer(WorkerPoolWorker *worker, void *ptr
 	FaceTracker *self = (FaceTracker *)ptr;
 	FaceTrackerWorker *innerWorker = new FaceTrackerWorker();
 	innerWorker->self = self;
-	deserialize(self->featureDetectionModelFileName.c_str()) >> innerWorker->shapePredictor;
 	worker->ptr = (void *)innerWorker;
 }
 
-bool FaceTracker::predictorWorkerHandler(WorkerPoolWorker *worker) {
+void FaceTracker::predictorWorkerTask(WorkerPoolWorker *worker, FrameNumber myFrameNumber) {
 	FaceTrackerWorker *innerWorker = (FaceTrackerWorker *)worker->ptr;
 	FaceTracker *self = innerWorker->self;
 
-	bool didWork = false;
-	FrameNumber myFrameNumber = -1;
-
-	YerFace_MutexLock(self->myMutex);
-	//// CHECK FOR WORK ////
-	if(self->pendingPredictionFrameNumbers.size() > 0) {
-		myFrameNumber = self->pendingPredictionFrameNumbers.front();
-		self->pendingPredictionFrameNumbers.pop_front();
-	}
-	YerFace_MutexUnlock(self->myMutex);
-
 	//// DO THE WORK ////
-	if(myFrameNumber > 0) {
-		MetricsTick tick = self->metricsPredictor->startClock();
-
-		WorkingFrame *workingFrame = self->frameServer->getWorkingFrame(myFrameNumber);
+	MetricsTick tick = self->metricsPredictor->startClock();
 
-		FaceTrackerOutput output;
-		output.set = false;
-		output.facialFeatures.set = false;
-		output.facialFeatures.featuresExposed.set = false;
-		output.facialPose.set = false;
-		output.frameNumber = myFrameNumber;
+	WorkingFrame *workingFrame = self->frameServer->getWorkingFrame(myFrameNumber);
 
-		self->doIdentifyFeatures(worker, workingFrame, &output);
+	FaceTrackerOutput output;
+	output.set = false;
+	output.facialFeatures.set = false;
+	output.facialFeatures.featuresExposed.set = false;
+	output.facialPose.set = false;
+	output.frameNumber = myFrameNumber;
 
-		YerFace_MutexLock(self->myMutex);
-		self->outputFrames[myFrameNumber] = output;
-		YerFace_MutexUnlock(self->myMutex);
+	self->doIdentifyFeatures(worker, workingFrame, &output);
 
-		YerFace_MutexLock(self->myAssignmentMutex);
-		self->pendingAssignmentFrameNumbers[myFrameNumber].readyForAssignment = true;
-		YerFace_MutexUnlock(self->myAssignmentMutex);
-		if(self->assignmentWorkerPool != NULL) {
-			self->assignmentWorkerPool->sendWorkerSignal();
-		}
+	YerFace_MutexLock(self->myMutex);
+	self->outputFrames[myFrameNumber] = std::move(output);
+	YerFace_MutexUnlock(self->myMutex);
 
-		self->metricsPredictor->endClock(tick);
-		didWork = true;
+	YerFace_MutexLock(self->myAssignmentMutex);
+	self->pendingAssignmentFrameNumbers[myFrameNumber].readyForAssignment = true;
+	YerFace_MutexUnlock(self->myAssignmentMutex);
+	if(self->assignmentWorkerPool != NULL) {
+		self->assignmentWorkerPool->submitTask(assignmentWorkerTask);
 	}
 
-	return didWork;
+	self->metricsPredictor->endClock(tick);
+}
+
+void FaceTracker::assignmentWorkerTask(WorkerPoolWorker *worker) {
+	//Predictions finish out of order. Drain every frame that is now ready, in order.
+	while(assignmentWorkerHandler(worker));
 }
 
 bool FaceTracker::assignmentWorkerHandler(WorkerPoolWorker *worker) {
@@ -735,7 +761,7 @@ bool FaceTracker::assignmentWorkerHandler(WorkerPoolWorker *worker) {
 
 	bool didWork = false;
 	FrameNumber myFrameNumber = -1;
-	static FrameNumber lastFrameNumber = -1;
+	FrameNumber &lastFrameNumber = self->assignmentLastFrameNumber;
 
 	YerFace_MutexLock(self->myAssignmentMutex);
 	//// CHECK FOR WORK ////
@@ -776,15 +802,18 @@ bool FaceTracker::assignmentWorkerHandler(WorkerPoolWorker *worker) {
 		if(!self->facialCameraModel.set) {
 			self->doInitializeCameraModel(workingFrame);
 		}
-		self->doCalculateFacialTransformation(worker, workingFrame, &output);
+		bool poseAccepted = self->doCalculateFacialTransformation(worker, workingFrame, &output);
 		self->doPrecalculateFacialPlaneNormal(worker, workingFrame, &output);
 		YerFace_MutexUnlock(self->myAssignmentMutex);
 
+		//Let FaceDetector seed the next frame's face box from these landmarks (or know that it can't).
+		self->faceDetector->reportTrackingResult(workingFrame->frameTimestamps, output.facialFeatures.featuresExposed.features, output.facialFeatures.set && poseAccepted);
+
 		YerFace_MutexLock(self->myMutex);
 		self->outputFrames[myFrameNumber] = output;
 		YerFace_MutexUnlock(self->myMutex);
 
-		self->frameServer->setWorkingFrameStatusCheckpoint(myFrameNumber, FRAME_STATUS_TRACKING, "faceTracker.ran");
+		self->frameServer->setWorkingFrameStatusCheckpoint(myFrameNumber, FRAME_STATUS_TRACKING, self->trackingCheckpoint);
 		self->metricsAssignment->endClock(tick);
 
 		didWork = true;
@@ -2,6 +2,10 @@
 
 #include <string>
 
+namespace dlib {
+	class shape_predictor;
+};
+
 #include "Logger.hpp"
 #include "Status.hpp"
 #include "SDLDriver.hpp"
@@ -91,6 +95,14 @@ public:
 	bool set;
 };
 
+//Raw pose solution, kept for smoothing. Fixed-size, so the smoothing buffer stops touching the heap once it has grown.
+class FacialPoseSample {
+public:
+	double timestamp;
+	cv::Matx31d translationVector;
+	cv::Matx33d rotationMatrix;
+};
+
 class FacialPlane {
 public:
 	cv::Point3d planePoint;
@@ -142,22 +154,28 @@ public:
 	FacialCameraModel getFacialCameraModel(void);
 	FacialPose getFacialPose(FrameNumber frameNumber);
 	FacialPlane getCalculatedFacialPlaneForWorkingFacialPose(FrameNumber frameNumber, MarkerType markerType);
+	static void releaseCachedModels(void);
 private:
 	void doIdentifyFeatures(WorkerPoolWorker *worker, WorkingFrame *workingFrame, FaceTrackerOutput *output);
 	void doInitializeCameraModel(WorkingFrame *workingFrame);
-	void doCalculateFacialTransformation(WorkerPoolWorker *worker, WorkingFrame *workingFrame, FaceTrackerOutput *output);
+	bool doCalculateFacialTransformation(WorkerPoolWorker *worker, WorkingFrame *workingFrame, FaceTrackerOutput *output);
 	void doPrecalculateFacialPlaneNormal(WorkerPoolWorker *worker, WorkingFrame *workingFrame, FaceTrackerOutput *output);
 	bool doConvertLandmarkPointToImagePoint(DlibPointPointer pointPointer, cv::Point2d *dst, double detectionScaleFactor);
 	static void handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps);
 	static void predictorWorkerInitializer(WorkerPoolWorker *worker, void *ptr);
-	static bool predictorWorkerHandler(WorkerPoolWorker *worker);
+	static void predictorWorkerTask(WorkerPoolWorker *worker, FrameNumber frameNumber);
 	static bool assignmentWorkerHandler(WorkerPoolWorker *worker);
+	static void assignmentWorkerTask(WorkerPoolWorker *worker);
 
 	string featureDetectionModelFileName, faceDetectionModelFileName;
+	dlib::shape_predictor *shapePredictor; //Loaded once and shared, read-only, by every predictor worker.
+	static dlib::shape_predictor *cachedShapePredictor; //Owns shapePredictor, and outlives us. Only one FaceTracker may exist at a time.
+	static string cachedShapePredictorFileName;
 	bool useFullSizedFrameForLandmarkDetection;
 	Status *status;
 	SDLDriver *sdlDriver;
 	FrameServer *frameServer;
+	FrameStatusCheckpoint trackingCheckpoint;
 	FaceDetector *faceDetector;
 	double poseSmoothingOverSeconds;
 	double poseSmoothingExponent;
@@ -190,15 +208,16 @@ private:
 	Logger *logger;
 	Metrics *metricsPredictor, *metricsAssignment;
 
-	list<FacialPose> facialPoseSmoothingBuffer;
+	std::vector<FacialPoseSample> facialPoseSmoothingBuffer;
+	cv::Mat poseRotationVector; //Scratch for solvePnP(), reused from frame to frame.
 	FacialPose previouslyReportedFacialPose;
 	FacialCameraModel facialCameraModel;
 
 	SDL_mutex *myMutex, *myAssignmentMutex;
 
-	std::list<FrameNumber> pendingPredictionFrameNumbers;
 	unordered_map<FrameNumber, FaceTrackerAssignmentTask> pendingAssignmentFrameNumbers;
-	unordered_map<FrameNumber, FaceTrackerOutput> outputFrames;
+	FrameNumber assignmentLastFrameNumber;
+	FrameSlotRing<FaceTrackerOutput> outputFrames;
 
 	WorkerPool *predictorWorkerPool, *assignmentWorkerPool;
 };
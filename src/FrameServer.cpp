@@ -15,6 +15,8 @@ FrameServer::FrameServer(json config, Status *myStatus, bool myLowLatency) {
 	if(status == NULL) {
 		throw invalid_argument("status cannot be NULL");
 	}
+	ffmpegDriver = NULL;
+	reportedScale = false;
 	lowLatency = myLowLatency;
 	string lowLatencyKey = "LowLatency";
 	if(!lowLatency) {
@@ -28,12 +30,15 @@ FrameServer::FrameServer(json config, Status *myStatus, bool myLowLatency) {
 	if(detectionScaleFactor < 0.0 || detectionScaleFactor > 1.0) {
 		throw invalid_argument("Detection Scale Factor is invalid.");
 	}
+	detectionGrayscale = config["YerFace"]["FrameServer"][lowLatencyKey]["detectionGrayscale"];
 
 	for(unsigned int i = 0; i <= FRAME_STATUS_MAX; i++) {
 		onFrameStatusChangeCallbacks[i].clear();
+		statusCheckpoints[i].clear();
+		statusCheckpointMasks[i] = 0;
 	}
 
-	if((myMutex = SDL_CreateMutex()) == NULL) {
+	if((myMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
 
@@ -41,6 +46,8 @@ FrameServer::FrameServer(json config, Status *myStatus, bool myLowLatency) {
 
 	draining = false;
 	mirrorMode = false;
+	frameSizeSet = false;
+	framesInserted = false;
 	workerPool = NULL;
 
 	WorkerPoolParameters workerPoolParameters;
@@ -74,7 +81,7 @@ FrameServer::~FrameServer() noexcept(false) {
 	}
 	YerFace_MutexUnlock(myMutex);
 
-	SDL_DestroyMutex(myMutex);
+	YerFace_DestroyMutex(myMutex);
 	delete metrics;
 	delete logger;
 }
@@ -88,18 +95,41 @@ void FrameServer::onFrameServerDrainedEvent(FrameServerDrainedEventCallback call
 void FrameServer::onFrameStatusChangeEvent(FrameStatusChangeEventCallback callback) {
 	checkStatusValue(callback.newStatus);
 	YerFace_MutexLock(myMutex);
+	// Callbacks are dispatched without holding myMutex, so the callback lists must be settled before frames start flowing.
+	if(framesInserted) {
+		YerFace_MutexUnlock(myMutex);
+		throw logic_error("Frame status change callbacks must be registered before any frames are inserted!");
+	}
 	onFrameStatusChangeCallbacks[callback.newStatus].push_back(callback);
 	YerFace_MutexUnlock(myMutex);
 }
 
-void FrameServer::registerFrameStatusCheckpoint(WorkingFrameStatus status, string checkpointKey) {
+FrameStatusCheckpoint FrameServer::registerFrameStatusCheckpoint(WorkingFrameStatus status, string checkpointKey) {
 	checkStatusValue(status);
 	if(status == FRAME_STATUS_GONE) {
 		throw invalid_argument("Somebody tried to register a checkpoint for FRAME_STATUS_GONE, but this doesn't make sense because FRAME_STATUS_GONE means the frame is about to be cleaned up.");
 	}
 	YerFace_MutexLock(myMutex);
+	if(framesInserted) {
+		YerFace_MutexUnlock(myMutex);
+		throw logic_error("Frame status checkpoints must be registered before any frames are inserted!");
+	}
+	for(string existingKey : statusCheckpoints[status]) {
+		if(existingKey == checkpointKey) {
+			YerFace_MutexUnlock(myMutex);
+			throw invalid_argument("Somebody tried to register the same checkpoint twice for the same status!");
+		}
+	}
+	if(statusCheckpoints[status].size() >= FRAME_STATUS_MAX_CHECKPOINTS) {
+		YerFace_MutexUnlock(myMutex);
+		throw runtime_error("Too many checkpoints registered for a single frame status!");
+	}
+	FrameStatusCheckpoint checkpoint = (FrameStatusCheckpoint)statusCheckpoints[status].size();
 	statusCheckpoints[status].push_back(checkpointKey);
+	statusCheckpointMasks[status] |= (uint64_t)1 << checkpoint;
+	logger->debug2("Registered checkpoint \"%s\" for status %d as bit %u.", checkpointKey.c_str(), status, checkpoint);
 	YerFace_MutexUnlock(myMutex);
+	return checkpoint;
 }
 
 void FrameServer::insertNewFrame(VideoFrame *videoFrame) {
@@ -121,59 +151,63 @@ void FrameServer::insertNewFrame(VideoFrame *videoFrame) {
 		}
 	}
 
-	WorkingFrame *workingFrame = new WorkingFrame();
-
-	if((workingFrame->previewFrameMutex = SDL_CreateMutex()) == NULL) {
-		throw runtime_error("Failed creating mutex!");
+	if(ffmpegDriver == NULL) {
+		YerFace_MutexUnlock(myMutex);
+		throw logic_error("Can't insert new frame without an FFmpegDriver to lease the frame backing from!");
 	}
 
-	workingFrame->frame = videoFrame->frameCV.clone();
-	if(mirrorMode) {
-		cv::flip(workingFrame->frame, workingFrame->previewFrame, 1);
-	} else {
-		workingFrame->previewFrame = workingFrame->frame.clone();
-	}
+	WorkingFrame *workingFrame = new WorkingFrame();
+
+	// Rather than copying the frame, we hold a lease on the decoder's frame backing until PREVIEW_DISPLAY is finished.
+	ffmpegDriver->acquireVideoFrameBacking(videoFrame->frameBacking);
+	workingFrame->frameBacking = videoFrame->frameBacking;
+	workingFrame->frame = videoFrame->frameCV;
 
 	frameSize = workingFrame->frame.size();
 	frameSizeSet = true;
 
 	workingFrame->frameTimestamps = videoFrame->timestamp;
+	workingFrame->status = FRAME_STATUS_NEW;
+	for(unsigned int i = 0; i <= FRAME_STATUS_MAX; i++) {
+		workingFrame->checkpoints[i] = 0;
+	}
 
-	if(detectionBoundingBox > 0) {
-		if(frameSize.width >= frameSize.height) {
-			detectionScaleFactor = (double)detectionBoundingBox / (double)frameSize.width;
-		} else {
-			detectionScaleFactor = (double)detectionBoundingBox / (double)frameSize.height;
+	workingFrame->detectionScaleFactor = getDetectionScaleFactor(frameSize);
+
+	// FFmpegDriver normally hands us the detection frame already scaled (and converted) straight from the decoder output.
+	// We only fall back to scaling it ourselves if that frame is missing or doesn't match what we expect.
+	if(!videoFrame->detectionFrameCV.empty() && videoFrame->detectionFrameCV.size() == getDetectionFrameSize(frameSize) && videoFrame->detectionFrameCV.channels() == (detectionGrayscale ? 1 : 3)) {
+		workingFrame->detectionFrame = videoFrame->detectionFrameCV;
+	} else {
+		resize(workingFrame->frame, workingFrame->detectionFrame, Size(), workingFrame->detectionScaleFactor, workingFrame->detectionScaleFactor);
+		if(detectionGrayscale) {
+			cvtColor(workingFrame->detectionFrame, workingFrame->detectionFrame, COLOR_BGR2GRAY);
 		}
 	}
-	workingFrame->detectionScaleFactor = detectionScaleFactor;
-
-	resize(workingFrame->frame, workingFrame->detectionFrame, Size(), detectionScaleFactor, detectionScaleFactor);
 
-	static bool reportedScale = false;
 	if(!reportedScale) {
-		logger->debug1("Scaled current frame <%dx%d> down to <%dx%d> for detection", frameSize.width, frameSize.height, workingFrame->detectionFrame.size().width, workingFrame->detectionFrame.size().height);
+		logger->debug1("Scaled current frame <%dx%d> down to <%dx%d> (%s) for detection", frameSize.width, frameSize.height, workingFrame->detectionFrame.size().width, workingFrame->detectionFrame.size().height, detectionGrayscale ? "grayscale" : "BGR");
 		reportedScale = true;
 	}
 
-	// Set all of the registered checkpoints to FALSE to accurately record the frame's status.
-	for(unsigned int i = 0; i <= FRAME_STATUS_MAX; i++) {
-		for(string checkpointKey : statusCheckpoints[i]) {
-			workingFrame->checkpoints[i][checkpointKey] = false;
-		}
-	}
-
+	framesInserted = true;
 	frameStore[workingFrame->frameTimestamps.frameNumber] = workingFrame;
 	logger->debug4("Inserted new working frame " YERFACE_FRAMENUMBER_FORMAT " into frame store. Frame store size is now %lu", workingFrame->frameTimestamps.frameNumber, frameStore.size());
+	YerFace_MutexUnlock(myMutex);
 
-	setFrameStatus(workingFrame->frameTimestamps, FRAME_STATUS_NEW);
-
-	metrics->endClock(tick);
+	setFrameStatus(workingFrame, FRAME_STATUS_NEW);
 
-	if(workerPool != NULL) {
-		workerPool->sendWorkerSignal();
+	// With no checkpoints registered for FRAME_STATUS_NEW, nobody else will ever tell the herder this frame is ready.
+	if(statusCheckpointMasks[FRAME_STATUS_NEW] == 0) {
+		YerFace_MutexLock(myMutex);
+		readyFrames.push_back(workingFrame);
+		YerFace_MutexUnlock(myMutex);
+		if(workerPool != NULL) {
+			workerPool->sendWorkerSignal();
+		}
 	}
-	YerFace_MutexUnlock(myMutex);
+
+	metrics->endClock(tick);
 }
 
 void FrameServer::setDraining(void) {
@@ -200,46 +234,111 @@ void FrameServer::setMirrorMode(bool myMirrorMode) {
 	YerFace_MutexUnlock(myMutex);
 }
 
+void FrameServer::setFFmpegDriver(FFmpegDriver *myFFmpegDriver) {
+	if(myFFmpegDriver == NULL) {
+		throw invalid_argument("ffmpegDriver cannot be NULL");
+	}
+	YerFace_MutexLock(myMutex);
+	ffmpegDriver = myFFmpegDriver;
+	YerFace_MutexUnlock(myMutex);
+}
+
+double FrameServer::getDetectionScaleFactor(Size myFrameSize) {
+	if(detectionBoundingBox > 0) {
+		if(myFrameSize.width >= myFrameSize.height) {
+			return (double)detectionBoundingBox / (double)myFrameSize.width;
+		}
+		return (double)detectionBoundingBox / (double)myFrameSize.height;
+	}
+	return detectionScaleFactor;
+}
+
+Size FrameServer::getDetectionFrameSize(Size myFrameSize) {
+	//Matches the destination size cv::resize() computes for a given scale factor.
+	double scaleFactor = getDetectionScaleFactor(myFrameSize);
+	return Size(saturate_cast<int>(myFrameSize.width * scaleFactor), saturate_cast<int>(myFrameSize.height * scaleFactor));
+}
+
+bool FrameServer::getDetectionGrayscale(void) {
+	return detectionGrayscale;
+}
+
 WorkingFrame *FrameServer::getWorkingFrame(FrameNumber frameNumber) {
 	YerFace_MutexLock(myMutex);
-	auto frameIter = frameStore.find(frameNumber);
-	if(frameIter == frameStore.end()) {
+	WorkingFrame **workingFrame = frameStore.find(frameNumber);
+	if(workingFrame == NULL) {
 		YerFace_MutexUnlock(myMutex);
 		throw runtime_error("getWorkingFrame() called, but the referenced frame does not exist in the frame store!");
 	}
+	WorkingFrame *result = *workingFrame;
 	YerFace_MutexUnlock(myMutex);
-	return frameIter->second;
+	return result;
 }
 
-void FrameServer::setWorkingFrameStatusCheckpoint(FrameNumber frameNumber, WorkingFrameStatus status, string checkpointKey) {
-	checkStatusValue(status);
+cv::Mat FrameServer::getWorkingFramePreview(FrameNumber frameNumber) {
 	YerFace_MutexLock(myMutex);
-	WorkingFrame *frame;
+	WorkingFrame *workingFrame;
 	try {
-		frame = getWorkingFrame(frameNumber);
+		workingFrame = getWorkingFrame(frameNumber);
 	} catch(exception &e) {
 		logger->err("Caught exception: %s ... Rethrowing!", e.what());
 		YerFace_MutexUnlock(myMutex);
 		throw;
 	}
-	if(status != frame->status) {
+	if(workingFrame->status > FRAME_STATUS_PREVIEW_DISPLAY || workingFrame->frame.empty()) {
 		YerFace_MutexUnlock(myMutex);
-		throw logic_error("Trying to set a checkpoint on a status for a frame whose current status does not match!");
+		throw logic_error("getWorkingFramePreview() called, but the frame bitmap has already been released!");
 	}
-	auto checkpointIter = frame->checkpoints[status].find(checkpointKey);
-	if(checkpointIter == frame->checkpoints[status].end()) {
-		YerFace_MutexUnlock(myMutex);
+	bool myMirrorMode = mirrorMode;
+	cv::Mat frame = workingFrame->frame;
+	YerFace_MutexUnlock(myMutex);
+
+	// The preview copy is made on demand, because the frame itself is only a read-only view into the decoder's frame backing.
+	cv::Mat previewFrame;
+	if(myMirrorMode) {
+		cv::flip(frame, previewFrame, 1);
+	} else {
+		previewFrame = frame.clone();
+	}
+	return previewFrame;
+}
+
+void FrameServer::setWorkingFrameStatusCheckpoint(FrameNumber frameNumber, WorkingFrameStatus status, FrameStatusCheckpoint checkpoint) {
+	checkStatusValue(status);
+	if(checkpoint >= FRAME_STATUS_MAX_CHECKPOINTS) {
+		throw invalid_argument("passed invalid FrameStatusCheckpoint!");
+	}
+	// statusCheckpointMasks is frozen once frames are flowing, so it's safe to read without the lock.
+	uint64_t checkpointBit = (uint64_t)1 << checkpoint;
+	uint64_t requiredMask = statusCheckpointMasks[status];
+	if(!(requiredMask & checkpointBit)) {
 		throw logic_error("Trying to set a checkpoint on a status for a frame but that checkpoint was never registered!");
 	}
-	if(checkpointIter->second) {
-		YerFace_MutexUnlock(myMutex);
+	WorkingFrame *frame;
+	try {
+		frame = getWorkingFrame(frameNumber);
+	} catch(exception &e) {
+		logger->err("Caught exception: %s ... Rethrowing!", e.what());
+		throw;
+	}
+	// The frame can't leave this status until our bit is set, so this check can't race with the herder.
+	if(status != frame->status) {
+		throw logic_error("Trying to set a checkpoint on a status for a frame whose current status does not match!");
+	}
+	uint64_t previousMask = frame->checkpoints[status].fetch_or(checkpointBit);
+	if(previousMask & checkpointBit) {
 		throw logic_error("Trying to set a checkpoint on a status for a frame, but the checkpoint was already set!");
 	}
-	frame->checkpoints[status][checkpointKey] = true;
-	if(workerPool != NULL) {
-		workerPool->sendWorkerSignal();
+
+	// Whoever completes the last checkpoint is responsible for handing the frame to the herder.
+	if((previousMask | checkpointBit) == requiredMask) {
+		YerFace_MutexLock(myMutex);
+		readyFrames.push_back(frame);
+		YerFace_MutexUnlock(myMutex);
+		if(workerPool != NULL) {
+			workerPool->sendWorkerSignal();
+		}
 	}
-	YerFace_MutexUnlock(myMutex);
 }
 
 bool FrameServer::isDrained(void) {
@@ -253,7 +352,7 @@ bool FrameServer::isDrained(void) {
 
 void FrameServer::destroyFrame(FrameNumber frameNumber) {
 	logger->debug4("Cleaning up GONE Frame #" YERFACE_FRAMENUMBER_FORMAT " ...", frameNumber);
-	SDL_DestroyMutex(frameStore[frameNumber]->previewFrameMutex);
+	releaseFrameBacking(frameStore[frameNumber]);
 	delete frameStore[frameNumber];
 	frameStore.erase(frameNumber);
 
@@ -264,15 +363,36 @@ void FrameServer::destroyFrame(FrameNumber frameNumber) {
 	}
 }
 
-void FrameServer::setFrameStatus(FrameTimestamps frameTimestamps, WorkingFrameStatus newStatus) {
+VideoFrameBacking *FrameServer::leaseFrameBacking(WorkingFrame *workingFrame) {
+	//NOTE: The caller must be holding up the frame's status (with an incomplete checkpoint) so it can't release its own lease while we take ours.
+	if(workingFrame->frameBacking == NULL) {
+		throw logic_error("Tried to lease the frame backing of a frame which has already released it!");
+	}
+	ffmpegDriver->acquireVideoFrameBacking(workingFrame->frameBacking);
+	return workingFrame->frameBacking;
+}
+
+void FrameServer::releaseFrameBackingLease(VideoFrameBacking *backing) {
+	ffmpegDriver->releaseVideoFrameBacking(backing);
+}
+
+void FrameServer::releaseFrameBacking(WorkingFrame *workingFrame) {
+	workingFrame->frame.release();
+	if(workingFrame->frameBacking != NULL) {
+		ffmpegDriver->releaseVideoFrameBacking(workingFrame->frameBacking);
+		workingFrame->frameBacking = NULL;
+	}
+}
+
+void FrameServer::setFrameStatus(WorkingFrame *workingFrame, WorkingFrameStatus newStatus) {
 	checkStatusValue(newStatus);
-	YerFace_MutexLock(myMutex);
-	frameStore[frameTimestamps.frameNumber]->status = newStatus;
+	workingFrame->status = newStatus;
+	FrameTimestamps frameTimestamps = workingFrame->frameTimestamps;
 	logger->debug4("Setting Frame #" YERFACE_FRAMENUMBER_FORMAT " Status to %d ...", frameTimestamps.frameNumber, newStatus);
-	for(auto callback : onFrameStatusChangeCallbacks[newStatus]) {
+	// NOTE: Callbacks are dispatched WITHOUT holding myMutex. (The callback lists are frozen once frames are flowing.)
+	for(auto &callback : onFrameStatusChangeCallbacks[newStatus]) {
 		callback.callback(callback.userdata, newStatus, frameTimestamps);
 	}
-	YerFace_MutexUnlock(myMutex);
 }
 
 void FrameServer::checkStatusValue(WorkingFrameStatus status) {
@@ -284,56 +404,44 @@ void FrameServer::checkStatusValue(WorkingFrameStatus status) {
 bool FrameServer::workerHandler(WorkerPoolWorker *worker) {
 	FrameServer *self = (FrameServer *)worker->ptr;
 
-	bool didWork = false;
-	std::list<FrameNumber> garbageFrames;
-
+	//// CHECK FOR WORK ////
+	std::list<WorkingFrame *> frames;
 	YerFace_MutexLock(self->myMutex);
+	frames.swap(self->readyFrames);
+	YerFace_MutexUnlock(self->myMutex);
 
-	// self->logger->verbose("Frame Herder Top-of-loop. FrameStore size: %lu", self->frameStore.size());
-	for(auto framePair : self->frameStore) {
-		FrameNumber frameNumber = framePair.first;
-		WorkingFrame *workingFrame = framePair.second;
-		WorkingFrameStatus status = workingFrame->status;
-
-		//Does this frame need to be garbage collected?
-		if(status == FRAME_STATUS_GONE) {
-			didWork = true;
-			garbageFrames.push_back(frameNumber);
-			continue;
-		}
+	if(frames.size() == 0) {
+		return false;
+	}
 
-		//Is this frame eligible for a new status?
-		bool checkpointsPassed = true;
-		for(auto checkpointPair : workingFrame->checkpoints[status]) {
-			if(!checkpointPair.second) {
-				checkpointsPassed = false;
-			}
-		}
+	//// DO THE WORK ////
+	for(WorkingFrame *workingFrame : frames) {
+		WorkingFrameStatus status = workingFrame->status;
 
-		//Advance this frame to the next status.
-		if(checkpointsPassed) {
+		//Advance this frame, skipping straight through any statuses which have no checkpoints registered.
+		do {
 			// NOTE: We release image mats after PREVIEW_DISPLAY to prevent unbounded RAM usage
 			// when Sphinx holds frames in LATE_PROCESSING for an indeterminate amount of time.
+			// This is also the point where the frame backing lease goes back to FFmpegDriver's pool.
 			if(status == FRAME_STATUS_PREVIEW_DISPLAY) {
-				workingFrame->frame.release();
+				YerFace_MutexLock(self->myMutex);
+				self->releaseFrameBacking(workingFrame);
 				workingFrame->detectionFrame.release();
-				workingFrame->previewFrame.release();
+				YerFace_MutexUnlock(self->myMutex);
 			}
+			status = (WorkingFrameStatus)(status + 1);
+			self->setFrameStatus(workingFrame, status);
+		} while(status != FRAME_STATUS_GONE && self->statusCheckpointMasks[status] == 0);
 
-			didWork = true;
-			self->setFrameStatus(workingFrame->frameTimestamps, (WorkingFrameStatus)(status + 1));
+		//Destroy GONE frames.
+		if(status == FRAME_STATUS_GONE) {
+			YerFace_MutexLock(self->myMutex);
+			self->destroyFrame(workingFrame->frameTimestamps.frameNumber);
+			YerFace_MutexUnlock(self->myMutex);
 		}
 	}
 
-	//Destroy GONE frames.
-	while(garbageFrames.size() > 0) {
-		self->destroyFrame(garbageFrames.front());
-		garbageFrames.pop_front();
-	}
-
-	YerFace_MutexUnlock(self->myMutex);
-
-	return didWork;
+	return true;
 }
 
 void FrameServer::workerDeinitializer(WorkerPoolWorker *worker, void *usrPtr) {
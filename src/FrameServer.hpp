@@ -8,6 +8,10 @@
 #include "WorkerPool.hpp"
 
 #include <list>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 
 #include "SDL.h"
 
@@ -19,7 +23,187 @@ namespace YerFace {
 
 #define YERFACE_FRAMESERVER_MAX_QUEUEDEPTH 200
 
+//FrameSlotRing is a frame-indexed container for per-frame state. Frame numbers map directly onto a power-of-two ring of slots,
+//so lookups are O(1) with no hashing, and slots are allocated up front and recycled, so there's no per-frame allocator churn.
+//The ring is sized to hold a full FrameServer queue. If the span of live frame numbers ever outgrows the ring (for example,
+//offline runs where Sphinx holds frames in LATE_PROCESSING) the ring doubles. Slots are never reallocated, so references and
+//pointers to values stay valid until that frame is erased. NOT thread safe; callers provide their own locking.
+template <class T>
+class FrameSlotRing {
+public:
+	class Slot {
+	public:
+		bool occupied;
+		FrameNumber frameNumber;
+		T value;
+	};
+
+	class Iterator {
+	public:
+		Iterator(FrameSlotRing<T> *myRing, FrameNumber myFrameNumber) {
+			ring = myRing;
+			frameNumber = myFrameNumber;
+			seek();
+		}
+		std::pair<const FrameNumber, T &> operator*() const {
+			return std::pair<const FrameNumber, T &>(frameNumber, ring->slotFor(frameNumber)->value);
+		}
+		Iterator &operator++() {
+			frameNumber++;
+			seek();
+			return *this;
+		}
+		bool operator!=(const Iterator &other) const {
+			return frameNumber != other.frameNumber;
+		}
+	private:
+		void seek(void) {
+			while(frameNumber <= ring->highest && !ring->holds(frameNumber)) {
+				frameNumber++;
+			}
+		}
+		FrameSlotRing<T> *ring;
+		FrameNumber frameNumber;
+	};
+
+	FrameSlotRing(size_t myCapacity = YERFACE_FRAMESERVER_MAX_QUEUEDEPTH) {
+		capacity = 1;
+		while(capacity < myCapacity) {
+			capacity = capacity << 1;
+		}
+		slots.resize(capacity, NULL);
+		for(size_t i = 0; i < capacity; i++) {
+			slots[i] = new Slot();
+			slots[i]->occupied = false;
+		}
+		count = 0;
+		lowest = 0;
+		highest = -1;
+	}
+	~FrameSlotRing() {
+		for(Slot *slot : slots) {
+			delete slot;
+		}
+	}
+	FrameSlotRing(const FrameSlotRing<T> &) = delete;
+	FrameSlotRing<T> &operator=(const FrameSlotRing<T> &) = delete;
+
+	//Like unordered_map::operator[], this inserts a value-initialized T if the frame isn't present yet.
+	T &operator[](FrameNumber frameNumber) {
+		T *value = find(frameNumber);
+		if(value != NULL) {
+			return *value;
+		}
+		if(count == 0) {
+			lowest = frameNumber;
+			highest = frameNumber;
+		} else {
+			lowest = std::min(lowest, frameNumber);
+			highest = std::max(highest, frameNumber);
+			if((size_t)(highest - lowest + 1) > capacity) {
+				grow((size_t)(highest - lowest + 1));
+			}
+		}
+		Slot *slot = slotFor(frameNumber);
+		slot->occupied = true;
+		slot->frameNumber = frameNumber;
+		slot->value = T();
+		count++;
+		return slot->value;
+	}
+	T *find(FrameNumber frameNumber) {
+		if(!holds(frameNumber)) {
+			return NULL;
+		}
+		return &slotFor(frameNumber)->value;
+	}
+	bool contains(FrameNumber frameNumber) {
+		return holds(frameNumber);
+	}
+	void erase(FrameNumber frameNumber) {
+		if(!holds(frameNumber)) {
+			return;
+		}
+		Slot *slot = slotFor(frameNumber);
+		slot->occupied = false;
+		slot->value = T(); //Release anything the value was holding onto.
+		count--;
+		if(count == 0) {
+			lowest = 0;
+			highest = -1;
+			return;
+		}
+		while(!holds(lowest)) {
+			lowest++;
+		}
+		while(!holds(highest)) {
+			highest--;
+		}
+	}
+	void clear(void) {
+		for(Slot *slot : slots) {
+			slot->occupied = false;
+			slot->value = T();
+		}
+		count = 0;
+		lowest = 0;
+		highest = -1;
+	}
+	size_t size(void) {
+		return count;
+	}
+	Iterator begin(void) {
+		return Iterator(this, lowest);
+	}
+	Iterator end(void) {
+		return Iterator(this, highest + 1);
+	}
+private:
+	Slot *slotFor(FrameNumber frameNumber) {
+		return slots[(size_t)frameNumber & (capacity - 1)];
+	}
+	bool holds(FrameNumber frameNumber) {
+		Slot *slot = slotFor(frameNumber);
+		return slot->occupied && slot->frameNumber == frameNumber;
+	}
+	void grow(size_t span) {
+		size_t newCapacity = capacity;
+		while(newCapacity < span) {
+			newCapacity = newCapacity << 1;
+		}
+		std::vector<Slot *> newSlots(newCapacity, NULL);
+		std::vector<Slot *> spareSlots;
+		for(Slot *slot : slots) {
+			if(slot->occupied) {
+				newSlots[(size_t)slot->frameNumber & (newCapacity - 1)] = slot;
+			} else {
+				spareSlots.push_back(slot);
+			}
+		}
+		for(size_t i = 0; i < newCapacity; i++) {
+			if(newSlots[i] == NULL) {
+				if(spareSlots.size() > 0) {
+					newSlots[i] = spareSlots.back();
+					spareSlots.pop_back();
+				} else {
+					newSlots[i] = new Slot();
+					newSlots[i]->occupied = false;
+				}
+			}
+		}
+		slots.swap(newSlots);
+		capacity = newCapacity;
+	}
+
+	std::vector<Slot *> slots;
+	size_t capacity;
+	size_t count;
+	FrameNumber lowest, highest;
+};
+
 class VideoFrame;
+class VideoFrameBacking;
+class FFmpegDriver;
 class WorkerPool;
 class WorkerPoolWorker;
 
@@ -36,17 +220,19 @@ enum WorkingFrameStatus: unsigned int {
 	FRAME_STATUS_GONE = 8 //This frame is about to be freed and purged from the frame store. (No checkpoints can be registered for this status!)
 };
 
+#define FRAME_STATUS_MAX_CHECKPOINTS 64
+typedef unsigned int FrameStatusCheckpoint; //Bit index into WorkingFrame::checkpoints, as returned by FrameServer::registerFrameStatusCheckpoint()
+
 class WorkingFrame {
 public:
-	cv::Mat frame; //BGR format, at the native resolution of the input.
-	cv::Mat detectionFrame; //BGR, scaled down to DetectionScaleFactor.
+	cv::Mat frame; //BGR format, at the native resolution of the input. (Not a copy! This is a view into frameBacking, so treat it as READ ONLY.)
+	VideoFrameBacking *frameBacking; //Our lease on the FFmpegDriver frame backing. Returned to the pool after PREVIEW_DISPLAY.
+	cv::Mat detectionFrame; //BGR (or grayscale, if FrameServer detectionGrayscale is set), scaled down to DetectionScaleFactor. Usually a view into frameBacking, so treat it as READ ONLY.
 	double detectionScaleFactor;
-	cv::Mat previewFrame; //BGR, same as the input frame, but possibly with some HUD stuff scribbled onto it.
-	SDL_mutex *previewFrameMutex; //IMPORTANT - make sure you lock previewFrameMutex before WRITING TO or READING FROM previewFrame.
 	FrameTimestamps frameTimestamps;
 
-	WorkingFrameStatus status;
-	unordered_map<string, bool> checkpoints[FRAME_STATUS_MAX + 1];
+	std::atomic<WorkingFrameStatus> status; //Only advanced by the FrameServer.Herder worker.
+	std::atomic<uint64_t> checkpoints[FRAME_STATUS_MAX + 1]; //Bitmask of completed checkpoints for each status.
 };
 
 class FrameStatusChangeEventCallback {
@@ -68,36 +254,50 @@ public:
 	~FrameServer() noexcept(false);
 	void setDraining(void);
 	void setMirrorMode(bool myMirrorMode);
+	void setFFmpegDriver(FFmpegDriver *myFFmpegDriver);
 	void onFrameServerDrainedEvent(FrameServerDrainedEventCallback callback);
 	void onFrameStatusChangeEvent(FrameStatusChangeEventCallback callback);
-	void registerFrameStatusCheckpoint(WorkingFrameStatus status, string checkpointKey);
+	FrameStatusCheckpoint registerFrameStatusCheckpoint(WorkingFrameStatus status, string checkpointKey);
 	void insertNewFrame(VideoFrame *videoFrame);
+	double getDetectionScaleFactor(cv::Size myFrameSize);
+	cv::Size getDetectionFrameSize(cv::Size myFrameSize);
+	bool getDetectionGrayscale(void);
 	WorkingFrame *getWorkingFrame(FrameNumber frameNumber);
-	void setWorkingFrameStatusCheckpoint(FrameNumber frameNumber, WorkingFrameStatus status, string checkpointKey);
+	VideoFrameBacking *leaseFrameBacking(WorkingFrame *workingFrame);
+	void releaseFrameBackingLease(VideoFrameBacking *backing);
+	cv::Mat getWorkingFramePreview(FrameNumber frameNumber);
+	void setWorkingFrameStatusCheckpoint(FrameNumber frameNumber, WorkingFrameStatus status, FrameStatusCheckpoint checkpoint);
 private:
 	bool isDrained(void);
 	void destroyFrame(FrameNumber frameNumber);
-	void setFrameStatus(FrameTimestamps frameTimestamps, WorkingFrameStatus newStatus);
+	void releaseFrameBacking(WorkingFrame *workingFrame);
+	void setFrameStatus(WorkingFrame *workingFrame, WorkingFrameStatus newStatus);
 	void checkStatusValue(WorkingFrameStatus status);
 	static bool workerHandler(WorkerPoolWorker *worker);
 	static void workerDeinitializer(WorkerPoolWorker *worker, void *usrPtr);
 
 	Status *status;
+	FFmpegDriver *ffmpegDriver;
 	bool lowLatency;
 	bool draining;
 	bool mirrorMode;
 	int detectionBoundingBox;
 	double detectionScaleFactor;
+	bool detectionGrayscale;
 	Logger *logger;
 	SDL_mutex *myMutex;
 	Metrics *metrics;
 	cv::Size frameSize;
 	bool frameSizeSet;
+	bool framesInserted;
+	bool reportedScale;
 
-	unordered_map<FrameNumber, WorkingFrame *> frameStore;
+	FrameSlotRing<WorkingFrame *> frameStore;
 
 	std::vector<FrameStatusChangeEventCallback> onFrameStatusChangeCallbacks[FRAME_STATUS_MAX + 1];
 	std::vector<string> statusCheckpoints[FRAME_STATUS_MAX + 1];
+	uint64_t statusCheckpointMasks[FRAME_STATUS_MAX + 1];
+	std::list<WorkingFrame *> readyFrames; //Frames whose checkpoints for the current status are all complete, waiting to be advanced by the herder.
 
 	std::vector<FrameServerDrainedEventCallback> onFrameServerDrainedCallbacks;
 
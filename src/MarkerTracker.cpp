@@ -60,7 +60,7 @@ MarkerTracker::MarkerTracker(json config, MarkerType myMarkerType, FaceMapper *m
 	previouslyReportedMarkerPoint.timestamp.estimatedEndTimestamp = -1.0;
 	previouslyReportedMarkerPoint.timestamp.frameNumber = -1;
 
-	if((myMutex = SDL_CreateMutex()) == NULL) {
+	if((myMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
 
@@ -79,7 +79,7 @@ MarkerTracker::~MarkerTracker() noexcept(false) {
 		}
 	}
 	YerFace_MutexUnlock(myStaticMutex);
-	SDL_DestroyMutex(myMutex);
+	YerFace_DestroyMutex(myMutex);
 	delete logger;
 }
 
@@ -402,7 +402,7 @@ MarkerPoint MarkerTracker::getMarkerPoint(FrameNumber frameNumber) {
 }
 
 vector<MarkerTracker *> MarkerTracker::markerTrackers;
-SDL_mutex *MarkerTracker::myStaticMutex = SDL_CreateMutex();
+SDL_mutex *MarkerTracker::myStaticMutex = YerFace_CreateMutex();
 
 vector<MarkerTracker *> MarkerTracker::getMarkerTrackers(void) {
 	YerFace_MutexLock(myStaticMutex);
@@ -61,7 +61,7 @@ private:
 	SDL_mutex *myMutex;
 	list<MarkerPoint> markerPointSmoothingBuffer;
 	MarkerPoint previouslyReportedMarkerPoint;
-	unordered_map<FrameNumber, MarkerPoint> markerPoints;
+	FrameSlotRing<MarkerPoint> markerPoints;
 };
 
 }; //namespace YerFace
@@ -26,7 +26,7 @@ Metrics::Metrics(json config, const char *myName, bool myMetricIsFrames) {
 	snprintf(fpsString, METRICS_STRING_LENGTH, "N/A");
 	string loggerName = "Metrics<" + name + ">";
 	logger = new Logger(loggerName.c_str());
-	if((myMutex = SDL_CreateMutex()) == NULL) {
+	if((myMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
 	logger->debug1("Metrics object constructed and ready to go!");
@@ -35,7 +35,7 @@ Metrics::Metrics(json config, const char *myName, bool myMetricIsFrames) {
 Metrics::~Metrics() noexcept(false) {
 	logger->debug1("Metrics object destructing...");
 	logReportNow("FINAL REPORT: ");
-	SDL_DestroyMutex(myMutex);
+	YerFace_DestroyMutex(myMutex);
 	delete logger;
 }
 
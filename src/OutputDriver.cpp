@@ -5,6 +5,9 @@
 #include <iostream>
 #include <cstring>
 #include <streambuf>
+#include <map>
+#include <deque>
+#include <vector>
 
 #define _WEBSOCKETPP_CPP11_STRICT_
 #define ASIO_STANDALONE
@@ -128,41 +131,90 @@ struct CustomWebsocketServerConfig : public websocketpp::config::asio {
 	transport_type;
 };
 
+enum OutputDriverWebSocketOverflowPolicy: unsigned int {
+	WEBSOCKET_OVERFLOW_DROP_OLDEST = 1,
+	WEBSOCKET_OVERFLOW_DISCONNECT = 2
+};
+
+class OutputDriverWebSocketMessage {
+public:
+	string payload;
+	websocketpp::frame::opcode::value opcode;
+	MetricsTick tick; //Started when the message was queued, so the client's metrics report how long messages wait on it.
+};
+
+//Each client gets its own bounded queue, so a slow or stuck client only ever costs itself frames.
+class OutputDriverWebSocketClient {
+public:
+	OutputDriverWebSocketClient(void);
+	~OutputDriverWebSocketClient() noexcept(false);
+
+	string name;
+	OutputFrameDeltaEncoder *deltaEncoder; //NULL unless this client negotiated the delta protocol.
+	std::deque<OutputDriverWebSocketMessage> sendQueue;
+	Metrics *lagMetrics;
+	unsigned long droppedMessages;
+	bool closing;
+};
+
 class OutputDriverWebSocketServer {
 public:
 	static int launchWebSocketServer(void* data);
+	bool serverOnValidate(websocketpp::connection_hdl handle);
+	void clientEnqueue(websocketpp::connection_hdl handle, OutputDriverWebSocketClient *client, const string &payload, websocketpp::frame::opcode::value opcode);
+	void clientFlush(websocketpp::connection_hdl handle, OutputDriverWebSocketClient *client);
+	void closePendingClients(void);
 	void serverOnOpen(websocketpp::connection_hdl handle);
 	void serverOnClose(websocketpp::connection_hdl handle);
 	void serverOnTimer(websocketpp::lib::error_code const &ec);
 	void serverSetQuitPollTimer(void);
 
 	OutputDriver *parent;
+	json config;
 
 	SDL_mutex *websocketMutex;
 	int websocketServerPort;
 	bool websocketServerEnabled;
+	bool deltaProtocolEnabled;
+	OutputFrameDeltaQuantization deltaQuantization;
+	size_t clientMaxQueuedMessages;
+	size_t clientMaxBufferedBytes;
+	OutputDriverWebSocketOverflowPolicy clientOverflowPolicy;
 	websocketpp::server<CustomWebsocketServerConfig> server;
-	std::set<websocketpp::connection_hdl,std::owner_less<websocketpp::connection_hdl>> connectionList;
+	std::map<websocketpp::connection_hdl,OutputDriverWebSocketClient *,std::owner_less<websocketpp::connection_hdl>> connectionList;
+	std::vector<websocketpp::connection_hdl> pendingCloses; //Clients to disconnect once websocketMutex is released.
 	bool websocketServerRunning;
 
 	SDL_Thread *serverThread;
 };
 
+OutputDriverWebSocketClient::OutputDriverWebSocketClient(void) {
+	deltaEncoder = NULL;
+	lagMetrics = NULL;
+	droppedMessages = 0;
+	closing = false;
+}
+
+OutputDriverWebSocketClient::~OutputDriverWebSocketClient() noexcept(false) {
+	if(deltaEncoder != NULL) {
+		delete deltaEncoder;
+	}
+	if(lagMetrics != NULL) {
+		delete lagMetrics;
+	}
+}
+
 bool OutputFrameContainer::isReady(void) {
 	if(!frameIsDraining) {
 		return false;
 	}
-	for(auto& waiting : waitingOn.items()) {
-		// fprintf(stderr, "FRAME WAITING ON %s?\n", waiting.key().c_str());
-		if(waiting.value()) {
-			return false;
-		}
-	}
-	return true;
+	return waitingOn == 0;
 }
 
 OutputDriver::OutputDriver(json config, string myOutputFilename, Status *myStatus, FrameServer *myFrameServer, FaceTracker *myFaceTracker, SDLDriver *mySDLDriver) {
 	workerPool = NULL;
+	lastFrameNumber = -1;
+	lateFrameWaitOn = 0;
 	outputFilename = myOutputFilename;
 	rawEventsPending.clear();
 	status = myStatus;
@@ -173,22 +225,19 @@ OutputDriver::OutputDriver(json config, string myOutputFilename, Status *myStatu
 	if(frameServer == NULL) {
 		throw invalid_argument("frameServer cannot be NULL");
 	}
-	faceTracker = myFaceTracker;
-	if(faceTracker == NULL) {
-		throw invalid_argument("faceTracker cannot be NULL");
-	}
+	faceTracker = myFaceTracker; //May be NULL in audio only mode, in which case frames never have a pose.
 	sdlDriver = mySDLDriver;
 	if(sdlDriver == NULL) {
 		throw invalid_argument("sdlDriver cannot be NULL");
 	}
 	eventLogger = NULL;
-	if((basisMutex = SDL_CreateMutex()) == NULL) {
+	if((basisMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
-	if((workerMutex = SDL_CreateMutex()) == NULL) {
+	if((workerMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
-	if((rawEventsMutex = SDL_CreateMutex()) == NULL) {
+	if((rawEventsMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
 
@@ -200,6 +249,9 @@ OutputDriver::OutputDriver(json config, string myOutputFilename, Status *myStatu
 	frameServer->onFrameServerDrainedEvent(frameServerDrainedCallback);
 
 	autoBasisTransmitted = false;
+	lastBasisFrameSet = false;
+	outputStartTime = -1.0;
+	outputEndTime = -1.0;
 	sdlDriver->onBasisFlagEvent([this] (void) -> void {
 		// Log the user-generated basis event, but don't try to assign it to a frame because we might not have one in our pipeline right now.
 		YerFace_MutexLock(this->rawEventsMutex);
@@ -260,10 +312,11 @@ OutputDriver::OutputDriver(json config, string myOutputFilename, Status *myStatu
 
 	webSocketServer = new OutputDriverWebSocketServer();
 	webSocketServer->parent = this;
+	webSocketServer->config = config;
 
 	webSocketServer->serverThread = NULL;
 	webSocketServer->websocketServerRunning = false;
-	if((webSocketServer->websocketMutex = SDL_CreateMutex()) == NULL) {
+	if((webSocketServer->websocketMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
 	webSocketServer->websocketServerPort = config["YerFace"]["OutputDriver"]["websocketServerPort"];
@@ -271,6 +324,38 @@ OutputDriver::OutputDriver(json config, string myOutputFilename, Status *myStatu
 		throw runtime_error("Server port is invalid");
 	}
 	webSocketServer->websocketServerEnabled = config["YerFace"]["OutputDriver"]["websocketServerEnabled"];
+	webSocketServer->deltaProtocolEnabled = config["YerFace"]["OutputDriver"]["websocketDeltaProtocol"]["enabled"];
+	webSocketServer->deltaQuantization.rotationStep = config["YerFace"]["OutputDriver"]["websocketDeltaProtocol"]["rotationStep"];
+	webSocketServer->deltaQuantization.translationStep = config["YerFace"]["OutputDriver"]["websocketDeltaProtocol"]["translationStep"];
+	webSocketServer->deltaQuantization.positionStep = config["YerFace"]["OutputDriver"]["websocketDeltaProtocol"]["positionStep"];
+	webSocketServer->deltaQuantization.phonemeStep = config["YerFace"]["OutputDriver"]["websocketDeltaProtocol"]["phonemeStep"];
+	webSocketServer->deltaQuantization.keyframeIntervalFrames = config["YerFace"]["OutputDriver"]["websocketDeltaProtocol"]["keyframeIntervalFrames"];
+	int clientMaxQueuedMessages = config["YerFace"]["OutputDriver"]["websocketClientQueue"]["maxQueuedMessages"];
+	if(clientMaxQueuedMessages < 1) {
+		throw invalid_argument("websocketClientQueue maxQueuedMessages cannot be less than one.");
+	}
+	webSocketServer->clientMaxQueuedMessages = (size_t)clientMaxQueuedMessages;
+	int clientMaxBufferedBytes = config["YerFace"]["OutputDriver"]["websocketClientQueue"]["maxBufferedBytes"];
+	if(clientMaxBufferedBytes < 1) {
+		throw invalid_argument("websocketClientQueue maxBufferedBytes cannot be less than one.");
+	}
+	webSocketServer->clientMaxBufferedBytes = (size_t)clientMaxBufferedBytes;
+	string clientOverflowPolicy = config["YerFace"]["OutputDriver"]["websocketClientQueue"]["overflowPolicy"];
+	if(clientOverflowPolicy == "dropOldest") {
+		webSocketServer->clientOverflowPolicy = WEBSOCKET_OVERFLOW_DROP_OLDEST;
+	} else if(clientOverflowPolicy == "disconnect") {
+		webSocketServer->clientOverflowPolicy = WEBSOCKET_OVERFLOW_DISCONNECT;
+	} else {
+		throw invalid_argument("websocketClientQueue overflowPolicy must be one of \"dropOldest\" or \"disconnect\".");
+	}
+	if(webSocketServer->deltaProtocolEnabled) {
+		//Fail early on a bad configuration, rather than when the first client connects.
+		OutputFrameDeltaEncoder validateQuantization(webSocketServer->deltaQuantization);
+	}
+
+	outputFileFormat = OutputFrameFormat::resolveFormat(config["YerFace"]["OutputDriver"]["outputFileFormat"]);
+	websocketFormat = OutputFrameFormat::resolveFormat(config["YerFace"]["OutputDriver"]["websocketFormat"]);
+	binaryHeader = OutputFrameFormat::encodeBinaryHeader(OutputFrameFormat::getBinarySchema());
 
 	//Constrain websocket server logs a bit for sanity.
 	webSocketServer->server.get_alog().clear_channels(log::alevel::all);
@@ -290,6 +375,9 @@ OutputDriver::OutputDriver(json config, string myOutputFilename, Status *myStatu
 		if(outputFilestream.fail()) {
 			throw invalid_argument("could not open outputFile for writing");
 		}
+		if(outputFileFormat == OUTPUT_FRAME_FORMAT_BINARY) {
+			outputFilestream << binaryHeader;
+		}
 	}
 
 	//We want to know when any frame has entered various statuses.
@@ -306,7 +394,7 @@ OutputDriver::OutputDriver(json config, string myOutputFilename, Status *myStatu
 	frameServer->onFrameStatusChangeEvent(frameStatusChangeCallback);
 
 	//We also want to introduce a checkpoint so that frames cannot TRANSITION AWAY from FRAME_STATUS_DRAINING without our blessing.
-	frameServer->registerFrameStatusCheckpoint(FRAME_STATUS_DRAINING, "outputDriver.ran");
+	drainingCheckpoint = frameServer->registerFrameStatusCheckpoint(FRAME_STATUS_DRAINING, "outputDriver.ran");
 
 	WorkerPoolParameters workerPoolParameters;
 	workerPoolParameters.name = "OutputDriver";
@@ -315,10 +403,10 @@ OutputDriver::OutputDriver(json config, string myOutputFilename, Status *myStatu
 	workerPoolParameters.initializer = NULL;
 	workerPoolParameters.deinitializer = NULL;
 	workerPoolParameters.usrPtr = (void *)this;
-	workerPoolParameters.handler = workerHandler;
+	workerPoolParameters.handler = NULL; //Output passes are submitted as tasks, whenever a frame drains or receives late data.
 	workerPool = new WorkerPool(config, status, frameServer, workerPoolParameters);
 
-	logger->debug1("OutputDriver object constructed and ready to go!");
+	logger->debug1("OutputDriver object constructed and ready to go! Output File Format: %s, WebSocket Format: %s", OutputFrameFormat::formatName(outputFileFormat), OutputFrameFormat::formatName(websocketFormat));
 };
 
 OutputDriver::~OutputDriver() noexcept(false) {
@@ -338,11 +426,14 @@ OutputDriver::~OutputDriver() noexcept(false) {
 		YerFace_MutexUnlock(webSocketServer->websocketMutex);
 		SDL_WaitThread(webSocketServer->serverThread, NULL);
 	}
+	for(auto connection : webSocketServer->connectionList) {
+		delete connection.second;
+	}
 
-	SDL_DestroyMutex(rawEventsMutex);
-	SDL_DestroyMutex(basisMutex);
-	SDL_DestroyMutex(webSocketServer->websocketMutex);
-	SDL_DestroyMutex(workerMutex);
+	YerFace_DestroyMutex(rawEventsMutex);
+	YerFace_DestroyMutex(basisMutex);
+	YerFace_DestroyMutex(webSocketServer->websocketMutex);
+	YerFace_DestroyMutex(workerMutex);
 
 	if(outputFilename.length() > 0 && outputFilestream.is_open()) {
 		outputFilestream.close();
@@ -367,12 +458,13 @@ void OutputDriver::setEventLogger(EventLogger *myEventLogger) {
 		}
 		this->logger->info("Received replayed Basis Flag event. Rebroadcasting...");
 		if((double)sourcePacket["meta"]["startTime"] < 0.0 || (FrameNumber)sourcePacket["meta"]["frameNumber"] < 0) {
-			sourcePacket["meta"]["frameNumber"] = -1;
-			sourcePacket["meta"]["startTime"] = -1.0;
+			OutputFrameRecord record = OutputFrameFormat::recordFromJSON(sourcePacket);
+			record.frameNumber = -1;
+			record.startTime = -1.0;
 			YerFace_MutexLock(this->basisMutex);
 			this->autoBasisTransmitted = true;
 			YerFace_MutexUnlock(this->basisMutex);
-			outputNewFrame(sourcePacket);
+			outputNewFrame(record);
 			return false;
 		}
 		FrameNumber frameNumber = (FrameNumber)sourcePacket["meta"]["frameNumber"];
@@ -390,12 +482,13 @@ void OutputDriver::setEventLogger(EventLogger *myEventLogger) {
 		}
 		FrameNumber frameNumber = (FrameNumber)sourcePacket["meta"]["frameNumber"];
 		YerFace_MutexLock(workerMutex);
-		if(pendingFrames[frameNumber].frame.find("controller") == pendingFrames[frameNumber].frame.end()) {
-			pendingFrames[frameNumber].frame["controller"] = eventPayload;
+		json &extra = pendingFrames[frameNumber].record.extra;
+		if(extra.find("controller") == extra.end()) {
+			extra["controller"] = eventPayload;
 		} else {
-			if(pendingFrames[frameNumber].frame["controller"].is_array() && eventPayload.is_array()) {
+			if(extra["controller"].is_array() && eventPayload.is_array()) {
 				for(json controllerEvent : eventPayload) {
-					pendingFrames[frameNumber].frame["controller"].push_back(controllerEvent);
+					extra["controller"].push_back(controllerEvent);
 				}
 			} else {
 				throw logic_error("trying to apply controller data multiple times for the same frame, but not using arrays?!");
@@ -410,111 +503,176 @@ void OutputDriver::setEventLogger(EventLogger *myEventLogger) {
 void OutputDriver::handleNewBasisEvent(FrameNumber frameNumber) {
 	logger->debug1("Got a Basis Flag event for Frame #%lu. Handling...", frameNumber);
 	YerFace_MutexLock(workerMutex);
-	pendingFrames[frameNumber].frame["meta"]["basis"] = true;
+	pendingFrames[frameNumber].record.basis = true;
 	YerFace_MutexUnlock(workerMutex);
 }
 
 void OutputDriver::handleOutputFrame(OutputFrameContainer *outputFrame) {
-	// outputFrame->frame["meta"] = json::object();
-	outputFrame->frame["meta"]["frameNumber"] = outputFrame->frameTimestamps.frameNumber;
-	outputFrame->frame["meta"]["startTime"] = outputFrame->frameTimestamps.startTimestamp;
-	if(outputFrame->frame["meta"].find("basis") == outputFrame->frame["meta"].end()) {
-		//Default basis unless set earlier.
-		outputFrame->frame["meta"]["basis"] = false;
-	}
+	OutputFrameRecord *record = &outputFrame->record;
+	record->frameNumber = outputFrame->frameTimestamps.frameNumber;
+	record->startTime = outputFrame->frameTimestamps.startTimestamp;
 
 	bool allPropsSet = true;
-	FacialPose facialPose = faceTracker->getFacialPose(outputFrame->frameTimestamps.frameNumber);
+	FacialPose facialPose;
+	facialPose.set = false;
+	if(faceTracker != NULL) {
+		facialPose = faceTracker->getFacialPose(outputFrame->frameTimestamps.frameNumber);
+	}
 	if(facialPose.set) {
-		outputFrame->frame["pose"] = json::object();
 		Vec3d angles = Utilities::rotationMatrixToEulerAngles(facialPose.rotationMatrix);
-		outputFrame->frame["pose"]["rotation"] = { {"x", angles[0]}, {"y", angles[1]}, {"z", angles[2]} };
-		outputFrame->frame["pose"]["translation"] = { {"x", facialPose.translationVector.at<double>(0)}, {"y", facialPose.translationVector.at<double>(1)}, {"z", facialPose.translationVector.at<double>(2)} };
+		record->poseSet = true;
+		for(int i = 0; i < 3; i++) {
+			record->poseRotation[i] = angles[i];
+			record->poseTranslation[i] = facialPose.translationVector.at<double>(i);
+		}
 	} else {
 		allPropsSet = false;
 	}
 
-	json trackers;
 	auto markerTrackers = MarkerTracker::getMarkerTrackers();
 	for(auto markerTracker : markerTrackers) {
 		MarkerPoint markerPoint = markerTracker->getMarkerPoint(outputFrame->frameTimestamps.frameNumber);
 		if(markerPoint.set) {
-			string trackerName = markerTracker->getMarkerType().toString();
-			trackers[trackerName.c_str()]["position"] = { {"x", markerPoint.point3d.x}, {"y", markerPoint.point3d.y}, {"z", markerPoint.point3d.z} };
+			int marker = (int)markerTracker->getMarkerType().type;
+			record->markerMask |= (uint32_t)1 << marker;
+			record->markers[marker][0] = markerPoint.point3d.x;
+			record->markers[marker][1] = markerPoint.point3d.y;
+			record->markers[marker][2] = markerPoint.point3d.z;
 		} else {
 			allPropsSet = false;
 		}
 	}
-	if(trackers.size()) {
-		outputFrame->frame["trackers"] = trackers;
-	}
 
 	YerFace_MutexLock(this->basisMutex);
 	if(allPropsSet && !autoBasisTransmitted) {
 		autoBasisTransmitted = true;
-		outputFrame->frame["meta"]["basis"] = true;
+		record->basis = true;
 		logger->info("All properties set. Transmitting initial basis flag automatically.");
 	}
-	if((bool)outputFrame->frame["meta"]["basis"]) {
+	if(record->basis) {
 		autoBasisTransmitted = true;
 		logger->info("Transmitting basis flag.");
 	}
 	YerFace_MutexUnlock(this->basisMutex);
-	
-	outputNewFrame(outputFrame->frame);
+
+	double startTime = outputFrame->frameTimestamps.startTimestamp;
+	if((outputStartTime >= 0.0 && startTime < outputStartTime) || (outputEndTime >= 0.0 && startTime >= outputEndTime)) {
+		logger->debug4("Frame #" YERFACE_FRAMENUMBER_FORMAT " at %.04lf is outside of the output time range. Dropping it.", outputFrame->frameTimestamps.frameNumber, startTime);
+		return;
+	}
+
+	outputNewFrame(*record);
 }
 
-void OutputDriver::registerFrameData(string key) {
+void OutputDriver::setOutputTimeRange(double startTime, double endTime) {
+	YerFace_MutexLock(basisMutex);
+	outputStartTime = startTime;
+	outputEndTime = endTime;
+	YerFace_MutexUnlock(basisMutex);
+}
+
+void OutputDriver::suppressAutoBasis(void) {
+	YerFace_MutexLock(basisMutex);
+	autoBasisTransmitted = true;
+	YerFace_MutexUnlock(basisMutex);
+}
+
+void OutputDriver::registerFrameData(OutputFrameDataType dataType) {
 	YerFace_MutexLock(workerMutex);
-	lateFrameWaitOn.push_back(key);
+	lateFrameWaitOn |= dataType;
 	YerFace_MutexUnlock(workerMutex);
 }
 
-void OutputDriver::insertFrameData(string key, json value, FrameNumber frameNumber) {
+void OutputDriver::insertFrameEvents(json events, FrameNumber frameNumber) {
 	YerFace_MutexLock(workerMutex);
-	if(pendingFrames.find(frameNumber) == pendingFrames.end()) {
+	OutputFrameRecord *record = getFrameRecordForInsertion(OUTPUT_FRAME_DATA_EVENTS, frameNumber);
+	record->extra["events"] = events;
+	YerFace_MutexUnlock(workerMutex);
+	if(workerPool != NULL) {
+		workerPool->submitTask(workerTask);
+	}
+}
+
+void OutputDriver::insertFramePhonemes(PrestonBlairPhonemes phonemes, FrameNumber frameNumber) {
+	YerFace_MutexLock(workerMutex);
+	OutputFrameRecord *record = getFrameRecordForInsertion(OUTPUT_FRAME_DATA_PHONEMES, frameNumber);
+	record->phonemes = phonemes;
+	record->phonemesSet = true;
+	YerFace_MutexUnlock(workerMutex);
+	if(workerPool != NULL) {
+		workerPool->submitTask(workerTask);
+	}
+}
+
+OutputFrameRecord *OutputDriver::getFrameRecordForInsertion(OutputFrameDataType dataType, FrameNumber frameNumber) {
+	//NOTE: Must be called while holding workerMutex.
+	if(!pendingFrames.contains(frameNumber)) {
 		throw runtime_error("Somebody is trying to insert frame data into a frame number which does not exist!");
 	}
-	if(pendingFrames[frameNumber].waitingOn.find(key) == pendingFrames[frameNumber].waitingOn.end()) {
+	if(!(lateFrameWaitOn & dataType)) {
 		throw runtime_error("Somebody is trying to insert frame data which was not previously registered!");
 	}
-	if(pendingFrames[frameNumber].waitingOn[key] != true) {
+	if(!(pendingFrames[frameNumber].waitingOn & dataType)) {
 		throw runtime_error("Somebody is trying to insert frame data which was already inserted!");
 	}
-	pendingFrames[frameNumber].frame[key] = value;
-	pendingFrames[frameNumber].waitingOn[key] = false;
-	YerFace_MutexUnlock(workerMutex);
+	pendingFrames[frameNumber].waitingOn &= ~(uint32_t)dataType;
+	return &pendingFrames[frameNumber].record;
 }
 
-void OutputDriver::outputNewFrame(json frame) {
-	if(frame["meta"]["basis"]) {
+void OutputDriver::outputNewFrame(const OutputFrameRecord &record) {
+	if(record.basis) {
 		YerFace_MutexLock(basisMutex);
-		lastBasisFrame = frame;
+		lastBasisFrame = record;
+		lastBasisFrameSet = true;
 		YerFace_MutexUnlock(basisMutex);
 	}
 
-	std::string jsonString;
-	jsonString = frame.dump(-1, ' ', true);
+	//Each representation is only built if some sink actually wants it.
+	bool fileEnabled = outputFilename.length() > 0;
+	std::string jsonString, binaryString;
+	//(Delta protocol clients get their own per-client encoding below.)
+	if((fileEnabled && outputFileFormat == OUTPUT_FRAME_FORMAT_JSON) || websocketFormat == OUTPUT_FRAME_FORMAT_JSON) {
+		jsonString = OutputFrameFormat::recordToJSON(record).dump(-1, ' ', true);
+	}
+	if((fileEnabled && outputFileFormat == OUTPUT_FRAME_FORMAT_BINARY) || websocketFormat == OUTPUT_FRAME_FORMAT_BINARY) {
+		binaryString = OutputFrameFormat::encodeBinaryFrame(record);
+	}
 
 	YerFace_MutexLock(webSocketServer->websocketMutex);
-	try {
-		for(auto handle : webSocketServer->connectionList) {
-			webSocketServer->server.send(handle, jsonString, websocketpp::frame::opcode::text);
+	for(auto connection : webSocketServer->connectionList) {
+		OutputDriverWebSocketClient *client = connection.second;
+		if(client->closing) {
+			continue;
+		}
+		if(client->deltaEncoder != NULL) {
+			webSocketServer->clientEnqueue(connection.first, client, client->deltaEncoder->encodeFrame(record), websocketpp::frame::opcode::binary);
+		} else if(websocketFormat == OUTPUT_FRAME_FORMAT_BINARY) {
+			webSocketServer->clientEnqueue(connection.first, client, binaryString, websocketpp::frame::opcode::binary);
+		} else {
+			webSocketServer->clientEnqueue(connection.first, client, jsonString, websocketpp::frame::opcode::text);
 		}
-	} catch (websocketpp::exception const &e) {
-		logger->err("Got a websocket exception: %s", e.what());
 	}
 	YerFace_MutexUnlock(webSocketServer->websocketMutex);
+	webSocketServer->closePendingClients();
 
-	if(outputFilename.length() > 0) {
-		outputFilestream << jsonString << "\n";
+	if(fileEnabled) {
+		if(outputFileFormat == OUTPUT_FRAME_FORMAT_BINARY) {
+			outputFilestream << binaryString;
+		} else {
+			outputFilestream << jsonString << "\n";
+		}
 	}
 }
 
+void OutputDriver::workerTask(WorkerPoolWorker *worker) {
+	//Output every frame we can, stopping at the first one still waiting on draining or late data.
+	while(workerHandler(worker));
+}
+
 bool OutputDriver::workerHandler(WorkerPoolWorker *worker) {
 	OutputDriver *self = (OutputDriver *)worker->ptr;
 
-	static FrameNumber lastFrameNumber = -1;
+	FrameNumber &lastFrameNumber = self->lastFrameNumber;
 	bool didWork = false;
 	OutputFrameContainer *outputFrame = NULL;
 	FrameNumber myFrameNumber = -1;
@@ -553,7 +711,7 @@ bool OutputDriver::workerHandler(WorkerPoolWorker *worker) {
 		outputFrame->outputProcessed = true;
 		YerFace_MutexUnlock(self->workerMutex);
 
-		self->frameServer->setWorkingFrameStatusCheckpoint(outputFrame->frameTimestamps.frameNumber, FRAME_STATUS_DRAINING, "outputDriver.ran");
+		self->frameServer->setWorkingFrameStatusCheckpoint(outputFrame->frameTimestamps.frameNumber, FRAME_STATUS_DRAINING, self->drainingCheckpoint);
 
 		didWork = true;
 	}
@@ -572,17 +730,12 @@ void OutputDriver::handleFrameStatusChange(void *userdata, WorkingFrameStatus ne
 			throw logic_error("Handler passed unsupported frame status change event!");
 		case FRAME_STATUS_NEW:
 			self->logger->debug4("handleFrameStatusChange() Frame #" YERFACE_FRAMENUMBER_FORMAT " appearing as new! Queue depth is now %lu", frameNumber, self->pendingFrames.size());
-			newOutputFrame.frame = json::object();
+			newOutputFrame.record = OutputFrameRecord();
 			newOutputFrame.outputProcessed = false;
 			newOutputFrame.frameIsDraining = false;
 			newOutputFrame.frameTimestamps = frameTimestamps;
-			newOutputFrame.frame = json::object();
 			YerFace_MutexLock(self->workerMutex);
-			newOutputFrame.waitingOn = json::object();
-			for(string waitOn : self->lateFrameWaitOn) {
-				// self->logger->verbose("WAITING ON: %s", waitOn.c_str());
-				newOutputFrame.waitingOn[waitOn] = true;
-			}
+			newOutputFrame.waitingOn = self->lateFrameWaitOn;
 			self->pendingFrames[frameNumber] = newOutputFrame;
 			YerFace_MutexUnlock(self->workerMutex);
 			break;
@@ -614,7 +767,7 @@ void OutputDriver::handleFrameStatusChange(void *userdata, WorkingFrameStatus ne
 					logEvent.payload = (json)true;
 				} else {
 					YerFace_MutexLock(self->workerMutex);
-					self->pendingFrames[frameNumber].frame[logEvent.eventName] = logEvent.payload;
+					self->pendingFrames[frameNumber].record.extra[logEvent.eventName] = logEvent.payload;
 					YerFace_MutexUnlock(self->workerMutex);
 				}
 
@@ -630,7 +783,7 @@ void OutputDriver::handleFrameStatusChange(void *userdata, WorkingFrameStatus ne
 			self->pendingFrames[frameNumber].frameIsDraining = true;
 			YerFace_MutexUnlock(self->workerMutex);
 			if(self->workerPool != NULL) {
-				self->workerPool->sendWorkerSignal();
+				self->workerPool->submitTask(workerTask);
 			}
 			break;
 		case FRAME_STATUS_GONE:
@@ -659,6 +812,7 @@ int OutputDriverWebSocketServer::launchWebSocketServer(void *data) {
 
 		self->server.init_asio();
 		self->server.set_reuse_addr(true);
+		self->server.set_validate_handler(bind(&OutputDriverWebSocketServer::serverOnValidate,self,::_1));
 		self->server.set_open_handler(bind(&OutputDriverWebSocketServer::serverOnOpen,self,::_1));
 		self->server.set_close_handler(bind(&OutputDriverWebSocketServer::serverOnClose,self,::_1));
 		self->serverSetQuitPollTimer();
@@ -676,21 +830,140 @@ int OutputDriverWebSocketServer::launchWebSocketServer(void *data) {
 	return 1;
 }
 
+bool OutputDriverWebSocketServer::serverOnValidate(websocketpp::connection_hdl handle) {
+	//Clients opt into the delta protocol by requesting it as a WebSocket subprotocol. Everyone else gets the default format.
+	if(!deltaProtocolEnabled) {
+		return true;
+	}
+	websocketpp::server<CustomWebsocketServerConfig>::connection_ptr connection = server.get_con_from_hdl(handle);
+	for(string subprotocol : connection->get_requested_subprotocols()) {
+		if(subprotocol == YERFACE_WEBSOCKET_DELTA_PROTOCOL) {
+			connection->select_subprotocol(subprotocol);
+			break;
+		}
+	}
+	return true;
+}
+
+void OutputDriverWebSocketServer::clientEnqueue(websocketpp::connection_hdl handle, OutputDriverWebSocketClient *client, const string &payload, websocketpp::frame::opcode::value opcode) {
+	//NOTE: Must be called while holding websocketMutex.
+	OutputDriverWebSocketMessage message;
+	message.payload = payload;
+	message.opcode = opcode;
+	message.tick = client->lagMetrics->startClock();
+	client->sendQueue.push_back(message);
+
+	if(client->sendQueue.size() > clientMaxQueuedMessages) {
+		if(clientOverflowPolicy == WEBSOCKET_OVERFLOW_DISCONNECT) {
+			parent->logger->warning("WebSocket client %s fell %lu messages behind. Disconnecting it.", client->name.c_str(), client->sendQueue.size());
+			client->closing = true;
+			client->sendQueue.clear();
+			//Closing can call back into serverOnClose(), which takes websocketMutex, so it waits for closePendingClients().
+			pendingCloses.push_back(handle);
+			return;
+		}
+		if(client->droppedMessages == 0) {
+			parent->logger->warning("WebSocket client %s is falling behind. Dropping its oldest messages.", client->name.c_str());
+		}
+		if(client->deltaEncoder != NULL) {
+			//Every queued delta depends on the ones before it, so after a gap none of them can be applied.
+			//Throw the whole queue away and get the client back in sync with a keyframe as the very next message.
+			client->droppedMessages += client->sendQueue.size();
+			client->sendQueue.clear();
+			client->deltaEncoder->requestKeyframe();
+			return;
+		}
+		while(client->sendQueue.size() > clientMaxQueuedMessages) {
+			client->sendQueue.pop_front();
+			client->droppedMessages++;
+		}
+	}
+	clientFlush(handle, client);
+}
+
+void OutputDriverWebSocketServer::clientFlush(websocketpp::connection_hdl handle, OutputDriverWebSocketClient *client) {
+	//NOTE: Must be called while holding websocketMutex.
+	//Messages are only handed to the library while the client's socket is keeping up. Anything else waits in our bounded queue.
+	try {
+		websocketpp::server<CustomWebsocketServerConfig>::connection_ptr connection = server.get_con_from_hdl(handle);
+		while(client->sendQueue.size() > 0 && connection->get_buffered_amount() < clientMaxBufferedBytes) {
+			OutputDriverWebSocketMessage &message = client->sendQueue.front();
+			connection->send(message.payload, message.opcode);
+			client->lagMetrics->endClock(message.tick);
+			client->sendQueue.pop_front();
+		}
+	} catch (websocketpp::exception const &e) {
+		parent->logger->err("Got a websocket exception sending to client %s: %s", client->name.c_str(), e.what());
+		client->closing = true;
+		client->sendQueue.clear();
+	}
+}
+
+void OutputDriverWebSocketServer::closePendingClients(void) {
+	//NOTE: Must be called WITHOUT holding websocketMutex.
+	std::vector<websocketpp::connection_hdl> closing;
+	YerFace_MutexLock(websocketMutex);
+	closing.swap(pendingCloses);
+	YerFace_MutexUnlock(websocketMutex);
+	for(websocketpp::connection_hdl handle : closing) {
+		websocketpp::lib::error_code ec;
+		server.close(handle, websocketpp::close::status::policy_violation, "Client fell too far behind.", ec);
+		if(ec) {
+			parent->logger->err("Failed closing WebSocket client: %s", ec.message().c_str());
+		}
+	}
+}
+
 void OutputDriverWebSocketServer::serverOnOpen(websocketpp::connection_hdl handle) {
+	websocketpp::server<CustomWebsocketServerConfig>::connection_ptr connection = server.get_con_from_hdl(handle);
+	OutputDriverWebSocketClient *client = new OutputDriverWebSocketClient();
+	client->name = connection->get_remote_endpoint();
+	string metricsName = "OutputDriver.WebSocketClient[" + client->name + "]";
+	client->lagMetrics = new Metrics(config, metricsName.c_str());
+	if(connection->get_subprotocol() == YERFACE_WEBSOCKET_DELTA_PROTOCOL) {
+		client->deltaEncoder = new OutputFrameDeltaEncoder(deltaQuantization);
+	}
+
 	YerFace_MutexLock(parent->basisMutex);
-	string jsonString = parent->lastBasisFrame.dump(-1, ' ', true);
+	OutputFrameRecord lastBasisFrame = parent->lastBasisFrame;
+	bool lastBasisFrameSet = parent->lastBasisFrameSet;
 	YerFace_MutexUnlock(parent->basisMutex);
 
 	YerFace_MutexLock(websocketMutex);
-	parent->logger->debug1("WebSocket Connection Opened.");
-	server.send(handle, jsonString, websocketpp::frame::opcode::text);
-	connectionList.insert(handle);
+	parent->logger->debug1("WebSocket Connection Opened: %s%s", client->name.c_str(), client->deltaEncoder != NULL ? " (Delta Protocol)" : "");
+	if(client->deltaEncoder != NULL) {
+		//Delta clients get a description of the protocol, then the basis frame (if any) as their first keyframe.
+		server.send(handle, client->deltaEncoder->describeProtocol(), websocketpp::frame::opcode::text);
+		if(lastBasisFrameSet) {
+			server.send(handle, client->deltaEncoder->encodeFrame(lastBasisFrame), websocketpp::frame::opcode::binary);
+		}
+	} else if(parent->websocketFormat == OUTPUT_FRAME_FORMAT_BINARY) {
+		//Binary clients need the schema before they can make sense of any frames.
+		server.send(handle, parent->binaryHeader, websocketpp::frame::opcode::binary);
+		if(lastBasisFrameSet) {
+			server.send(handle, OutputFrameFormat::encodeBinaryFrame(lastBasisFrame), websocketpp::frame::opcode::binary);
+		}
+	} else {
+		json lastBasisFrameJSON;
+		if(lastBasisFrameSet) {
+			lastBasisFrameJSON = OutputFrameFormat::recordToJSON(lastBasisFrame);
+		}
+		server.send(handle, lastBasisFrameJSON.dump(-1, ' ', true), websocketpp::frame::opcode::text);
+	}
+	connectionList[handle] = client;
 	YerFace_MutexUnlock(websocketMutex);
 }
 
 void OutputDriverWebSocketServer::serverOnClose(websocketpp::connection_hdl handle) {
 	YerFace_MutexLock(websocketMutex);
-	connectionList.erase(handle);
+	auto connection = connectionList.find(handle);
+	if(connection != connectionList.end()) {
+		if(connection->second->droppedMessages > 0) {
+			parent->logger->info("WebSocket client %s dropped %lu messages while connected.", connection->second->name.c_str(), connection->second->droppedMessages);
+		}
+		delete connection->second;
+		connectionList.erase(connection);
+	}
 	parent->logger->debug1("WebSocket Connection Closed.");
 	YerFace_MutexUnlock(websocketMutex);
 }
@@ -705,6 +978,13 @@ void OutputDriverWebSocketServer::serverOnTimer(websocketpp::lib::error_code con
 	if(!websocketServerRunning) {
 		server.stop();
 		continueTimer = false;
+	} else {
+		//Frames normally flush their own queues, but this catches up slow clients even when no new frames are arriving.
+		for(auto connection : connectionList) {
+			if(!connection.second->closing) {
+				clientFlush(connection.first, connection.second);
+			}
+		}
 	}
 	YerFace_MutexUnlock(websocketMutex);
 	if(continueTimer) {
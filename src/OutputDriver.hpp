@@ -9,6 +9,7 @@
 #include "Utilities.hpp"
 #include "Status.hpp"
 #include "WorkerPool.hpp"
+#include "OutputFrameFormat.hpp"
 
 #include <set>
 
@@ -22,14 +23,20 @@ class EventLogger;
 
 class OutputDriverWebSocketServer;
 
+//Late-arriving frame data which the OutputDriver must wait on before it can output a frame.
+enum OutputFrameDataType: uint32_t {
+	OUTPUT_FRAME_DATA_EVENTS = 0x01,
+	OUTPUT_FRAME_DATA_PHONEMES = 0x02
+};
+
 class OutputFrameContainer {
 public:
 	bool isReady(void);
 	bool frameIsDraining;
 	bool outputProcessed;
 	FrameTimestamps frameTimestamps;
-	json waitingOn;
-	json frame;
+	uint32_t waitingOn; //Bitmask of OutputFrameDataType which have not been inserted yet.
+	OutputFrameRecord record;
 };
 
 class OutputRawEvent {
@@ -45,37 +52,48 @@ public:
 	OutputDriver(json config, string myOutputFilename, Status *myStatus, FrameServer *myFrameServer, FaceTracker *myFaceTracker, SDLDriver *mySDLDriver);
 	~OutputDriver() noexcept(false);
 	void setEventLogger(EventLogger *myEventLogger);
-	void registerFrameData(string key);
-	void insertFrameData(string key, json value, FrameNumber frameNumber);
+	void registerFrameData(OutputFrameDataType dataType);
+	void insertFrameEvents(json events, FrameNumber frameNumber);
+	void insertFramePhonemes(PrestonBlairPhonemes phonemes, FrameNumber frameNumber);
+	void setOutputTimeRange(double startTime, double endTime = -1.0);
+	void suppressAutoBasis(void);
 private:
 	void handleNewBasisEvent(FrameNumber frameNumber);
 	void handleOutputFrame(OutputFrameContainer *outputFrame);
-	void outputNewFrame(json frame);
+	OutputFrameRecord *getFrameRecordForInsertion(OutputFrameDataType dataType, FrameNumber frameNumber);
+	void outputNewFrame(const OutputFrameRecord &record);
 	static bool workerHandler(WorkerPoolWorker *worker);
+	static void workerTask(WorkerPoolWorker *worker);
 	static void handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps);
 	static void handleFrameServerDrainedEvent(void *userdata);
 
 	string outputFilename;
 	Status *status;
 	FrameServer *frameServer;
+	FrameStatusCheckpoint drainingCheckpoint;
 	FaceTracker *faceTracker;
 	SDLDriver *sdlDriver;
 	EventLogger *eventLogger;
 	Logger *logger;
 
 	ofstream outputFilestream;
+	OutputFrameFormatType outputFileFormat, websocketFormat;
+	string binaryHeader;
 
 	OutputDriverWebSocketServer *webSocketServer;
 
 
 	SDL_mutex *basisMutex;
 	bool autoBasisTransmitted;
-	json lastBasisFrame;
+	OutputFrameRecord lastBasisFrame;
+	bool lastBasisFrameSet;
+	double outputStartTime, outputEndTime; //Frames starting outside of this range are processed but never output. Negative means unbounded.
 
 	WorkerPool *workerPool;
 	SDL_mutex *workerMutex;
-	list<string> lateFrameWaitOn;
-	unordered_map<FrameNumber, OutputFrameContainer> pendingFrames;
+	uint32_t lateFrameWaitOn; //Bitmask of registered OutputFrameDataType.
+	FrameSlotRing<OutputFrameContainer> pendingFrames;
+	FrameNumber lastFrameNumber;
 	bool frameServerDrained;
 
 	SDL_mutex *rawEventsMutex;
@@ -0,0 +1,577 @@
+
+#include "OutputFrameFormat.hpp"
+#include "MarkerType.hpp"
+
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <type_traits>
+
+using namespace std;
+
+namespace YerFace {
+
+template <typename T> static void appendValue(string &buffer, T value) {
+	buffer.append((const char *)&value, sizeof(T));
+}
+
+//The delta protocol goes out over the network to clients on any kind of machine, so unlike the binary file format it is always little-endian.
+template <typename T> static void appendLittleEndian(string &buffer, T value) {
+	typedef typename std::make_unsigned<T>::type UnsignedT;
+	UnsignedT bits = (UnsignedT)value;
+	for(size_t i = 0; i < sizeof(T); i++) {
+		buffer.push_back((char)(uint8_t)(bits >> (8 * i)));
+	}
+}
+
+static void appendLittleEndianDouble(string &buffer, double value) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	appendLittleEndian<uint64_t>(buffer, bits);
+}
+
+static void appendName(string &buffer, string name) {
+	if(name.length() > 255) {
+		throw logic_error("Binary format names cannot be longer than 255 characters.");
+	}
+	appendValue<uint8_t>(buffer, (uint8_t)name.length());
+	buffer.append(name);
+}
+
+template <typename T> static T consumeValue(const string &buffer, size_t *offset) {
+	T value;
+	if(*offset + sizeof(T) > buffer.size()) {
+		throw runtime_error("Binary frame record is truncated!");
+	}
+	memcpy(&value, buffer.data() + *offset, sizeof(T));
+	*offset += sizeof(T);
+	return value;
+}
+
+template <typename T> static T readValue(ifstream &filestream) {
+	T value;
+	filestream.read((char *)&value, sizeof(T));
+	if(filestream.gcount() != sizeof(T)) {
+		throw runtime_error("Binary event data header is truncated!");
+	}
+	return value;
+}
+
+static string readName(ifstream &filestream) {
+	uint8_t length = readValue<uint8_t>(filestream);
+	string name(length, '\0');
+	filestream.read(&name[0], length);
+	if(filestream.gcount() != length) {
+		throw runtime_error("Binary event data header is truncated!");
+	}
+	return name;
+}
+
+static const char *prestonBlairPhonemeNames[YERFACE_PRESTONBLAIR_PHONEME_COUNT] = { "AI", "E", "O", "U", "MBP", "FV", "L", "WQ", "etc" };
+
+PrestonBlairPhonemes::PrestonBlairPhonemes(void) {
+	for(int i = 0; i < YERFACE_PRESTONBLAIR_PHONEME_COUNT; i++) {
+		percent[i] = 0.0;
+	}
+}
+
+const char *PrestonBlairPhonemes::asString(int phoneme) {
+	if(phoneme < 0 || phoneme >= YERFACE_PRESTONBLAIR_PHONEME_COUNT) {
+		return "";
+	}
+	return prestonBlairPhonemeNames[phoneme];
+}
+
+int PrestonBlairPhonemes::fromString(string phonemeName) {
+	for(int i = 0; i < YERFACE_PRESTONBLAIR_PHONEME_COUNT; i++) {
+		if(phonemeName == prestonBlairPhonemeNames[i]) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+OutputFrameRecord::OutputFrameRecord(void) {
+	frameNumber = -1;
+	startTime = -1.0;
+	basis = false;
+	poseSet = false;
+	for(int i = 0; i < 3; i++) {
+		poseRotation[i] = 0.0;
+		poseTranslation[i] = 0.0;
+	}
+	markerMask = 0;
+	for(int i = 0; i < NoMarkerAssigned; i++) {
+		for(int j = 0; j < 3; j++) {
+			markers[i][j] = 0.0;
+		}
+	}
+	phonemesSet = false;
+	extra = json::object();
+}
+
+OutputFrameFormatType OutputFrameFormat::resolveFormat(string formatName) {
+	if(formatName == "json") {
+		return OUTPUT_FRAME_FORMAT_JSON;
+	} else if(formatName == "binary") {
+		return OUTPUT_FRAME_FORMAT_BINARY;
+	}
+	throw invalid_argument("Unsupported output format \"" + formatName + "\". Valid formats are: json, binary");
+}
+
+const char *OutputFrameFormat::formatName(OutputFrameFormatType format) {
+	switch(format) {
+		case OUTPUT_FRAME_FORMAT_JSON:
+			return "json";
+		case OUTPUT_FRAME_FORMAT_BINARY:
+			return "binary";
+	}
+	return "unknown";
+}
+
+OutputFrameBinarySchema OutputFrameFormat::getBinarySchema(void) {
+	OutputFrameBinarySchema schema;
+	for(int i = 0; i < NoMarkerAssigned; i++) {
+		schema.markers.push_back(MarkerType::asString((MarkerTypeEnum)i));
+	}
+	for(int i = 0; i < YERFACE_PRESTONBLAIR_PHONEME_COUNT; i++) {
+		schema.phonemes.push_back(PrestonBlairPhonemes::asString(i));
+	}
+	return schema;
+}
+
+string OutputFrameFormat::encodeBinaryHeader(OutputFrameBinarySchema schema) {
+	if(schema.markers.size() > 32) {
+		throw logic_error("Binary format marker set mask cannot describe more than 32 markers.");
+	}
+	string header;
+	header.append(YERFACE_BINARY_FORMAT_MAGIC, 4);
+	appendValue<uint32_t>(header, YERFACE_BINARY_FORMAT_VERSION);
+	appendValue<uint32_t>(header, YERFACE_BINARY_FORMAT_BYTE_ORDER_MARK);
+	appendValue<uint32_t>(header, (uint32_t)schema.markers.size());
+	for(string marker : schema.markers) {
+		appendName(header, marker);
+	}
+	appendValue<uint32_t>(header, (uint32_t)schema.phonemes.size());
+	for(string phoneme : schema.phonemes) {
+		appendName(header, phoneme);
+	}
+	return header;
+}
+
+string OutputFrameFormat::encodeBinaryFrame(const OutputFrameRecord &record) {
+	string bytes;
+	//Placeholder for the record length, which is filled in at the end.
+	appendValue<uint32_t>(bytes, 0);
+
+	appendValue<int64_t>(bytes, (int64_t)record.frameNumber);
+	appendValue<double>(bytes, record.startTime);
+	uint32_t flags = 0;
+	if(record.basis) {
+		flags |= YERFACE_BINARY_FRAME_FLAG_BASIS;
+	}
+	if(record.poseSet) {
+		flags |= YERFACE_BINARY_FRAME_FLAG_POSE;
+	}
+	if(record.phonemesSet) {
+		flags |= YERFACE_BINARY_FRAME_FLAG_PHONEMES;
+	}
+	appendValue<uint32_t>(bytes, flags);
+	appendValue<uint32_t>(bytes, record.markerMask);
+
+	for(int i = 0; i < 3; i++) {
+		appendValue<double>(bytes, record.poseRotation[i]);
+	}
+	for(int i = 0; i < 3; i++) {
+		appendValue<double>(bytes, record.poseTranslation[i]);
+	}
+	for(int i = 0; i < NoMarkerAssigned; i++) {
+		for(int j = 0; j < 3; j++) {
+			appendValue<double>(bytes, record.markers[i][j]);
+		}
+	}
+	for(int i = 0; i < YERFACE_PRESTONBLAIR_PHONEME_COUNT; i++) {
+		appendValue<double>(bytes, record.phonemes.percent[i]);
+	}
+
+	string extraString;
+	if(record.extra.size() > 0) {
+		extraString = record.extra.dump(-1, ' ', true);
+	}
+	appendValue<uint32_t>(bytes, (uint32_t)extraString.length());
+	bytes.append(extraString);
+
+	uint32_t recordLength = (uint32_t)(bytes.size() - sizeof(uint32_t));
+	memcpy(&bytes[0], &recordLength, sizeof(uint32_t));
+	return bytes;
+}
+
+OutputFrameRecord OutputFrameFormat::decodeBinaryFrame(const OutputFrameBinarySchema &schema, const string &bytes) {
+	OutputFrameRecord record;
+	size_t offset = 0;
+	record.frameNumber = (FrameNumber)consumeValue<int64_t>(bytes, &offset);
+	record.startTime = consumeValue<double>(bytes, &offset);
+	uint32_t flags = consumeValue<uint32_t>(bytes, &offset);
+	record.basis = (flags & YERFACE_BINARY_FRAME_FLAG_BASIS) ? true : false;
+	record.poseSet = (flags & YERFACE_BINARY_FRAME_FLAG_POSE) ? true : false;
+	record.phonemesSet = (flags & YERFACE_BINARY_FRAME_FLAG_PHONEMES) ? true : false;
+	uint32_t markerMask = consumeValue<uint32_t>(bytes, &offset);
+	for(int i = 0; i < 3; i++) {
+		record.poseRotation[i] = consumeValue<double>(bytes, &offset);
+	}
+	for(int i = 0; i < 3; i++) {
+		record.poseTranslation[i] = consumeValue<double>(bytes, &offset);
+	}
+
+	//The file's schema may have been written by a different version, so slots are matched up by name.
+	for(size_t i = 0; i < schema.markers.size(); i++) {
+		double position[3];
+		for(int j = 0; j < 3; j++) {
+			position[j] = consumeValue<double>(bytes, &offset);
+		}
+		if(!(markerMask & ((uint32_t)1 << i))) {
+			continue;
+		}
+		int marker = -1;
+		for(int k = 0; k < NoMarkerAssigned; k++) {
+			if(schema.markers[i] == MarkerType::asString((MarkerTypeEnum)k)) {
+				marker = k;
+				break;
+			}
+		}
+		if(marker < 0) {
+			record.extra["trackers"][schema.markers[i]]["position"] = { {"x", position[0]}, {"y", position[1]}, {"z", position[2]} };
+			continue;
+		}
+		record.markerMask |= (uint32_t)1 << marker;
+		for(int j = 0; j < 3; j++) {
+			record.markers[marker][j] = position[j];
+		}
+	}
+	for(size_t i = 0; i < schema.phonemes.size(); i++) {
+		double percent = consumeValue<double>(bytes, &offset);
+		if(!record.phonemesSet) {
+			continue;
+		}
+		int phoneme = PrestonBlairPhonemes::fromString(schema.phonemes[i]);
+		if(phoneme < 0) {
+			record.extra["phonemes"][schema.phonemes[i]] = percent;
+			continue;
+		}
+		record.phonemes.percent[phoneme] = percent;
+	}
+
+	uint32_t extraLength = consumeValue<uint32_t>(bytes, &offset);
+	if(offset + extraLength > bytes.size()) {
+		throw runtime_error("Binary frame record is truncated!");
+	}
+	if(extraLength > 0) {
+		json extra = json::parse(bytes.substr(offset, extraLength));
+		extra.update(record.extra);
+		record.extra = extra;
+	}
+	return record;
+}
+
+json OutputFrameFormat::recordToJSON(const OutputFrameRecord &record) {
+	json frame = record.extra;
+	if(!frame.is_object()) {
+		frame = json::object();
+	}
+	frame["meta"]["frameNumber"] = record.frameNumber;
+	frame["meta"]["startTime"] = record.startTime;
+	frame["meta"]["basis"] = record.basis;
+	if(record.poseSet) {
+		frame["pose"]["rotation"] = { {"x", record.poseRotation[0]}, {"y", record.poseRotation[1]}, {"z", record.poseRotation[2]} };
+		frame["pose"]["translation"] = { {"x", record.poseTranslation[0]}, {"y", record.poseTranslation[1]}, {"z", record.poseTranslation[2]} };
+	}
+	for(int i = 0; i < NoMarkerAssigned; i++) {
+		if(record.markerMask & ((uint32_t)1 << i)) {
+			frame["trackers"][MarkerType::asString((MarkerTypeEnum)i)]["position"] = { {"x", record.markers[i][0]}, {"y", record.markers[i][1]}, {"z", record.markers[i][2]} };
+		}
+	}
+	if(record.phonemesSet) {
+		for(int i = 0; i < YERFACE_PRESTONBLAIR_PHONEME_COUNT; i++) {
+			frame["phonemes"][PrestonBlairPhonemes::asString(i)] = record.phonemes.percent[i];
+		}
+	}
+	return frame;
+}
+
+OutputFrameRecord OutputFrameFormat::recordFromJSON(json frame) {
+	OutputFrameRecord record;
+	json meta = frame["meta"];
+	record.frameNumber = meta["frameNumber"];
+	record.startTime = meta["startTime"];
+	record.basis = meta.find("basis") != meta.end() && (bool)meta["basis"];
+	frame["meta"].erase("frameNumber");
+	frame["meta"].erase("startTime");
+	frame["meta"].erase("basis");
+	if(frame["meta"].size() == 0) {
+		frame.erase("meta");
+	}
+
+	if(frame.find("pose") != frame.end()) {
+		record.poseSet = true;
+		record.poseRotation[0] = frame["pose"]["rotation"]["x"];
+		record.poseRotation[1] = frame["pose"]["rotation"]["y"];
+		record.poseRotation[2] = frame["pose"]["rotation"]["z"];
+		record.poseTranslation[0] = frame["pose"]["translation"]["x"];
+		record.poseTranslation[1] = frame["pose"]["translation"]["y"];
+		record.poseTranslation[2] = frame["pose"]["translation"]["z"];
+		frame.erase("pose");
+	}
+
+	//Anything we don't have a slot for stays behind in the extra JSON.
+	for(int i = 0; i < NoMarkerAssigned; i++) {
+		const char *markerName = MarkerType::asString((MarkerTypeEnum)i);
+		if(frame.find("trackers") == frame.end() || frame["trackers"].find(markerName) == frame["trackers"].end()) {
+			continue;
+		}
+		json position = frame["trackers"][markerName]["position"];
+		record.markerMask |= (uint32_t)1 << i;
+		record.markers[i][0] = position["x"];
+		record.markers[i][1] = position["y"];
+		record.markers[i][2] = position["z"];
+		frame["trackers"].erase(markerName);
+	}
+	if(frame.find("trackers") != frame.end() && frame["trackers"].size() == 0) {
+		frame.erase("trackers");
+	}
+
+	if(frame.find("phonemes") != frame.end()) {
+		record.phonemesSet = true;
+		for(int i = 0; i < YERFACE_PRESTONBLAIR_PHONEME_COUNT; i++) {
+			const char *phonemeName = PrestonBlairPhonemes::asString(i);
+			if(frame["phonemes"].find(phonemeName) != frame["phonemes"].end()) {
+				record.phonemes.percent[i] = frame["phonemes"][phonemeName];
+				frame["phonemes"].erase(phonemeName);
+			}
+		}
+		if(frame["phonemes"].size() == 0) {
+			frame.erase("phonemes");
+		}
+	}
+
+	record.extra = frame;
+	return record;
+}
+
+OutputFrameDeltaEncoder::OutputFrameDeltaEncoder(OutputFrameDeltaQuantization myQuantization) {
+	quantization = myQuantization;
+	if(quantization.rotationStep <= 0.0 || quantization.translationStep <= 0.0 || quantization.positionStep <= 0.0 || quantization.phonemeStep <= 0.0) {
+		throw invalid_argument("Delta protocol quantization steps must be greater than zero.");
+	}
+	if(quantization.keyframeIntervalFrames < 1) {
+		throw invalid_argument("Delta protocol keyframeIntervalFrames cannot be less than one.");
+	}
+	keyframePending = true;
+	framesSinceKeyframe = 0;
+	lastPoseSet = false;
+	lastPhonemesSet = false;
+	lastMarkerMask = 0;
+}
+
+string OutputFrameDeltaEncoder::describeProtocol(void) {
+	OutputFrameBinarySchema schema = OutputFrameFormat::getBinarySchema();
+	json description = {
+		{ "protocol", YERFACE_WEBSOCKET_DELTA_PROTOCOL },
+		{ "markers", schema.markers },
+		{ "phonemes", schema.phonemes },
+		{ "quantization", {
+			{ "rotationStep", quantization.rotationStep },
+			{ "translationStep", quantization.translationStep },
+			{ "positionStep", quantization.positionStep },
+			{ "phonemeStep", quantization.phonemeStep }
+		} },
+		{ "keyframeIntervalFrames", quantization.keyframeIntervalFrames },
+		{ "layout", "uint8 message type (1 keyframe, 2 delta), int64 frame number, double start time, uint8 flags (1 basis, 2 pose set, 4 phonemes set), uint32 marker set mask, uint32 group mask (1 pose, 2 phonemes, 4 << N marker N), int16 values for each group in the group mask (pose: rotation x/y/z then translation x/y/z; phonemes: in order; marker: x/y/z), uint32 extra length, extra JSON. All values are little-endian. Multiply values by their quantization step. Groups missing from a delta are unchanged." }
+	};
+	return description.dump(-1, ' ', true);
+}
+
+void OutputFrameDeltaEncoder::requestKeyframe(void) {
+	keyframePending = true;
+}
+
+int16_t OutputFrameDeltaEncoder::quantize(double value, double step) {
+	long quantized = lround(value / step);
+	if(quantized > INT16_MAX) {
+		return INT16_MAX;
+	} else if(quantized < INT16_MIN) {
+		return INT16_MIN;
+	}
+	return (int16_t)quantized;
+}
+
+string OutputFrameDeltaEncoder::encodeFrame(const OutputFrameRecord &record) {
+	bool keyframe = keyframePending || framesSinceKeyframe >= quantization.keyframeIntervalFrames;
+	if(keyframe) {
+		keyframePending = false;
+		framesSinceKeyframe = 0;
+	}
+	framesSinceKeyframe++;
+
+	int16_t pose[6];
+	for(int i = 0; i < 3; i++) {
+		pose[i] = quantize(record.poseRotation[i], quantization.rotationStep);
+		pose[i + 3] = quantize(record.poseTranslation[i], quantization.translationStep);
+	}
+	int16_t phonemes[YERFACE_PRESTONBLAIR_PHONEME_COUNT];
+	for(int i = 0; i < YERFACE_PRESTONBLAIR_PHONEME_COUNT; i++) {
+		phonemes[i] = quantize(record.phonemes.percent[i], quantization.phonemeStep);
+	}
+
+	//A group goes out if it's a keyframe, if it just appeared, or if its quantized values changed.
+	uint32_t groupMask = 0;
+	if(record.poseSet && (keyframe || !lastPoseSet || memcmp(pose, lastPose, sizeof(pose)) != 0)) {
+		groupMask |= YERFACE_DELTA_GROUP_POSE;
+	}
+	if(record.phonemesSet && (keyframe || !lastPhonemesSet || memcmp(phonemes, lastPhonemes, sizeof(phonemes)) != 0)) {
+		groupMask |= YERFACE_DELTA_GROUP_PHONEMES;
+	}
+	int16_t markers[NoMarkerAssigned][3];
+	for(int i = 0; i < NoMarkerAssigned; i++) {
+		for(int j = 0; j < 3; j++) {
+			markers[i][j] = quantize(record.markers[i][j], quantization.positionStep);
+		}
+		uint32_t markerBit = (uint32_t)1 << i;
+		if(!(record.markerMask & markerBit)) {
+			continue;
+		}
+		if(keyframe || !(lastMarkerMask & markerBit) || memcmp(markers[i], lastMarkers[i], sizeof(markers[i])) != 0) {
+			groupMask |= (uint32_t)1 << (i + YERFACE_DELTA_GROUP_FIRST_MARKER_SHIFT);
+		}
+	}
+
+	string bytes;
+	appendLittleEndian<uint8_t>(bytes, keyframe ? YERFACE_DELTA_MESSAGE_KEYFRAME : YERFACE_DELTA_MESSAGE_DELTA);
+	appendLittleEndian<int64_t>(bytes, (int64_t)record.frameNumber);
+	appendLittleEndianDouble(bytes, record.startTime);
+	uint8_t flags = 0;
+	if(record.basis) {
+		flags |= YERFACE_BINARY_FRAME_FLAG_BASIS;
+	}
+	if(record.poseSet) {
+		flags |= YERFACE_BINARY_FRAME_FLAG_POSE;
+	}
+	if(record.phonemesSet) {
+		flags |= YERFACE_BINARY_FRAME_FLAG_PHONEMES;
+	}
+	appendLittleEndian<uint8_t>(bytes, flags);
+	appendLittleEndian<uint32_t>(bytes, record.markerMask);
+	appendLittleEndian<uint32_t>(bytes, groupMask);
+	if(groupMask & YERFACE_DELTA_GROUP_POSE) {
+		for(int i = 0; i < 6; i++) {
+			appendLittleEndian<int16_t>(bytes, pose[i]);
+		}
+		memcpy(lastPose, pose, sizeof(pose));
+	}
+	if(groupMask & YERFACE_DELTA_GROUP_PHONEMES) {
+		for(int i = 0; i < YERFACE_PRESTONBLAIR_PHONEME_COUNT; i++) {
+			appendLittleEndian<int16_t>(bytes, phonemes[i]);
+		}
+		memcpy(lastPhonemes, phonemes, sizeof(phonemes));
+	}
+	for(int i = 0; i < NoMarkerAssigned; i++) {
+		if(groupMask & ((uint32_t)1 << (i + YERFACE_DELTA_GROUP_FIRST_MARKER_SHIFT))) {
+			for(int j = 0; j < 3; j++) {
+				appendLittleEndian<int16_t>(bytes, markers[i][j]);
+			}
+			memcpy(lastMarkers[i], markers[i], sizeof(markers[i]));
+		}
+	}
+	lastPoseSet = record.poseSet;
+	lastPhonemesSet = record.phonemesSet;
+	lastMarkerMask = record.markerMask;
+
+	//Most frames carry an empty events object, which isn't worth sending.
+	json extra = json::object();
+	for(auto &item : record.extra.items()) {
+		if(!((item.value().is_object() || item.value().is_array()) && item.value().size() == 0)) {
+			extra[item.key()] = item.value();
+		}
+	}
+	string extraString;
+	if(extra.size() > 0) {
+		extraString = extra.dump(-1, ' ', true);
+	}
+	appendLittleEndian<uint32_t>(bytes, (uint32_t)extraString.length());
+	bytes.append(extraString);
+	return bytes;
+}
+
+OutputFrameFileReader::OutputFrameFileReader(string myFilename) {
+	filename = myFilename;
+	filestream.open(filename, ifstream::in | ifstream::binary);
+	if(filestream.fail()) {
+		throw invalid_argument("could not open " + filename + " for reading");
+	}
+	char magic[4];
+	filestream.read(magic, 4);
+	if(filestream.gcount() == 4 && memcmp(magic, YERFACE_BINARY_FORMAT_MAGIC, 4) == 0) {
+		format = OUTPUT_FRAME_FORMAT_BINARY;
+		readBinaryHeader();
+	} else {
+		format = OUTPUT_FRAME_FORMAT_JSON;
+		filestream.clear();
+		filestream.seekg(0);
+	}
+}
+
+OutputFrameFileReader::~OutputFrameFileReader() noexcept(false) {
+	filestream.close();
+}
+
+void OutputFrameFileReader::readBinaryHeader(void) {
+	uint32_t version = readValue<uint32_t>(filestream);
+	if(version != YERFACE_BINARY_FORMAT_VERSION) {
+		throw runtime_error("Binary event data " + filename + " is version " + to_string(version) + ", which is not supported.");
+	}
+	if(readValue<uint32_t>(filestream) != YERFACE_BINARY_FORMAT_BYTE_ORDER_MARK) {
+		throw runtime_error("Binary event data " + filename + " was written on a machine with a different byte order.");
+	}
+	uint32_t markerCount = readValue<uint32_t>(filestream);
+	for(uint32_t i = 0; i < markerCount; i++) {
+		schema.markers.push_back(readName(filestream));
+	}
+	uint32_t phonemeCount = readValue<uint32_t>(filestream);
+	for(uint32_t i = 0; i < phonemeCount; i++) {
+		schema.phonemes.push_back(readName(filestream));
+	}
+}
+
+bool OutputFrameFileReader::readFrame(json *frame) {
+	if(format == OUTPUT_FRAME_FORMAT_JSON) {
+		string line;
+		while(getline(filestream, line)) {
+			if(line.length() > 0) {
+				*frame = json::parse(line);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	uint32_t recordLength;
+	filestream.read((char *)&recordLength, sizeof(uint32_t));
+	if(filestream.gcount() == 0) {
+		return false;
+	}
+	if(filestream.gcount() != sizeof(uint32_t)) {
+		throw runtime_error("Binary event data " + filename + " ends with a truncated record!");
+	}
+	string record(recordLength, '\0');
+	filestream.read(&record[0], recordLength);
+	if((uint32_t)filestream.gcount() != recordLength) {
+		throw runtime_error("Binary event data " + filename + " ends with a truncated record!");
+	}
+	*frame = OutputFrameFormat::recordToJSON(OutputFrameFormat::decodeBinaryFrame(schema, record));
+	return true;
+}
+
+OutputFrameFormatType OutputFrameFileReader::getFormat(void) {
+	return format;
+}
+
+} //namespace YerFace
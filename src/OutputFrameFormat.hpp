@@ -0,0 +1,136 @@
+#pragma once
+
+#include "Logger.hpp"
+#include "Utilities.hpp"
+#include "MarkerType.hpp"
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+using namespace std;
+
+namespace YerFace {
+
+#define YERFACE_BINARY_FORMAT_MAGIC "YFBF"
+#define YERFACE_BINARY_FORMAT_VERSION 1
+#define YERFACE_BINARY_FORMAT_BYTE_ORDER_MARK 0x01020304
+
+#define YERFACE_BINARY_FRAME_FLAG_BASIS 0x01
+#define YERFACE_BINARY_FRAME_FLAG_POSE 0x02
+#define YERFACE_BINARY_FRAME_FLAG_PHONEMES 0x04
+
+#define YERFACE_PRESTONBLAIR_PHONEME_COUNT 9
+
+#define YERFACE_WEBSOCKET_DELTA_PROTOCOL "yerface.delta.v1"
+#define YERFACE_DELTA_MESSAGE_KEYFRAME 1
+#define YERFACE_DELTA_MESSAGE_DELTA 2
+#define YERFACE_DELTA_GROUP_POSE 0x01
+#define YERFACE_DELTA_GROUP_PHONEMES 0x02
+#define YERFACE_DELTA_GROUP_FIRST_MARKER_SHIFT 2
+
+enum OutputFrameFormatType: unsigned int {
+	OUTPUT_FRAME_FORMAT_JSON = 1,
+	OUTPUT_FRAME_FORMAT_BINARY = 2
+};
+
+// We use the Preston Blair 'toon phoneme set. See: http://minyos.its.rmit.edu.au/aim/a_notes/mouth_shapes_01.html
+// This class will represent a single video frame's snapshot of phoneme representation.
+// There will be floating point percentages (0.0 - 1.0) for the influence of each phoneme on the frame, indexed in the order of asString().
+class PrestonBlairPhonemes {
+public:
+	PrestonBlairPhonemes(void);
+	double percent[YERFACE_PRESTONBLAIR_PHONEME_COUNT];
+	static const char *asString(int phoneme);
+	static int fromString(string phonemeName); //Returns -1 if phonemeName is not a Preston Blair phoneme.
+};
+
+//A single frame of output, filled in with plain values as the pipeline produces them and only serialized at the sinks.
+class OutputFrameRecord {
+public:
+	OutputFrameRecord(void);
+	FrameNumber frameNumber;
+	double startTime;
+	bool basis;
+	bool poseSet;
+	double poseRotation[3], poseTranslation[3];
+	uint32_t markerMask; //Bit N is set if markers[N] is set. Indexed by MarkerTypeEnum.
+	double markers[NoMarkerAssigned][3];
+	bool phonemesSet;
+	PrestonBlairPhonemes phonemes;
+	json extra; //Anything without a fixed slot, such as events and controller input.
+};
+
+//The binary format is described by its header, which lists the marker and phoneme names in the order their slots appear in each
+//frame record. Frame records are fixed-layout (pose, then every marker slot, then every phoneme slot) followed by a length-prefixed
+//JSON blob holding anything without a fixed slot, such as events and controller input.
+//
+//Header:       char[4] magic, uint32 version, uint32 byte order mark, uint32 marker count, {uint8 length, char[length] name} per marker,
+//              uint32 phoneme count, {uint8 length, char[length] name} per phoneme.
+//Frame record: uint32 record length (not counting itself), int64 frame number, double start time, uint32 flags, uint32 marker set mask,
+//              double[6] pose (rotation x/y/z, translation x/y/z), double[3] position per marker, double per phoneme,
+//              uint32 extra length, char[extra length] extra JSON.
+class OutputFrameBinarySchema {
+public:
+	std::vector<string> markers;
+	std::vector<string> phonemes;
+};
+
+class OutputFrameFormat {
+public:
+	static OutputFrameFormatType resolveFormat(string formatName);
+	static const char *formatName(OutputFrameFormatType format);
+	static OutputFrameBinarySchema getBinarySchema(void);
+	static string encodeBinaryHeader(OutputFrameBinarySchema schema);
+	static string encodeBinaryFrame(const OutputFrameRecord &record);
+	static OutputFrameRecord decodeBinaryFrame(const OutputFrameBinarySchema &schema, const string &bytes);
+	static json recordToJSON(const OutputFrameRecord &record);
+	static OutputFrameRecord recordFromJSON(json frame);
+};
+
+class OutputFrameDeltaQuantization {
+public:
+	double rotationStep, translationStep, positionStep, phonemeStep;
+	int keyframeIntervalFrames;
+};
+
+//Encodes frames for a single client of the delta protocol. Values are quantized to 16 bit integers, and groups of values (the pose,
+//the phonemes, each marker) are only sent when they differ from what this client last received. Every so often a keyframe carrying
+//every group is sent, so a client can resynchronize. Messages are always little-endian. (See describeProtocol() for the layout, which is
+//sent to the client up front.)
+class OutputFrameDeltaEncoder {
+public:
+	OutputFrameDeltaEncoder(OutputFrameDeltaQuantization myQuantization);
+	string describeProtocol(void);
+	string encodeFrame(const OutputFrameRecord &record);
+	void requestKeyframe(void);
+private:
+	int16_t quantize(double value, double step);
+
+	OutputFrameDeltaQuantization quantization;
+	bool keyframePending;
+	int framesSinceKeyframe;
+	bool lastPoseSet, lastPhonemesSet;
+	uint32_t lastMarkerMask;
+	int16_t lastPose[6];
+	int16_t lastMarkers[NoMarkerAssigned][3];
+	int16_t lastPhonemes[YERFACE_PRESTONBLAIR_PHONEME_COUNT];
+};
+
+//Reads output frames back from a file written in either format, detecting which one from the first few bytes.
+class OutputFrameFileReader {
+public:
+	OutputFrameFileReader(string myFilename);
+	~OutputFrameFileReader() noexcept(false);
+	bool readFrame(json *frame);
+	OutputFrameFormatType getFormat(void);
+private:
+	void readBinaryHeader(void);
+
+	string filename;
+	ifstream filestream;
+	OutputFrameFormatType format;
+	OutputFrameBinarySchema schema;
+};
+
+}; //namespace YerFace
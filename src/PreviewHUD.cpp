@@ -23,7 +23,7 @@ PreviewHUD::PreviewHUD(json config, Status *myStatus, FrameServer *myFrameServer
 	logger = new Logger("PreviewHUD");
 	metrics = new Metrics(config, "PreviewHUD", true);
 
-	if((myMutex = SDL_CreateMutex()) == NULL) {
+	if((myMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
 
@@ -38,7 +38,7 @@ PreviewHUD::PreviewHUD(json config, Status *myStatus, FrameServer *myFrameServer
 PreviewHUD::~PreviewHUD() noexcept(false) {
 	logger->debug1("PreviewHUD object destructing...");
 
-	SDL_DestroyMutex(myMutex);
+	YerFace_DestroyMutex(myMutex);
 	delete metrics;
 	delete logger;
 }
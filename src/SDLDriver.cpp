@@ -21,18 +21,14 @@ SDLDriver::SDLDriver(json config, Status *myStatus, FrameServer *myFrameServer,
 	joystickEnabled = config["YerFace"]["SDLDriver"]["joystick"]["enabled"];
 	joystickEventsRaw = config["YerFace"]["SDLDriver"]["joystick"]["eventsRaw"];
 
-	if((audioFramesMutex = SDL_CreateMutex()) == NULL) {
-		throw runtime_error("Failed creating mutex!");
-	}
-	if((callbacksMutex = SDL_CreateMutex()) == NULL) {
-		throw runtime_error("Failed creating mutex!");
-	}
-	if((frameTimestampsNowMutex = SDL_CreateMutex()) == NULL) {
+	if((callbacksMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
 
-	frameTimestampsNow.startTimestamp = 0.0;
-	frameTimestampsNow.estimatedEndTimestamp = 0.0;
+	previewStartTimestamp = 0.0;
+	audioFramesLate = 0;
+	audioFramesDropped = 0;
+	audioCallbackSilenceUnderruns = 0;
 	previewWindow.window = NULL;
 	previewWindow.renderer = NULL;
 	previewTextures.videoTexture = NULL;
@@ -67,7 +63,12 @@ SDLDriver::SDLDriver(json config, Status *myStatus, FrameServer *myFrameServer,
 		logger->crit("Unable to initialize SDL: %s", SDL_GetError());
 		throw runtime_error("Unable to initialize SDL!");
 	}
-	atexit(SDL_Quit);
+	//Batch workers construct a new SDLDriver for every job, but SDL stays initialized until we exit.
+	static bool registeredQuit = false;
+	if(!registeredQuit) {
+		atexit(SDL_Quit);
+		registeredQuit = true;
+	}
 
 	audioDevice.opened = false;
 	if(!headless && audioPreview) {
@@ -177,18 +178,8 @@ SDLDriver::~SDLDriver() noexcept(false) {
 	if(previewWindow.renderer != NULL) {
 		SDL_DestroyRenderer(previewWindow.renderer);
 	}
-	SDL_DestroyMutex(frameTimestampsNowMutex);
-	frameTimestampsNowMutex = NULL;
-	SDL_DestroyMutex(audioFramesMutex);
-	audioFramesMutex = NULL;
-	SDL_DestroyMutex(callbacksMutex);
+	YerFace_DestroyMutex(callbacksMutex);
 	callbacksMutex = NULL;
-	for(SDLAudioFrame *audioFrame : audioFramesAllocated) {
-		if(audioFrame->buf != NULL) {
-			av_freep(&audioFrame->buf);
-		}
-		delete audioFrame;
-	}
 	delete logger;
 }
 
@@ -460,102 +451,60 @@ void SDLDriver::onJoystickHatEvent(function<void(Uint32 relativeTimestamp, int d
 	YerFace_MutexUnlock(callbacksMutex);
 }
 
-SDLAudioFrame *SDLDriver::getNextAvailableAudioFrame(int desiredBufferSize) {
-	YerFace_MutexLock(audioFramesMutex);
-	for(SDLAudioFrame *audioFrame : audioFramesAllocated) {
-		if(!audioFrame->inUse) {
-			if(audioFrame->bufferSize < desiredBufferSize) {
-				//Not using realloc because it does not support guaranteed buffer alignment.
-				av_freep(&audioFrame->buf);
-				if((audioFrame->buf = (uint8_t *)av_malloc(desiredBufferSize)) == NULL) {
-					throw runtime_error("unable to allocate memory for audio frame");
-				}
-				audioFrame->bufferSize = desiredBufferSize;
-			}
-			audioFrame->pos = 0;
-			audioFrame->inUse = true;
-			YerFace_MutexUnlock(audioFramesMutex);
-			return audioFrame;
-		}
-	}
-	SDLAudioFrame *audioFrame = new SDLAudioFrame();
-	if((audioFrame->buf = (uint8_t *)av_malloc(desiredBufferSize)) == NULL) {
-		throw runtime_error("unable to allocate memory for audio frame");
-	}
-	audioFrame->bufferSize = desiredBufferSize;
-	audioFrame->pos = 0;
-	audioFrame->inUse = true;
-	YerFace_MutexUnlock(audioFramesMutex);
-	return audioFrame;
-}
-
 void SDLDriver::SDLAudioCallback(void* userdata, Uint8* stream, int len) {
 	SDLDriver *self = (SDLDriver *)userdata;
+	//NOTE: This runs on SDL's real-time audio thread, so nothing in here may block or allocate.
 
-	YerFace_MutexLock(self->frameTimestampsNowMutex);
-	FrameTimestamps frameTimestamps = self->frameTimestampsNow;
-	YerFace_MutexUnlock(self->frameTimestampsNowMutex);
+	//Logging takes a mutex, so problems are only counted here and reported later by handleFrameStatusChange().
+	double startTimestamp = self->previewStartTimestamp.load();
 
-	YerFace_MutexLock(self->audioFramesMutex);
 	int streamPos = 0;
 	int frameDiscards = 0, frameFills = 0;
-	self->logger->debug4("SDL Audio Device Callback Fired");
 
 	while(len - streamPos > 0) {
 		int remaining = len - streamPos;
-		self->logger->debug4("Audio Callback Buffer Filling Loop... Length: %d, streamPos: %d, Remaining: %d, Frame Start: %lf, Frame End: %lf", len, streamPos, remaining, frameTimestamps.startTimestamp, frameTimestamps.estimatedEndTimestamp);
 
-		double audioLateGraceTimestamp = frameTimestamps.startTimestamp - YERFACE_AUDIO_LATE_GRACE;
-		while(self->audioFrameQueue.size() > 0 && self->audioFrameQueue.back()->timestamp < audioLateGraceTimestamp) {
-			self->logger->debug4("AUDIO IS LATE! (Video Frame Start Time: %.04lf, Audio Frame Start Time: %.04lf, Grace Period: %.04lf) Discarding one audio frame.", frameTimestamps.startTimestamp, self->audioFrameQueue.back()->timestamp, YERFACE_AUDIO_LATE_GRACE);
-			self->audioFrameQueue.back()->inUse = false;
-			self->audioFrameQueue.pop_back();
+		double audioLateGraceTimestamp = startTimestamp - YERFACE_AUDIO_LATE_GRACE;
+		AudioFrame *audioFrame = self->audioFrameRing.peekFrame();
+		while(audioFrame != NULL && audioFrame->timestamp < audioLateGraceTimestamp) {
+			self->audioFrameRing.popFrame();
+			audioFrame = self->audioFrameRing.peekFrame();
 			frameDiscards++;
 		}
 
-		if(self->audioFrameQueue.size() > 0) {
-			// self->logger->verbose("Filling audio buffer from frame in audio frame queue...");
+		if(audioFrame != NULL) {
 			int consumeBytes = remaining;
-			int frameRemainingBytes = self->audioFrameQueue.back()->audioBytes - self->audioFrameQueue.back()->pos;
+			int frameRemainingBytes = audioFrame->audioBytes - audioFrame->pos;
 			if(frameRemainingBytes < consumeBytes) {
 				consumeBytes = frameRemainingBytes;
-				// self->logger->verbose("This frame won't fill our whole buffer...");
 			}
-			memcpy(stream + streamPos, self->audioFrameQueue.back()->buf + self->audioFrameQueue.back()->pos, consumeBytes);
-			self->audioFrameQueue.back()->pos += consumeBytes;
-			if(self->audioFrameQueue.back()->pos >= self->audioFrameQueue.back()->audioBytes) {
-				// self->logger->verbose("Popped audio frame off the back of the queue.");
-				self->audioFrameQueue.back()->inUse = false;
-				self->audioFrameQueue.pop_back();
+			memcpy(stream + streamPos, audioFrame->buf + audioFrame->pos, consumeBytes);
+			audioFrame->pos += consumeBytes;
+			if(audioFrame->pos >= audioFrame->audioBytes) {
+				self->audioFrameRing.popFrame();
 			}
 			streamPos += consumeBytes;
 			frameFills++;
 		} else {
-			self->logger->debug4("Ran out of audio frames! Filling the rest of the buffer with silence.");
 			memset(stream + streamPos, self->audioDevice.obtained.silence, remaining);
 			streamPos += remaining;
 			if(!frameFills && frameDiscards > 0) {
-				self->logger->warning("Discarded %d unsuitable input audio frames and used zero input audio frames! Audio preview buffer is full of silence!", frameDiscards);
+				self->audioCallbackSilenceUnderruns++;
 			}
 		}
 	}
-	YerFace_MutexUnlock(self->audioFramesMutex);
+	if(frameDiscards > 0) {
+		self->audioFramesLate += frameDiscards;
+	}
 }
 
 void SDLDriver::FFmpegDriverAudioFrameCallback(void *userdata, uint8_t *buf, int audioSamples, int audioBytes, double timestamp) {
 	SDLDriver *self = (SDLDriver *)userdata;
-	if(self->audioFramesMutex == NULL) {
-		return;
-	}
 	self->logger->debug4("FFmpegDriver passed us an audio frame! Frame timestamp is %lf.", timestamp);
-	YerFace_MutexLock(self->audioFramesMutex);
-	SDLAudioFrame *audioFrame = self->getNextAvailableAudioFrame(audioBytes);
-	memcpy(audioFrame->buf, buf, audioBytes);
-	audioFrame->audioSamples = audioSamples;
-	audioFrame->audioBytes = audioBytes;
-	audioFrame->timestamp = timestamp;
-	self->audioFrameQueue.push_front(audioFrame);
-	YerFace_MutexUnlock(self->audioFramesMutex);
+	if(!self->audioFrameRing.pushFrame(buf, audioSamples, audioBytes, timestamp)) {
+		//The preview is only for monitoring, so it's better to lose a little audio than to hold up the demuxer.
+		self->audioFramesDropped++;
+	}
 }
 
 void SDLDriver::stopAudioDriverNow(void) {
@@ -564,15 +513,29 @@ void SDLDriver::stopAudioDriverNow(void) {
 	}
 }
 
+void SDLDriver::reportAudioPreviewProblems(void) {
+	int dropped = audioFramesDropped.exchange(0);
+	if(dropped > 0) {
+		logger->warning("Audio preview has fallen behind. Dropped %d audio frames.", dropped);
+	}
+	int late = audioFramesLate.exchange(0);
+	if(late > 0) {
+		logger->debug2("Audio preview discarded %d late audio frames. (Grace Period: %.04lf)", late, YERFACE_AUDIO_LATE_GRACE);
+	}
+	int underruns = audioCallbackSilenceUnderruns.exchange(0);
+	if(underruns > 0) {
+		logger->warning("Audio preview buffer was filled with silence %d times because all available input audio frames were late!", underruns);
+	}
+}
+
 void SDLDriver::handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps) {
 	SDLDriver *self = (SDLDriver *)userdata;
 	switch(newStatus) {
 		default:
 			throw logic_error("Handler passed unsupported frame status change event!");
 		case FRAME_STATUS_PREVIEW_DISPLAY:
-			YerFace_MutexLock(self->frameTimestampsNowMutex);
-			self->frameTimestampsNow = frameTimestamps;
-			YerFace_MutexUnlock(self->frameTimestampsNowMutex);
+			self->previewStartTimestamp = frameTimestamps.startTimestamp;
+			self->reportAudioPreviewProblems();
 			break;
 	}
 }
@@ -6,6 +6,7 @@
 #include "FFmpegDriver.hpp"
 
 #include <list>
+#include <atomic>
 
 namespace YerFace {
 
@@ -25,17 +26,6 @@ public:
 	bool opened;
 };
 
-class SDLAudioFrame {
-public:
-	uint8_t *buf;
-	int pos;
-	int audioSamples;
-	int audioBytes;
-	int bufferSize;
-	double timestamp;
-	bool inUse;
-};
-
 class SDLTextures {
 public:
 	SDL_Texture *videoTexture;
@@ -77,8 +67,7 @@ public:
 	static void handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps);
 	void stopAudioDriverNow(void);
 private:
-	SDLAudioFrame *getNextAvailableAudioFrame(int desiredBufferSize);
-
+	void reportAudioPreviewProblems(void);
 	Status *status;
 	FrameServer *frameServer;
 	FFmpegDriver *ffmpegDriver;
@@ -95,9 +84,7 @@ private:
 
 	SDLAudioDevice audioDevice;
 
-	SDL_mutex *audioFramesMutex;
-	list<SDLAudioFrame *> audioFrameQueue;
-	list<SDLAudioFrame *> audioFramesAllocated;
+	AudioFrameRing audioFrameRing; //Filled by the FFmpegDriver demuxer thread, drained by the SDL audio callback.
 
 	SDL_mutex *callbacksMutex;
 	std::vector<function<void(void)>> onBasisFlagCallbacks;
@@ -105,8 +92,10 @@ private:
 	std::vector<function<void(Uint32 relativeTimestamp, int deviceId, int axis, double value)>> onJoystickAxisEventCallbacks;
 	std::vector<function<void(Uint32 relativeTimestamp, int deviceId, int hat, int x, int y)>> onJoystickHatEventCallbacks;
 
-	SDL_mutex *frameTimestampsNowMutex;
-	FrameTimestamps frameTimestampsNow;
+	//Start timestamp of the frame currently being previewed. Atomic so the audio callback can read it without taking a lock.
+	std::atomic<double> previewStartTimestamp;
+	//Audio preview problems counted by the audio threads, which must not log, and reported by reportAudioPreviewProblems().
+	std::atomic<int> audioFramesLate, audioFramesDropped, audioCallbackSilenceUnderruns;
 
 	unordered_map<SDL_JoystickID, SDLJoystickDevice> joysticks;
 };
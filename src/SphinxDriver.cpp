@@ -3,6 +3,7 @@
 #include "Utilities.hpp"
 
 #include <cmath>
+#include <algorithm>
 
 using namespace std;
 using namespace cv;
@@ -10,39 +11,85 @@ using namespace PocketSphinx;
 
 namespace YerFace {
 
-PrestonBlairPhonemes::PrestonBlairPhonemes(void) {
-	percent = {
-		{ "AI", 0.0 },
-		{ "E", 0.0 },
-		{ "O", 0.0 },
-		{ "U", 0.0 },
-		{ "MBP", 0.0 },
-		{ "FV", 0.0 },
-		{ "L", 0.0 },
-		{ "WQ", 0.0 },
-		{ "etc", 0.0 }
-	};
-}
+class SphinxSegmentDecoder {
+public:
+	SphinxDriver *self;
+	cmd_ln_t *config;
+	ps_decoder_t *decoder;
+};
+
+//An idle recognizer, kept after its SphinxDriver is gone so that a batch worker's next job can skip loading the models.
+class SphinxCachedDecoder {
+public:
+	string hiddenMarkovModel, allPhoneLM;
+	cmd_ln_t *config;
+	ps_decoder_t *decoder;
+};
+
+std::list<SphinxCachedDecoder *> SphinxDriver::cachedDecoders;
+SDL_mutex *SphinxDriver::cachedDecodersMutex = SDL_CreateMutex();
 
 SphinxDriver::SphinxDriver(json config, Status *myStatus, FrameServer *myFrameServer, FFmpegDriver *myFFmpegDriver, SDLDriver *mySDLDriver, OutputDriver *myOutputDriver, PreviewHUD *myPreviewHUD, bool myLowLatency) {
 	recognitionWorkerPool = NULL;
 	lipFlappingWorkerPool = NULL;
 	phonemeBreakdownWorkerPool = NULL;
+	segmentDecoderWorkerPool = NULL;
+	lipFlappingLastFrameNumber = -1;
+	phonemeBreakdownLastFrameNumber = -1;
 	
-	lipFlappingTargetPhoneme = config["YerFace"]["SphinxDriver"]["lipFlapping"]["targetPhoneme"];
+	lipFlappingTargetPhoneme = PrestonBlairPhonemes::fromString(config["YerFace"]["SphinxDriver"]["lipFlapping"]["targetPhoneme"]);
+	if(lipFlappingTargetPhoneme < 0) {
+		throw invalid_argument("SphinxDriver lipFlapping targetPhoneme must be a Preston Blair phoneme.");
+	}
 	lipFlappingResponseThreshold = config["YerFace"]["SphinxDriver"]["lipFlapping"]["responseThreshold"];
 	lipFlappingNonLinearResponse = config["YerFace"]["SphinxDriver"]["lipFlapping"]["nonLinearResponse"];
 	lipFlappingNotInSpeechScale = config["YerFace"]["SphinxDriver"]["lipFlapping"]["notInSpeechScale"];
 	hiddenMarkovModel = Utilities::fileValidPathOrDie(config["YerFace"]["SphinxDriver"]["sphinx"]["hiddenMarkovModel"]);
 	allPhoneLM = Utilities::fileValidPathOrDie(config["YerFace"]["SphinxDriver"]["sphinx"]["allPhoneLM"]);
-	sphinxToPrestonBlairPhonemeMapping = config["YerFace"]["SphinxDriver"]["sphinx"]["prestonBlairPhonemeMapping"];
+	json phonemeMapping = config["YerFace"]["SphinxDriver"]["sphinx"]["prestonBlairPhonemeMapping"];
+	for(json::iterator iter = phonemeMapping.begin(); iter != phonemeMapping.end(); ++iter) {
+		int pbPhoneme = PrestonBlairPhonemes::fromString(iter.value());
+		if(pbPhoneme < 0) {
+			throw invalid_argument("SphinxDriver prestonBlairPhonemeMapping maps " + iter.key() + " to something which is not a Preston Blair phoneme.");
+		}
+		sphinxToPrestonBlairPhonemeMapping[iter.key()] = pbPhoneme;
+	}
 	sphinxInfluenceOfLipFlappingOnResult = config["YerFace"]["SphinxDriver"]["sphinx"]["influenceOfLipFlappingOnResult"];
 	if(sphinxInfluenceOfLipFlappingOnResult < 0.0 || sphinxInfluenceOfLipFlappingOnResult > 1.0) {
 		throw invalid_argument("SphinxDriver influenceOfAmplitudeOnResult must be between 0.0 and 1.0 inclusive.");
 	}
+	streamingEnabled = config["YerFace"]["SphinxDriver"]["streaming"]["enabled"];
+	streamingMaxUtteranceSeconds = config["YerFace"]["SphinxDriver"]["streaming"]["maxUtteranceSeconds"];
+	if(streamingMaxUtteranceSeconds <= 0.0) {
+		throw invalid_argument("SphinxDriver streaming maxUtteranceSeconds must be greater than zero.");
+	}
+	streamingPartialHypothesisIntervalSeconds = config["YerFace"]["SphinxDriver"]["streaming"]["partialHypothesisIntervalSeconds"];
+	streamingStabilityMarginSeconds = config["YerFace"]["SphinxDriver"]["streaming"]["stabilityMarginSeconds"];
+	streamingLatencyBudgetSeconds = config["YerFace"]["SphinxDriver"]["streaming"]["latencyBudgetSeconds"];
+	if(streamingPartialHypothesisIntervalSeconds < 0.0 || streamingStabilityMarginSeconds < 0.0 || streamingLatencyBudgetSeconds < 0.0) {
+		throw invalid_argument("SphinxDriver streaming intervals, margins, and budgets cannot be less than zero.");
+	}
+	segmentDecoders = config["YerFace"]["SphinxDriver"]["offlineSegmentation"]["decoders"];
+	if(segmentDecoders < 0) {
+		throw invalid_argument("SphinxDriver offlineSegmentation decoders cannot be less than zero.");
+	}
+	if(segmentDecoders == 0) {
+		segmentDecoders = std::min(YERFACE_SPHINX_MAX_AUTO_SEGMENT_DECODERS, std::max(1, SDL_GetCPUCount() / 2));
+	}
+	segmentSilenceThreshold = config["YerFace"]["SphinxDriver"]["offlineSegmentation"]["silenceThreshold"];
+	if(segmentSilenceThreshold < 0.0 || segmentSilenceThreshold > 1.0) {
+		throw invalid_argument("SphinxDriver offlineSegmentation silenceThreshold must be between 0.0 and 1.0 inclusive.");
+	}
+	segmentMinSilenceSeconds = config["YerFace"]["SphinxDriver"]["offlineSegmentation"]["minSilenceSeconds"];
+	segmentMinSeconds = config["YerFace"]["SphinxDriver"]["offlineSegmentation"]["minSegmentSeconds"];
+	segmentMaxSeconds = config["YerFace"]["SphinxDriver"]["offlineSegmentation"]["maxSegmentSeconds"];
+	if(segmentMinSilenceSeconds < 0.0 || segmentMinSeconds < 0.0 || segmentMaxSeconds <= 0.0 || segmentMaxSeconds < segmentMinSeconds) {
+		throw invalid_argument("SphinxDriver offlineSegmentation durations cannot be less than zero, and maxSegmentSeconds must be greater than zero and at least minSegmentSeconds.");
+	}
 	vuMeterWidth = config["YerFace"]["SphinxDriver"]["PreviewHUD"]["vuMeterWidth"];
 	vuMeterWarningThreshold = config["YerFace"]["SphinxDriver"]["PreviewHUD"]["vuMeterWarningThreshold"];
 	vuMeterPeakHoldSeconds = config["YerFace"]["SphinxDriver"]["PreviewHUD"]["vuMeterPeakHoldSeconds"];
+	vuMeterLastSetPeak = vuMeterPeakHoldSeconds * (-1.0);
 	status = myStatus;
 	if(status == NULL) {
 		throw invalid_argument("status cannot be NULL");
@@ -68,12 +115,18 @@ SphinxDriver::SphinxDriver(json config, Status *myStatus, FrameServer *myFrameSe
 		throw invalid_argument("previewHUD cannot be NULL");
 	}
 	lowLatency = myLowLatency;
+	//Offline mode already sees every phoneme before a frame is finalized, so streaming only applies to low latency mode.
+	streamingEnabled = streamingEnabled && lowLatency;
+	//Segments are only recognized once they end, which is too late for low latency mode.
+	if(lowLatency) {
+		segmentDecoders = 1;
+	}
 	logger = new Logger("SphinxDriver");
 
-	outputDriver->registerFrameData("phonemes");
+	outputDriver->registerFrameData(OUTPUT_FRAME_DATA_PHONEMES);
 
 	sphinxLogger = new Logger("PocketSphinx");
-	if((sphinxLoggerMutex = SDL_CreateMutex()) == NULL) {
+	if((sphinxLoggerMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
 	PocketSphinx::err_set_callback(sphinxLogCallback, (void *)this);
@@ -82,28 +135,36 @@ SphinxDriver::SphinxDriver(json config, Status *myStatus, FrameServer *myFrameSe
 	pocketSphinx = NULL;
 	pocketSphinxConfig = NULL;
 	utteranceRestarted = false;
+	utteranceStartTimestamp = -1.0;
+	recognizedThroughTimestamp = 0.0;
+	phonemesEmittedThroughTimestamp = -1.0;
+	phonemesStableThroughTimestamp = -1.0;
+	lastPartialHypothesisTimestamp = 0.0;
 	lastUtteranceEndedTimestamp = 0.0;
 	inSpeech = false;
-	if((recognitionMutex = SDL_CreateMutex()) == NULL) {
+	currentSegment = NULL;
+	currentSegmentSilenceSeconds = 0.0;
+	segmenterDrained = false;
+	if((recognitionMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
-	if((workingVideoFramesMutex = SDL_CreateMutex()) == NULL) {
+	if((workingVideoFramesMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
 	
 	logger->info("Initializing PocketSphinx with Models... <HMM: %s, AllPhone: %s>", hiddenMarkovModel.c_str(), allPhoneLM.c_str());
-	// Configuration for phoneme recognition from: https://cmusphinx.github.io/wiki/phonemerecognition/
-	if((pocketSphinxConfig = cmd_ln_init(NULL, ps_args(), TRUE, "-hmm", hiddenMarkovModel.c_str(), "-allphone", allPhoneLM.c_str(), "-beam", "1e-20", "-pbeam", "1e-20", "-lw", "2.0", NULL)) == NULL) {
-		throw runtime_error("Failed to create PocketSphinx configuration object!");
-	}
-	
-	if((pocketSphinx = ps_init(pocketSphinxConfig)) == NULL) {
-		throw runtime_error("Failed to create PocketSphinx speech recognizer!");
-	}
 	
 	utteranceIndex = 1;
-	if(ps_start_utt(pocketSphinx) != 0) {
-		throw runtime_error("Failed to start PocketSphinx utterance");
+	if(segmentDecoders > 1) {
+		//Each segment decoder worker acquires its own recognizer.
+		pocketSphinxConfig = createSphinxConfig();
+		logger->info("Offline audio will be split at pauses and recognized by %d PocketSphinx decoders in parallel.", segmentDecoders);
+	} else {
+		pocketSphinx = acquireDecoder(&pocketSphinxConfig);
+		
+		if(ps_start_utt(pocketSphinx) != 0) {
+			throw runtime_error("Failed to start PocketSphinx utterance");
+		}
 	}
 	
 	//This audio format is the only audio format that the Pocket Sphinx phoneme recognizer is trained to work on.
@@ -133,6 +194,18 @@ SphinxDriver::SphinxDriver(json config, Status *myStatus, FrameServer *myFrameSe
 	recognizerRunning = true;
 	recognizerDrained = false;
 	WorkerPoolParameters workerPoolParameters;
+	//The segment decoders must exist before the recognition worker starts cutting segments for them.
+	if(segmentDecoders > 1) {
+		workerPoolParameters.name = "SphinxDriver.SegmentDecoder";
+		workerPoolParameters.numWorkers = segmentDecoders;
+		workerPoolParameters.numWorkersPerCPU = 0.0;
+		workerPoolParameters.initializer = segmentDecoderWorkerInitializer;
+		workerPoolParameters.deinitializer = segmentDecoderWorkerDeinitializer;
+		workerPoolParameters.usrPtr = (void *)this;
+		workerPoolParameters.handler = segmentDecoderWorkerHandler;
+		segmentDecoderWorkerPool = new WorkerPool(config, status, frameServer, workerPoolParameters);
+	}
+
 	workerPoolParameters.name = "SphinxDriver.Recognition";
 	workerPoolParameters.numWorkers = 1;
 	workerPoolParameters.numWorkersPerCPU = 0.0;
@@ -143,7 +216,7 @@ SphinxDriver::SphinxDriver(json config, Status *myStatus, FrameServer *myFrameSe
 	recognitionWorkerPool = new WorkerPool(config, status, frameServer, workerPoolParameters);
 
 	//We also want to introduce a checkpoint so that frames cannot TRANSITION AWAY from the relevant statuses without our blessing.
-	frameServer->registerFrameStatusCheckpoint(FRAME_STATUS_MAPPING, "sphinxDriver.ran");
+	mappingCheckpoint = frameServer->registerFrameStatusCheckpoint(FRAME_STATUS_MAPPING, "sphinxDriver.ran");
 
 	workerPoolParameters.name = "SphinxDriver.LipFlapping";
 	workerPoolParameters.numWorkers = 1;
@@ -155,7 +228,7 @@ SphinxDriver::SphinxDriver(json config, Status *myStatus, FrameServer *myFrameSe
 	lipFlappingWorkerPool = new WorkerPool(config, status, frameServer, workerPoolParameters);
 
 	if(!lowLatency) {
-		frameServer->registerFrameStatusCheckpoint(FRAME_STATUS_LATE_PROCESSING, "sphinxDriver.ran");
+		lateProcessingCheckpoint = frameServer->registerFrameStatusCheckpoint(FRAME_STATUS_LATE_PROCESSING, "sphinxDriver.ran");
 
 		workerPoolParameters.name = "SphinxDriver.PhonemeBreakdown";
 		workerPoolParameters.numWorkers = 1;
@@ -167,19 +240,20 @@ SphinxDriver::SphinxDriver(json config, Status *myStatus, FrameServer *myFrameSe
 		phonemeBreakdownWorkerPool = new WorkerPool(config, status, frameServer, workerPoolParameters);
 	}
 
-	logger->debug1("SphinxDriver object constructed in %s mode!", lowLatency ? "LOW LATENCY (lip flapping)" : "OFFLINE (preston blair phoneme breakdown)");
+	logger->debug1("SphinxDriver object constructed in %s mode!", lowLatency ? (streamingEnabled ? "LOW LATENCY (lip flapping with streaming phonemes)" : "LOW LATENCY (lip flapping)") : (segmentDecoders > 1 ? "OFFLINE (preston blair phoneme breakdown with segmented decoders)" : "OFFLINE (preston blair phoneme breakdown)"));
 }
 
 SphinxDriver::~SphinxDriver() noexcept(false) {
 	logger->debug1("SphinxDriver object destructing...");
 
 	delete recognitionWorkerPool;
+	if(segmentDecoderWorkerPool != NULL) {
+		delete segmentDecoderWorkerPool;
+	}
 
-	YerFace_MutexLock(recognitionMutex);
-	if(audioFrameQueue.size() > 0) {
+	if(audioFrameRing.size() > 0) {
 		logger->err("Input audio frames are still pending! Woe is me!");
 	}
-	YerFace_MutexUnlock(recognitionMutex);
 
 	delete lipFlappingWorkerPool;
 	if(!lowLatency) {
@@ -199,38 +273,46 @@ SphinxDriver::~SphinxDriver() noexcept(false) {
 	if(phonemeBuffer.size() > 0) {
 		logger->err("Not all phoneme buffer items were consumed! Woe is me!");
 	}
+	if(currentSegment != NULL || pendingSegments.size() > 0) {
+		logger->err("Not all audio segments were recognized! Woe is me!");
+		delete currentSegment;
+		for(SphinxAudioSegment *segment : pendingSegments) {
+			delete segment;
+		}
+		pendingSegments.clear();
+	}
 	YerFace_MutexUnlock(recognitionMutex);
 
-	SDL_DestroyMutex(recognitionMutex);
+	YerFace_DestroyMutex(recognitionMutex);
 	recognitionMutex = NULL;
-	SDL_DestroyMutex(workingVideoFramesMutex);
+	YerFace_DestroyMutex(workingVideoFramesMutex);
 	workingVideoFramesMutex = NULL;
 
-	ps_free(pocketSphinx);
-	cmd_ln_free_r(pocketSphinxConfig);
-
-	for(SphinxAudioFrame *audioFrame : audioFramesAllocated) {
-		if(audioFrame->inUse) {
-			logger->crit("About to free an in-use audio frame! Uh oh!");
+	//A recognizer which was stopped mid-utterance can't be handed to anyone else.
+	if(pocketSphinx != NULL && recognizerDrained) {
+		returnDecoder(pocketSphinx, pocketSphinxConfig);
+	} else {
+		if(pocketSphinx != NULL) {
+			ps_free(pocketSphinx);
 		}
-		av_freep(&audioFrame->buf);
-		delete audioFrame;
+		cmd_ln_free_r(pocketSphinxConfig);
 	}
 
+	//Cached recognizers outlive us, and must not log through us.
+	PocketSphinx::err_set_callback(NULL, NULL);
 	delete logger;
 	delete sphinxLogger;
 	sphinxLogger = NULL;
-	SDL_DestroyMutex(sphinxLoggerMutex);
+	YerFace_DestroyMutex(sphinxLoggerMutex);
 	sphinxLoggerMutex = NULL;
 }
 
 void SphinxDriver::renderPreviewHUD(Mat frame, FrameNumber frameNumber, int density, bool mirrorMode) {
-	static double vuMeterLastSetPeak = vuMeterPeakHoldSeconds * (-1.0);
-
 	if(density > 0) {
 		YerFace_MutexLock(workingVideoFramesMutex);
-		double maxAmplitude = workingVideoFrames[frameNumber]->maxAmplitude;
-		bool peak = workingVideoFrames[frameNumber]->peak;
+		double maxAmplitude = workingVideoFrames[frameNumber]->envelope.peak;
+		double rmsAmplitude = workingVideoFrames[frameNumber]->envelope.getRMS();
+		bool peak = workingVideoFrames[frameNumber]->envelope.clipped;
 		double lipFlappingAmount = workingVideoFrames[frameNumber]->lipFlappingAmount;
 		YerFace_MutexUnlock(workingVideoFramesMutex);
 
@@ -253,6 +335,12 @@ void SphinxDriver::renderPreviewHUD(Mat frame, FrameNumber frameNumber, int dens
 		}
 		rectangle(frame, vuMeter, color, FILLED); // FIXME - proportional drawing
 
+		//The RMS level sits inside the peak level, in a darker shade.
+		vuHeight = previewRect.height * rmsAmplitude;
+		vuMeter.y = previewRect.y + (previewRect.height - vuHeight);
+		vuMeter.height = vuHeight;
+		rectangle(frame, vuMeter, color * 0.5, FILLED);
+
 		vuHeight = previewRect.height * lipFlappingAmount;
 		vuMeter.x = previewRect.x + meterWidth;
 		vuMeter.y = previewRect.y + (previewRect.height - vuHeight);
@@ -281,20 +369,14 @@ bool SphinxDriver::processPhonemeBreakdown(SphinxVideoFrame *videoFrame) {
 		double phonemeStartTime = phonemeBuffer.back().startTime;
 		double phonemeEndTime = phonemeBuffer.back().endTime;
 		TimeIntervalComparison comparison = Utilities::timeIntervalCompare(phonemeStartTime, phonemeEndTime, videoFrame->timestamps.startTimestamp, videoFrame->timestamps.estimatedEndTimestamp);
-		logger->debug4("processPhonemeBreakdown() timeIntervalCompare(A: phonemeTime, B: videoFrame)... [A: %lf-%lf (%s)], [B: %lf-%lf], [doesAEndBeforeB: %d, doesAOccurBeforeB: %d, doesAOccurDuringB: %d, doesAOccurAfterB: %d, doesAStartAfterB: %d]", phonemeStartTime, phonemeEndTime, phonemeBuffer.back().pbPhoneme.c_str(), videoFrame->timestamps.startTimestamp, videoFrame->timestamps.estimatedEndTimestamp, comparison.doesAEndBeforeB, comparison.doesAOccurBeforeB, comparison.doesAOccurDuringB, comparison.doesAOccurAfterB, comparison.doesAStartAfterB);
+		logger->debug4("processPhonemeBreakdown() timeIntervalCompare(A: phonemeTime, B: videoFrame)... [A: %lf-%lf (%s)], [B: %lf-%lf], [doesAEndBeforeB: %d, doesAOccurBeforeB: %d, doesAOccurDuringB: %d, doesAOccurAfterB: %d, doesAStartAfterB: %d]", phonemeStartTime, phonemeEndTime, PrestonBlairPhonemes::asString(phonemeBuffer.back().pbPhoneme), videoFrame->timestamps.startTimestamp, videoFrame->timestamps.estimatedEndTimestamp, comparison.doesAEndBeforeB, comparison.doesAOccurBeforeB, comparison.doesAOccurDuringB, comparison.doesAOccurAfterB, comparison.doesAStartAfterB);
 		if(comparison.doesAEndBeforeB) {
 			phonemeBuffer.pop_back();
 			continue;
 		}
 		if(comparison.doesAOccurDuringB) {
-			if(phonemeBuffer.back().pbPhoneme.length() > 0) {
-				double currentPercent = 0.0;
-				try {
-					currentPercent = videoFrame->phonemes.percent.at(phonemeBuffer.back().pbPhoneme);
-				} catch(exception &e) {
-					logger->err("Caught exception during phoneme mapping! %s", e.what());
-					throw logic_error("Preston Blair mapping returned an unrecognized phoneme!");
-				}
+			if(phonemeBuffer.back().pbPhoneme >= 0) {
+				double currentPercent = videoFrame->phonemes.percent[phonemeBuffer.back().pbPhoneme];
 				double divisor = videoFrame->timestamps.estimatedEndTimestamp - videoFrame->timestamps.startTimestamp;
 				if(phonemeStartTime < videoFrame->timestamps.startTimestamp) {
 					phonemeStartTime = videoFrame->timestamps.startTimestamp;
@@ -304,7 +386,7 @@ bool SphinxDriver::processPhonemeBreakdown(SphinxVideoFrame *videoFrame) {
 				}
 				double numerator = phonemeEndTime - phonemeStartTime;
 				currentPercent = currentPercent + (numerator / divisor);
-				// logger->debug4("pbPhenome %s is %.04lf / %.04lf = %.04lf", phonemeBuffer.back().pbPhoneme.c_str(), numerator, divisor, numerator / divisor);
+				// logger->debug4("pbPhenome %s is %.04lf / %.04lf = %.04lf", PrestonBlairPhonemes::asString(phonemeBuffer.back().pbPhoneme), numerator, divisor, numerator / divisor);
 				if(currentPercent > 1.0) {
 					currentPercent = 1.0;
 				}
@@ -325,9 +407,12 @@ bool SphinxDriver::processPhonemeBreakdown(SphinxVideoFrame *videoFrame) {
 	return frameSuccessfullyProcessed;
 }
 
-void SphinxDriver::processUtteranceHypothesis(void) {
+void SphinxDriver::processUtteranceHypothesis(bool final) {
+	//NOTE: Must be called while holding recognitionMutex.
 	// logger->debug4("processUtteranceHypothesis()");
 	int frameRate = cmd_ln_int32_r(pocketSphinxConfig, "-frate");
+	//Until the utterance ends, the tail of the hypothesis can still change, so partial hypotheses hold back the most recent segments.
+	double stableThroughTimestamp = final ? recognizedThroughTimestamp : recognizedThroughTimestamp - streamingStabilityMarginSeconds;
 	ps_seg_t *segmentIterator = ps_seg_iter(pocketSphinx);
 	bool addedPhonemes = false;
 	while(segmentIterator != NULL) {
@@ -337,19 +422,33 @@ void SphinxDriver::processUtteranceHypothesis(void) {
 
 		SphinxPhoneme phoneme;
 		phoneme.utteranceIndex = utteranceIndex;
-		phoneme.startTime = ((double)startFrame / (double)frameRate);
-		phoneme.endTime = ((double)endFrame / (double)frameRate);
-		phoneme.pbPhoneme = "";
-		try {
-			phoneme.pbPhoneme = sphinxToPrestonBlairPhonemeMapping.at(symbol);
-			phonemeBuffer.push_front(phoneme);
-			addedPhonemes = true;
-		} catch(nlohmann::detail::out_of_range &e) {
-			logger->debug1("Sphinx reported a phoneme (%s) which we don't have in our mapping. Details: %s", symbol.c_str(), e.what());
+		phoneme.startTime = utteranceStartTimestamp + ((double)startFrame / (double)frameRate);
+		phoneme.endTime = utteranceStartTimestamp + ((double)endFrame / (double)frameRate);
+		if(phoneme.endTime > stableThroughTimestamp) {
+			ps_seg_free(segmentIterator);
+			break;
+		}
+		if(phoneme.endTime > phonemesEmittedThroughTimestamp) {
+			if(phoneme.startTime < phonemesEmittedThroughTimestamp) {
+				phoneme.startTime = phonemesEmittedThroughTimestamp;
+			}
+			phonemesEmittedThroughTimestamp = phoneme.endTime;
+			auto mapping = sphinxToPrestonBlairPhonemeMapping.find(symbol);
+			if(mapping != sphinxToPrestonBlairPhonemeMapping.end()) {
+				phoneme.pbPhoneme = mapping->second;
+				phonemeBuffer.push_front(phoneme);
+				addedPhonemes = true;
+			} else {
+				logger->debug1("Sphinx reported a phoneme (%s) which we don't have in our mapping.", symbol.c_str());
+			}
 		}
 
 		segmentIterator = ps_seg_next(segmentIterator);
 	}
+	if(stableThroughTimestamp > phonemesStableThroughTimestamp) {
+		phonemesStableThroughTimestamp = stableThroughTimestamp;
+	}
+	lastPartialHypothesisTimestamp = recognizedThroughTimestamp;
 	if(addedPhonemes) {
 		if(phonemeBreakdownWorkerPool != NULL) {
 			phonemeBreakdownWorkerPool->sendWorkerSignal();
@@ -357,25 +456,176 @@ void SphinxDriver::processUtteranceHypothesis(void) {
 	}
 }
 
-void SphinxDriver::processAudioAmplitude(SphinxAudioFrame *audioFrame, SphinxRecognizerResult *result) {
-	PocketSphinx::int16 const *buf = (PocketSphinx::int16 const *)audioFrame->buf;
-	int samples = audioFrame->audioSamples;
-	for(int i = 0; i < samples; i++) {
-		double amplitude = fabs((double)buf[i]) / (double)0x7FFF;
-		if(amplitude > result->maxAmplitude) {
-			result->maxAmplitude = amplitude;
+bool SphinxDriver::isStreamingCaughtUp(SphinxVideoFrame *videoFrame) {
+	//Wait for streamed phonemes to cover the frame, but never longer than the latency budget.
+	double now = (double)SDL_GetTicks() / (double)1000.0;
+	if(now - videoFrame->lipFlappingReadySeconds >= streamingLatencyBudgetSeconds) {
+		return true;
+	}
+	YerFace_MutexLock(recognitionMutex);
+	bool caughtUp = recognizerDrained || phonemesStableThroughTimestamp >= videoFrame->timestamps.estimatedEndTimestamp;
+	YerFace_MutexUnlock(recognitionMutex);
+	return caughtUp;
+}
+
+cmd_ln_t *SphinxDriver::createSphinxConfig(void) {
+	// Configuration for phoneme recognition from: https://cmusphinx.github.io/wiki/phonemerecognition/
+	// Ask PocketSphinx to memory map the model files it can, rather than reading them into the heap.
+	cmd_ln_t *sphinxConfig;
+	if((sphinxConfig = cmd_ln_init(NULL, ps_args(), TRUE, "-hmm", hiddenMarkovModel.c_str(), "-allphone", allPhoneLM.c_str(), "-beam", "1e-20", "-pbeam", "1e-20", "-lw", "2.0", "-mmap", "yes", NULL)) == NULL) {
+		throw runtime_error("Failed to create PocketSphinx configuration object!");
+	}
+	return sphinxConfig;
+}
+
+ps_decoder_t *SphinxDriver::acquireDecoder(cmd_ln_t **decoderConfig) {
+	YerFace_MutexLock_Trivial(cachedDecodersMutex);
+	for(auto iter = cachedDecoders.begin(); iter != cachedDecoders.end(); ++iter) {
+		SphinxCachedDecoder *cached = *iter;
+		if(cached->hiddenMarkovModel == hiddenMarkovModel && cached->allPhoneLM == allPhoneLM) {
+			cachedDecoders.erase(iter);
+			YerFace_MutexUnlock_Trivial(cachedDecodersMutex);
+			ps_decoder_t *decoder = cached->decoder;
+			*decoderConfig = cached->config;
+			delete cached;
+			logger->debug1("Reusing a PocketSphinx recognizer loaded by a previous job.");
+			return decoder;
 		}
 	}
-	if(result->maxAmplitude >= 1.0) {
-		result->maxAmplitude = 1.0;
-		result->peak = true;
+	YerFace_MutexUnlock_Trivial(cachedDecodersMutex);
+
+	ps_decoder_t *decoder;
+	*decoderConfig = createSphinxConfig();
+	if((decoder = ps_init(*decoderConfig)) == NULL) {
+		cmd_ln_free_r(*decoderConfig);
+		throw runtime_error("Failed to create PocketSphinx speech recognizer!");
+	}
+	return decoder;
+}
+
+void SphinxDriver::returnDecoder(ps_decoder_t *decoder, cmd_ln_t *decoderConfig) {
+	SphinxCachedDecoder *cached = new SphinxCachedDecoder();
+	cached->hiddenMarkovModel = hiddenMarkovModel;
+	cached->allPhoneLM = allPhoneLM;
+	cached->config = decoderConfig;
+	cached->decoder = decoder;
+	YerFace_MutexLock_Trivial(cachedDecodersMutex);
+	cachedDecoders.push_back(cached);
+	YerFace_MutexUnlock_Trivial(cachedDecodersMutex);
+}
+
+void SphinxDriver::releaseCachedDecoders(void) {
+	YerFace_MutexLock_Trivial(cachedDecodersMutex);
+	for(SphinxCachedDecoder *cached : cachedDecoders) {
+		ps_free(cached->decoder);
+		cmd_ln_free_r(cached->config);
+		delete cached;
 	}
+	cachedDecoders.clear();
+	YerFace_MutexUnlock_Trivial(cachedDecodersMutex);
+}
+
+bool SphinxDriver::processAudioSegmentation(bool draining) {
+	//NOTE: Must be called while holding recognitionMutex.
+	if(!draining && pendingSegments.size() >= (size_t)(segmentDecoders * YERFACE_SPHINX_MAX_PENDING_SEGMENTS_PER_DECODER)) {
+		//The decoders are behind. Leaving the audio in the ring holds up the demuxer until they catch up.
+		return false;
+	}
+	AudioFrame *audioFrame = audioFrameRing.peekFrame();
+	if(audioFrame == NULL) {
+		return false;
+	}
+
+	//Sphinx's own voice activity detection lives inside the decoder, so segment boundaries come from a simple energy gate instead.
+	SphinxRecognizerResult result;
+	result.startTimestamp = audioFrame->timestamp;
+	result.endTimestamp = result.startTimestamp + ((double)audioFrame->audioSamples / (double)YERFACE_SPHINX_SAMPLERATE);
+	processAudioAmplitude(audioFrame, &result);
+	result.inSpeech = result.envelope.getRMS() >= segmentSilenceThreshold;
+
+	if(currentSegment == NULL) {
+		currentSegment = new SphinxAudioSegment();
+		currentSegment->index = utteranceIndex++;
+		currentSegment->startTimestamp = result.startTimestamp;
+		currentSegment->claimed = false;
+		currentSegment->decoded = false;
+		currentSegmentSilenceSeconds = 0.0;
+	}
+	const int16_t *samples = (const int16_t *)audioFrame->buf;
+	currentSegment->samples.insert(currentSegment->samples.end(), samples, samples + audioFrame->audioSamples);
+	currentSegment->endTimestamp = result.endTimestamp;
+	audioFrameRing.popFrame();
+
+	if(result.inSpeech) {
+		currentSegmentSilenceSeconds = 0.0;
+	} else {
+		currentSegmentSilenceSeconds += result.endTimestamp - result.startTimestamp;
+	}
+	double segmentSeconds = currentSegment->endTimestamp - currentSegment->startTimestamp;
+	if((segmentSeconds >= segmentMinSeconds && currentSegmentSilenceSeconds >= segmentMinSilenceSeconds) || segmentSeconds >= segmentMaxSeconds) {
+		queueCurrentSegment();
+	}
+
+	recognitionResults.push_front(result);
+	if(lipFlappingWorkerPool != NULL) {
+		lipFlappingWorkerPool->sendWorkerSignal();
+	}
+	return true;
+}
+
+void SphinxDriver::queueCurrentSegment(void) {
+	//NOTE: Must be called while holding recognitionMutex.
+	if(currentSegment == NULL) {
+		return;
+	}
+	logger->debug3("Queueing audio segment %d (%.03lf - %.03lf) for recognition.", currentSegment->index, currentSegment->startTimestamp, currentSegment->endTimestamp);
+	pendingSegments.push_back(currentSegment);
+	currentSegment = NULL;
+	if(segmentDecoderWorkerPool != NULL) {
+		segmentDecoderWorkerPool->sendWorkerSignal();
+	}
+}
+
+void SphinxDriver::mergeDecodedSegments(void) {
+	//NOTE: Must be called while holding recognitionMutex.
+	//Segments may finish decoding in any order, but phonemes must enter phonemeBuffer in time order.
+	bool addedPhonemes = false;
+	while(pendingSegments.size() && pendingSegments.front()->decoded) {
+		SphinxAudioSegment *segment = pendingSegments.front();
+		pendingSegments.pop_front();
+		double phonemesEndTime = segment->startTimestamp;
+		for(SphinxPhoneme phoneme : segment->phonemes) {
+			phonemeBuffer.push_front(phoneme);
+			phonemesEndTime = phoneme.endTime;
+		}
+		//Further down the pipeline we depend on phonemes to be present, otherwise processing blocks, so fill out the rest of the segment with silence.
+		if(phonemesEndTime < segment->endTimestamp) {
+			SphinxPhoneme phoneme;
+			phoneme.utteranceIndex = segment->index;
+			phoneme.startTime = phonemesEndTime;
+			phoneme.endTime = segment->endTimestamp;
+			phoneme.pbPhoneme = -1;
+			phonemeBuffer.push_front(phoneme);
+		}
+		addedPhonemes = true;
+		delete segment;
+	}
+	if(segmenterDrained && currentSegment == NULL && pendingSegments.size() == 0 && !recognizerDrained) {
+		recognizerDrained = true;
+		addedPhonemes = true;
+	}
+	if(addedPhonemes && phonemeBreakdownWorkerPool != NULL) {
+		phonemeBreakdownWorkerPool->sendWorkerSignal();
+	}
+}
+
+void SphinxDriver::processAudioAmplitude(AudioFrame *audioFrame, SphinxRecognizerResult *result) {
+	result->envelope = Utilities::calculateAudioEnvelope((const int16_t *)audioFrame->buf, audioFrame->audioSamples);
 }
 
 void SphinxDriver::processLipFlappingAudio(SphinxVideoFrame *videoFrame) {
-	double maxAmplitude = 0.0;
+	AudioEnvelope envelope;
 	bool inSpeech = false;
-	bool peak = false;
 	YerFace_MutexLock(recognitionMutex);
 	while(recognitionResults.size()) {
 		TimeIntervalComparison comparison = Utilities::timeIntervalCompare(recognitionResults.back().startTimestamp, recognitionResults.back().endTimestamp, videoFrame->timestamps.startTimestamp, videoFrame->timestamps.estimatedEndTimestamp);
@@ -385,15 +635,10 @@ void SphinxDriver::processLipFlappingAudio(SphinxVideoFrame *videoFrame) {
 			continue;
 		}
 		if(comparison.doesAOccurDuringB) {
-			if(recognitionResults.back().maxAmplitude >= maxAmplitude) {
-				maxAmplitude = recognitionResults.back().maxAmplitude;
-			}
+			envelope.accumulate(recognitionResults.back().envelope);
 			if(recognitionResults.back().inSpeech) {
 				inSpeech = true;
 			}
-			if(recognitionResults.back().peak) {
-				peak = true;
-			}
 			if(!comparison.doesAOccurAfterB) {
 				recognitionResults.pop_back();
 			}
@@ -404,6 +649,7 @@ void SphinxDriver::processLipFlappingAudio(SphinxVideoFrame *videoFrame) {
 	}
 	YerFace_MutexUnlock(recognitionMutex);
 
+	double maxAmplitude = envelope.peak;
 	double lipFlappingAmount = 0.0;
 	double normalized = 0.0;
 	if(maxAmplitude >= lipFlappingResponseThreshold) {
@@ -414,42 +660,11 @@ void SphinxDriver::processLipFlappingAudio(SphinxVideoFrame *videoFrame) {
 		}
 		lipFlappingAmount = temp;
 	}
-	if(lowLatency && lipFlappingAmount > (double)videoFrame->phonemes.percent[lipFlappingTargetPhoneme]) {
+	if(lowLatency && !streamingEnabled && lipFlappingAmount > videoFrame->phonemes.percent[lipFlappingTargetPhoneme]) {
 		videoFrame->phonemes.percent[lipFlappingTargetPhoneme] = lipFlappingAmount;
 	}
 	videoFrame->lipFlappingAmount = lipFlappingAmount;
-	videoFrame->maxAmplitude = maxAmplitude;
-	videoFrame->peak = peak;
-}
-
-SphinxAudioFrame *SphinxDriver::getNextAvailableAudioFrame(int desiredBufferSize) {
-	YerFace_MutexLock(recognitionMutex);
-	for(SphinxAudioFrame *audioFrame : audioFramesAllocated) {
-		if(!audioFrame->inUse) {
-			if(audioFrame->bufferSize < desiredBufferSize) {
-				//Not using realloc because it does not support guaranteed buffer alignment.
-				av_freep(&audioFrame->buf);
-				if((audioFrame->buf = (uint8_t *)av_malloc(desiredBufferSize)) == NULL) {
-					throw runtime_error("unable to allocate memory for audio frame");
-				}
-				audioFrame->bufferSize = desiredBufferSize;
-			}
-			audioFrame->pos = 0;
-			audioFrame->inUse = true;
-			YerFace_MutexUnlock(recognitionMutex);
-			return audioFrame;
-		}
-	}
-	SphinxAudioFrame *audioFrame = new SphinxAudioFrame();
-	if((audioFrame->buf = (uint8_t *)av_malloc(desiredBufferSize)) == NULL) {
-		throw runtime_error("unable to allocate memory for audio frame");
-	}
-	audioFrame->bufferSize = desiredBufferSize;
-	audioFrame->pos = 0;
-	audioFrame->inUse = true;
-	audioFramesAllocated.push_front(audioFrame);
-	YerFace_MutexUnlock(recognitionMutex);
-	return audioFrame;
+	videoFrame->envelope = envelope;
 }
 
 void SphinxDriver::FFmpegDriverAudioFrameCallback(void *userdata, uint8_t *buf, int audioSamples, int audioBytes, double timestamp) {
@@ -457,19 +672,20 @@ void SphinxDriver::FFmpegDriverAudioFrameCallback(void *userdata, uint8_t *buf,
 	if(self->recognitionMutex == NULL) {
 		return;
 	}
-	YerFace_MutexLock(self->recognitionMutex);
 	if(!self->recognizerRunning) {
 		self->logger->err("Received an audio frame, but the recognition worker has already stopped! Dropping this audio frame!");
-		YerFace_MutexUnlock(self->recognitionMutex);
 		return;
 	}
-	SphinxAudioFrame *audioFrame = self->getNextAvailableAudioFrame(audioBytes);
-	memcpy(audioFrame->buf, buf, audioBytes);
-	audioFrame->audioSamples = audioSamples;
-	audioFrame->audioBytes = audioBytes;
-	audioFrame->timestamp = timestamp;
-	self->audioFrameQueue.push_front(audioFrame);
-	YerFace_MutexUnlock(self->recognitionMutex);
+	while(!self->audioFrameRing.pushFrame(buf, audioSamples, audioBytes, timestamp)) {
+		//Dropping audio would throw off the recognizer's timeline, so if recognition falls this far behind we hold up the demuxer instead.
+		if(self->status->getEmergency() || !self->recognizerRunning) {
+			return;
+		}
+		if(self->recognitionWorkerPool != NULL) {
+			self->recognitionWorkerPool->sendWorkerSignal();
+		}
+		SDL_Delay(1);
+	}
 	if(self->recognitionWorkerPool != NULL) {
 		self->recognitionWorkerPool->sendWorkerSignal();
 	}
@@ -513,6 +729,7 @@ void SphinxDriver::handleFrameStatusChange(void *userdata, WorkingFrameStatus ne
 			YerFace_MutexLock(self->workingVideoFramesMutex);
 			self->logger->debug4("handleFrameStatusChange() Frame #" YERFACE_FRAMENUMBER_FORMAT " waiting on Lip Flapping Worker. Queue depth is now %lu", frameNumber, self->workingVideoFrames.size());
 			self->workingVideoFrames[frameNumber]->isLipFlappingReady = true;
+			self->workingVideoFrames[frameNumber]->lipFlappingReadySeconds = (double)SDL_GetTicks() / (double)1000.0;
 			YerFace_MutexUnlock(self->workingVideoFramesMutex);
 			if(self->lipFlappingWorkerPool != NULL) {
 				self->lipFlappingWorkerPool->sendWorkerSignal();
@@ -548,39 +765,53 @@ bool SphinxDriver::recognitionWorkerHandler(WorkerPoolWorker *worker) {
 
 	bool didWork = false;
 
+	if(self->segmentDecoderWorkerPool != NULL) {
+		YerFace_MutexLock(self->recognitionMutex);
+		didWork = self->processAudioSegmentation(false);
+		YerFace_MutexUnlock(self->recognitionMutex);
+		return didWork;
+	}
+
+	AudioFrame *audioFrame = self->audioFrameRing.peekFrame();
 	YerFace_MutexLock(self->recognitionMutex);
-	if(self->audioFrameQueue.size() > 0) {
-		if(ps_process_raw(self->pocketSphinx, (int16 const *)self->audioFrameQueue.back()->buf, self->audioFrameQueue.back()->audioSamples, 0, 0) < 0) {
+	if(audioFrame != NULL) {
+		if(self->utteranceStartTimestamp < 0.0) {
+			self->utteranceStartTimestamp = audioFrame->timestamp;
+		}
+		if(ps_process_raw(self->pocketSphinx, (int16 const *)audioFrame->buf, audioFrame->audioSamples, 0, 0) < 0) {
 			throw runtime_error("Failed processing audio samples in PocketSphinx");
 		}
 		self->inSpeech = ps_get_in_speech(self->pocketSphinx);
 		SphinxRecognizerResult result;
-		result.maxAmplitude = 0.0;
 		result.inSpeech = self->inSpeech;
-		result.peak = false;
-		result.startTimestamp = self->audioFrameQueue.back()->timestamp;
-		result.endTimestamp = result.startTimestamp + ((double)self->audioFrameQueue.back()->audioSamples / (double)YERFACE_SPHINX_SAMPLERATE);
-		self->processAudioAmplitude(self->audioFrameQueue.back(), &result);
-		self->audioFrameQueue.back()->inUse = false;
-		self->audioFrameQueue.pop_back();
+		result.startTimestamp = audioFrame->timestamp;
+		result.endTimestamp = result.startTimestamp + ((double)audioFrame->audioSamples / (double)YERFACE_SPHINX_SAMPLERATE);
+		self->processAudioAmplitude(audioFrame, &result);
+		self->audioFrameRing.popFrame();
+		self->recognizedThroughTimestamp = result.endTimestamp;
 
 		if(self->inSpeech && self->utteranceRestarted) {
 			self->utteranceRestarted = false;
 		}
 
-		if(!self->inSpeech && !self->utteranceRestarted) {
+		//When streaming, long utterances are cut short so their phonemes don't have to wait for the speaker to pause.
+		bool utteranceTooLong = self->streamingEnabled && result.endTimestamp - self->utteranceStartTimestamp >= self->streamingMaxUtteranceSeconds;
+		if((!self->inSpeech && !self->utteranceRestarted) || utteranceTooLong) {
 			self->lastUtteranceEndedTimestamp = result.endTimestamp;
 			if(ps_end_utt(self->pocketSphinx) < 0) {
 				throw runtime_error("Failed to end PocketSphinx utterance");
 			}
-			if(!self->lowLatency) {
-				self->processUtteranceHypothesis();
+			if(!self->lowLatency || self->streamingEnabled) {
+				self->processUtteranceHypothesis(true);
 			}
 			self->utteranceIndex++;
 			if(ps_start_utt(self->pocketSphinx) < 0) {
 				throw runtime_error("Failed to start PocketSphinx utterance");
 			}
+			self->utteranceStartTimestamp = -1.0;
 			self->utteranceRestarted = true;
+		} else if(self->streamingEnabled && result.endTimestamp - self->lastPartialHypothesisTimestamp >= self->streamingPartialHypothesisIntervalSeconds) {
+			self->processUtteranceHypothesis(false);
 		}
 
 		if(!self->inSpeech && !self->lowLatency) {
@@ -594,7 +825,7 @@ bool SphinxDriver::recognitionWorkerHandler(WorkerPoolWorker *worker) {
 				phoneme.utteranceIndex = self->utteranceIndex;
 				phoneme.startTime = result.startTimestamp;
 				phoneme.endTime = result.endTimestamp;
-				phoneme.pbPhoneme = "";
+				phoneme.pbPhoneme = -1;
 				self->phonemeBuffer.push_front(phoneme);
 				if(self->phonemeBreakdownWorkerPool != NULL) {
 					self->phonemeBreakdownWorkerPool->sendWorkerSignal();
@@ -621,22 +852,111 @@ void SphinxDriver::recognitionWorkerDeinitializer(WorkerPoolWorker *worker, void
 	YerFace_MutexLock(self->recognitionMutex);
 
 	self->recognizerRunning = false;
+	if(self->segmentDecoderWorkerPool != NULL) {
+		//Audio which arrived just before the drain notification belongs in the final segment.
+		while(self->processAudioSegmentation(true));
+		self->queueCurrentSegment();
+		self->segmenterDrained = true;
+		self->mergeDecodedSegments();
+		YerFace_MutexUnlock(self->recognitionMutex);
+		return;
+	}
 	if(ps_end_utt(self->pocketSphinx) < 0) {
 		throw runtime_error("Failed to end PocketSphinx utterance");
 	}
-	if(!self->lowLatency) {
-		self->processUtteranceHypothesis();
+	if(!self->lowLatency || self->streamingEnabled) {
+		self->processUtteranceHypothesis(true);
 	}
 	self->recognizerDrained = true;
 
 	YerFace_MutexUnlock(self->recognitionMutex);
 }
 
+void SphinxDriver::segmentDecoderWorkerInitializer(WorkerPoolWorker *worker, void *usrPtr) {
+	SphinxDriver *self = (SphinxDriver *)usrPtr;
+	SphinxSegmentDecoder *innerWorker = new SphinxSegmentDecoder();
+	innerWorker->self = self;
+	innerWorker->decoder = self->acquireDecoder(&innerWorker->config);
+	worker->ptr = (void *)innerWorker;
+}
+
+bool SphinxDriver::segmentDecoderWorkerHandler(WorkerPoolWorker *worker) {
+	SphinxSegmentDecoder *innerWorker = (SphinxSegmentDecoder *)worker->ptr;
+	SphinxDriver *self = innerWorker->self;
+
+	//// CHECK FOR WORK ////
+	SphinxAudioSegment *segment = NULL;
+	YerFace_MutexLock(self->recognitionMutex);
+	for(SphinxAudioSegment *pendingSegment : self->pendingSegments) {
+		if(!pendingSegment->claimed) {
+			pendingSegment->claimed = true;
+			segment = pendingSegment;
+			break;
+		}
+	}
+	YerFace_MutexUnlock(self->recognitionMutex);
+	if(segment == NULL) {
+		return false;
+	}
+
+	//// DO THE WORK ////
+	//Once claimed, the segment's samples and phonemes belong to this worker until it is marked decoded.
+	self->logger->debug3("Segment Decoder Worker Thread #%d recognizing audio segment %d.", worker->num, segment->index);
+	if(ps_start_utt(innerWorker->decoder) < 0) {
+		throw runtime_error("Failed to start PocketSphinx utterance");
+	}
+	if(ps_process_raw(innerWorker->decoder, (int16 const *)segment->samples.data(), segment->samples.size(), 0, 1) < 0) {
+		throw runtime_error("Failed processing audio samples in PocketSphinx");
+	}
+	if(ps_end_utt(innerWorker->decoder) < 0) {
+		throw runtime_error("Failed to end PocketSphinx utterance");
+	}
+	int frameRate = cmd_ln_int32_r(innerWorker->config, "-frate");
+	ps_seg_t *segmentIterator = ps_seg_iter(innerWorker->decoder);
+	while(segmentIterator != NULL) {
+		int32 startFrame, endFrame;
+		ps_seg_frames(segmentIterator, &startFrame, &endFrame);
+		string symbol = ps_seg_word(segmentIterator);
+
+		auto mapping = self->sphinxToPrestonBlairPhonemeMapping.find(symbol);
+		if(mapping != self->sphinxToPrestonBlairPhonemeMapping.end()) {
+			SphinxPhoneme phoneme;
+			phoneme.utteranceIndex = segment->index;
+			phoneme.startTime = segment->startTimestamp + ((double)startFrame / (double)frameRate);
+			phoneme.endTime = segment->startTimestamp + ((double)endFrame / (double)frameRate);
+			phoneme.pbPhoneme = mapping->second;
+			segment->phonemes.push_back(phoneme);
+		} else {
+			self->logger->debug1("Sphinx reported a phoneme (%s) which we don't have in our mapping.", symbol.c_str());
+		}
+
+		segmentIterator = ps_seg_next(segmentIterator);
+	}
+	std::vector<int16_t>().swap(segment->samples);
+
+	YerFace_MutexLock(self->recognitionMutex);
+	segment->decoded = true;
+	self->mergeDecodedSegments();
+	YerFace_MutexUnlock(self->recognitionMutex);
+
+	//The recognition worker may have been waiting for room in the pending segments queue.
+	if(self->recognitionWorkerPool != NULL) {
+		self->recognitionWorkerPool->sendWorkerSignal();
+	}
+	return true;
+}
+
+void SphinxDriver::segmentDecoderWorkerDeinitializer(WorkerPoolWorker *worker, void *usrPtr) {
+	SphinxSegmentDecoder *innerWorker = (SphinxSegmentDecoder *)worker->ptr;
+	innerWorker->self->returnDecoder(innerWorker->decoder, innerWorker->config);
+	delete innerWorker;
+}
+
 bool SphinxDriver::lipFlappingWorkerHandler(WorkerPoolWorker *worker) {
 	SphinxDriver *self = (SphinxDriver *)worker->ptr;
 
 	bool didWork = false;
-	static FrameNumber lastFrameNumber = -1;
+	FrameNumber &lastFrameNumber = self->lipFlappingLastFrameNumber;
 	FrameNumber myFrameNumber = -1;
 	SphinxVideoFrame *videoFrame = NULL;
 
@@ -657,6 +977,10 @@ bool SphinxDriver::lipFlappingWorkerHandler(WorkerPoolWorker *worker) {
 			self->logger->debug4("Lip Flapping BLOCKED on frame " YERFACE_FRAMENUMBER_FORMAT " because it is not ready!", myFrameNumber);
 			myFrameNumber = -1;
 			videoFrame = NULL;
+		} else if(self->streamingEnabled && !self->isStreamingCaughtUp(videoFrame)) {
+			self->logger->debug4("Lip Flapping BLOCKED on frame " YERFACE_FRAMENUMBER_FORMAT " waiting for streamed phonemes.", myFrameNumber);
+			myFrameNumber = -1;
+			videoFrame = NULL;
 		}
 	}
 	YerFace_MutexUnlock(self->workingVideoFramesMutex);
@@ -672,15 +996,28 @@ bool SphinxDriver::lipFlappingWorkerHandler(WorkerPoolWorker *worker) {
 
 		YerFace_MutexLock(self->workingVideoFramesMutex);
 		self->processLipFlappingAudio(videoFrame);
-		json percent = videoFrame->phonemes.percent;
+		if(self->streamingEnabled) {
+			//Use whatever phonemes were streamed in time for this frame, and fall back on lip flapping if there weren't any.
+			self->processPhonemeBreakdown(videoFrame);
+			bool anyPhonemes = false;
+			for(int i = 0; i < YERFACE_PRESTONBLAIR_PHONEME_COUNT; i++) {
+				if(videoFrame->phonemes.percent[i] > 0.0) {
+					anyPhonemes = true;
+				}
+			}
+			if(!anyPhonemes) {
+				videoFrame->phonemes.percent[self->lipFlappingTargetPhoneme] = videoFrame->lipFlappingAmount;
+			}
+		}
+		PrestonBlairPhonemes phonemes = videoFrame->phonemes;
 		videoFrame->isLipFlappingProcessed = true;
 		YerFace_MutexUnlock(self->workingVideoFramesMutex);
 
 		if(self->lowLatency) {
-			self->outputDriver->insertFrameData("phonemes", percent, myFrameNumber);
+			self->outputDriver->insertFramePhonemes(phonemes, myFrameNumber);
 		}
 
-		self->frameServer->setWorkingFrameStatusCheckpoint(myFrameNumber, FRAME_STATUS_MAPPING, "sphinxDriver.ran");
+		self->frameServer->setWorkingFrameStatusCheckpoint(myFrameNumber, FRAME_STATUS_MAPPING, self->mappingCheckpoint);
 
 		didWork = true;
 	}
@@ -691,7 +1028,7 @@ bool SphinxDriver::phonemeBreakdownWorkerHandler(WorkerPoolWorker *worker) {
 	SphinxDriver *self = (SphinxDriver *)worker->ptr;
 
 	bool didWork = false;
-	static FrameNumber lastFrameNumber = -1;
+	FrameNumber &lastFrameNumber = self->phonemeBreakdownLastFrameNumber;
 	FrameNumber myFrameNumber = -1;
 	SphinxVideoFrame *videoFrame = NULL;
 
@@ -726,18 +1063,18 @@ bool SphinxDriver::phonemeBreakdownWorkerHandler(WorkerPoolWorker *worker) {
 
 		YerFace_MutexLock(self->workingVideoFramesMutex);
 		bool processed = self->processPhonemeBreakdown(videoFrame);
-		json percent;
+		PrestonBlairPhonemes phonemes;
 		if(processed) {
-			percent = videoFrame->phonemes.percent;
+			phonemes = videoFrame->phonemes;
 			videoFrame->isPhonemeBreakdownProcessed = true;
 		}
 		YerFace_MutexUnlock(self->workingVideoFramesMutex);
 		if(processed) {
 			if(!self->lowLatency) {
-				self->outputDriver->insertFrameData("phonemes", percent, myFrameNumber);
+				self->outputDriver->insertFramePhonemes(phonemes, myFrameNumber);
 			}
 
-			self->frameServer->setWorkingFrameStatusCheckpoint(myFrameNumber, FRAME_STATUS_LATE_PROCESSING, "sphinxDriver.ran");
+			self->frameServer->setWorkingFrameStatusCheckpoint(myFrameNumber, FRAME_STATUS_LATE_PROCESSING, self->lateProcessingCheckpoint);
 			lastFrameNumber = myFrameNumber;
 			didWork = true;
 		}
@@ -22,39 +22,34 @@ using namespace std;
 namespace YerFace {
 
 #define YERFACE_SPHINX_SAMPLERATE 16000
-
-// We use the Preston Blair 'toon phoneme set. See: http://minyos.its.rmit.edu.au/aim/a_notes/mouth_shapes_01.html
-// This class will represent a single video frame's snapshot of phoneme representation.
-// There will be Booleans for if we saw the phoneme at all, and floating point percentages (0.0 - 1.0) for the influence of each phoneme on the frame.
-class PrestonBlairPhonemes {
-public:
-	PrestonBlairPhonemes(void);
-	json percent;
-};
+#define YERFACE_SPHINX_MAX_AUTO_SEGMENT_DECODERS 4
+#define YERFACE_SPHINX_MAX_PENDING_SEGMENTS_PER_DECODER 4
 
 class SphinxPhoneme {
 public:
-	string pbPhoneme;
+	int pbPhoneme; //Index into PrestonBlairPhonemes, or -1 for silence.
 	double startTime, endTime;
 	int utteranceIndex;
 };
 
-class SphinxRecognizerResult {
+//In offline mode with several segment decoders, the audio is split at pauses into segments which are recognized independently.
+class SphinxAudioSegment {
 public:
+	int index;
 	double startTimestamp, endTimestamp;
-	double maxAmplitude;
-	bool peak, inSpeech;
+	std::vector<int16_t> samples;
+	bool claimed, decoded;
+	list<SphinxPhoneme> phonemes; //In time order, once decoded.
 };
 
-class SphinxAudioFrame {
+class SphinxSegmentDecoder;
+class SphinxCachedDecoder;
+
+class SphinxRecognizerResult {
 public:
-	uint8_t *buf;
-	int pos;
-	int audioSamples;
-	int audioBytes;
-	int bufferSize;
-	double timestamp;
-	bool inUse;
+	double startTimestamp, endTimestamp;
+	AudioEnvelope envelope;
+	bool inSpeech;
 };
 
 class SphinxVideoFrame {
@@ -62,9 +57,10 @@ public:
 	bool isLipFlappingReady, isLipFlappingProcessed;
 	bool isPhonemeBreakdownReady, isPhonemeBreakdownProcessed;
 	FrameTimestamps timestamps;
+	double lipFlappingReadySeconds; //Wall clock time when the frame became ready for lip flapping, for the streaming latency budget.
 	PrestonBlairPhonemes phonemes;
-	bool peak;
-	double maxAmplitude, lipFlappingAmount;
+	AudioEnvelope envelope; //All of the audio overlapping this frame, rolled up once and shared by lip flapping and the VU meter.
+	double lipFlappingAmount;
 };
 
 class SphinxDriver {
@@ -72,27 +68,39 @@ public:
 	SphinxDriver(json config, Status *myStatus, FrameServer *myFrameServer, FFmpegDriver *myFFmpegDriver, SDLDriver *mySDLDriver, OutputDriver *myOutputDriver, PreviewHUD *myPreviewHUD, bool myLowLatency);
 	~SphinxDriver() noexcept(false);
 	void renderPreviewHUD(cv::Mat frame, FrameNumber frameNumber, int density, bool mirrorMode);
+	static void releaseCachedDecoders(void);
 private:
 	bool processPhonemeBreakdown(SphinxVideoFrame *videoFrame);
-	void processUtteranceHypothesis(void);
-	void processAudioAmplitude(SphinxAudioFrame *audioFrame, SphinxRecognizerResult *result);
+	void processUtteranceHypothesis(bool final);
+	bool isStreamingCaughtUp(SphinxVideoFrame *videoFrame);
+	PocketSphinx::cmd_ln_t *createSphinxConfig(void);
+	PocketSphinx::ps_decoder_t *acquireDecoder(PocketSphinx::cmd_ln_t **decoderConfig);
+	void returnDecoder(PocketSphinx::ps_decoder_t *decoder, PocketSphinx::cmd_ln_t *decoderConfig);
+	bool processAudioSegmentation(bool draining);
+	void queueCurrentSegment(void);
+	void mergeDecodedSegments(void);
+	void processAudioAmplitude(AudioFrame *audioFrame, SphinxRecognizerResult *result);
 	void processLipFlappingAudio(SphinxVideoFrame *videoFrame);
-	SphinxAudioFrame *getNextAvailableAudioFrame(int desiredBufferSize);
 	static void FFmpegDriverAudioFrameCallback(void *userdata, uint8_t *buf, int audioSamples, int audioBytes, double timestamp);
 	static void FFmpegDriverAudioIsDrainedCallback(void *userdata);
 	static void handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps);
 	static bool recognitionWorkerHandler(WorkerPoolWorker *worker);
 	static void recognitionWorkerDeinitializer(WorkerPoolWorker *worker, void *usrPtr);
+	static void segmentDecoderWorkerInitializer(WorkerPoolWorker *worker, void *usrPtr);
+	static bool segmentDecoderWorkerHandler(WorkerPoolWorker *worker);
+	static void segmentDecoderWorkerDeinitializer(WorkerPoolWorker *worker, void *usrPtr);
 	static bool lipFlappingWorkerHandler(WorkerPoolWorker *worker);
 	static bool phonemeBreakdownWorkerHandler(WorkerPoolWorker *worker);
 	static void sphinxLogCallback(void *user_data, PocketSphinx::err_lvl_t level, const char *fmt, ...);
 	
 	string hiddenMarkovModel, allPhoneLM;
-	string lipFlappingTargetPhoneme;
+	int lipFlappingTargetPhoneme;
 	double lipFlappingResponseThreshold, lipFlappingNonLinearResponse, lipFlappingNotInSpeechScale, sphinxInfluenceOfLipFlappingOnResult;
-	json sphinxToPrestonBlairPhonemeMapping;
+	unordered_map<string, int> sphinxToPrestonBlairPhonemeMapping;
 	Status *status;
 	FrameServer *frameServer;
+	FrameStatusCheckpoint mappingCheckpoint;
+	FrameStatusCheckpoint lateProcessingCheckpoint;
 	FFmpegDriver *ffmpegDriver;
 	SDLDriver *sdlDriver;
 	OutputDriver *outputDriver;
@@ -100,28 +108,50 @@ private:
 	bool lowLatency;
 	Logger *logger;
 
+	bool streamingEnabled;
+	double streamingMaxUtteranceSeconds, streamingPartialHypothesisIntervalSeconds, streamingStabilityMarginSeconds, streamingLatencyBudgetSeconds;
+
+	int segmentDecoders;
+	double segmentSilenceThreshold, segmentMinSilenceSeconds, segmentMinSeconds, segmentMaxSeconds;
+
 	double vuMeterWidth, vuMeterWarningThreshold, vuMeterPeakHoldSeconds;
+	double vuMeterLastSetPeak;
 
 	PocketSphinx::ps_decoder_t *pocketSphinx;
 	PocketSphinx::cmd_ln_t *pocketSphinxConfig;
 
 	WorkerPool *recognitionWorkerPool;
 	SDL_mutex *recognitionMutex;
-	bool recognizerRunning, recognizerDrained;
-	list<SphinxAudioFrame *> audioFrameQueue;
-	list<SphinxAudioFrame *> audioFramesAllocated;
+	std::atomic<bool> recognizerRunning;
+	bool recognizerDrained;
+	AudioFrameRing audioFrameRing; //Filled by the FFmpegDriver demuxer thread, drained by the recognition worker.
 	bool utteranceRestarted, inSpeech;
 	int utteranceIndex;
+	double utteranceStartTimestamp; //Sphinx reports segments in frames since the start of the utterance. Negative until the first audio of an utterance arrives.
+	double recognizedThroughTimestamp; //End of the newest audio fed to Sphinx.
+	double phonemesEmittedThroughTimestamp; //End of the newest phoneme added to phonemeBuffer, so partial hypotheses never add a phoneme twice.
+	double phonemesStableThroughTimestamp; //phonemeBuffer won't get any more phonemes before this time.
+	double lastPartialHypothesisTimestamp;
 	double lastUtteranceEndedTimestamp;
 	list<SphinxRecognizerResult> recognitionResults;
 	list<SphinxPhoneme> phonemeBuffer;
 
+	WorkerPool *segmentDecoderWorkerPool; //NULL unless recognition is split across segment decoders.
+	SphinxAudioSegment *currentSegment; //Being filled by the recognition worker. Protected by recognitionMutex, like everything below.
+	double currentSegmentSilenceSeconds;
+	list<SphinxAudioSegment *> pendingSegments; //In time order. Merged into phonemeBuffer from the front as they finish decoding.
+	bool segmenterDrained;
+
 	WorkerPool *lipFlappingWorkerPool, *phonemeBreakdownWorkerPool;
 	SDL_mutex *workingVideoFramesMutex;
-	unordered_map<FrameNumber, SphinxVideoFrame *> workingVideoFrames;
+	FrameSlotRing<SphinxVideoFrame *> workingVideoFrames;
+	FrameNumber lipFlappingLastFrameNumber, phonemeBreakdownLastFrameNumber;
 
 	Logger *sphinxLogger;
 	SDL_mutex *sphinxLoggerMutex;
+
+	static std::list<SphinxCachedDecoder *> cachedDecoders; //Idle recognizers, reused by the next SphinxDriver. Protected by cachedDecodersMutex.
+	static SDL_mutex *cachedDecodersMutex;
 };
 
 }; //namespace YerFace
@@ -9,7 +9,7 @@ namespace YerFace {
 
 Status::Status(bool myLowLatency) {
 	lowLatency = myLowLatency;
-	if((myMutex = SDL_CreateMutex()) == NULL) {
+	if((myMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
 	logger = new Logger("Status");
@@ -25,7 +25,7 @@ Status::Status(bool myLowLatency) {
 
 Status::~Status() noexcept(false) {
 	logger->debug1("Status object destructing...");
-	SDL_DestroyMutex(myMutex);
+	YerFace_DestroyMutex(myMutex);
 	delete logger;
 }
 
@@ -2,14 +2,132 @@
 #include "Utilities.hpp"
 #define _USE_MATH_DEFINES
 #include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <new>
 #include <sys/stat.h>
 #include <regex>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#ifdef WIN32
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <csignal>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#endif
 
 using namespace std;
 using namespace cv;
 
+#ifdef YERFACE_ALLOCATION_COUNTING
+static thread_local uint64_t threadAllocations = 0;
+
+void *operator new(size_t size) {
+	threadAllocations++;
+	void *ptr = malloc(size > 0 ? size : 1);
+	if(ptr == NULL) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+	free(ptr);
+}
+#endif
+
 namespace YerFace {
 
+uint64_t AllocationCounter::getThreadAllocations(void) {
+	#ifdef YERFACE_ALLOCATION_COUNTING
+	return threadAllocations;
+	#else
+	return 0;
+	#endif
+}
+
+AudioEnvelope::AudioEnvelope(void) {
+	peak = 0.0;
+	clipped = false;
+	sumOfSquares = 0.0;
+	samples = 0;
+}
+
+void AudioEnvelope::accumulate(const AudioEnvelope &other) {
+	if(other.peak > peak) {
+		peak = other.peak;
+	}
+	clipped = clipped || other.clipped;
+	sumOfSquares += other.sumOfSquares;
+	samples += other.samples;
+}
+
+double AudioEnvelope::getRMS(void) const {
+	if(samples < 1) {
+		return 0.0;
+	}
+	return sqrt(sumOfSquares / (double)samples);
+}
+
+AudioEnvelope Utilities::calculateAudioEnvelope(const int16_t *samples, int count, bool vectorized) {
+	int32_t maxSample = 0, minSample = 0;
+	uint64_t squares = 0;
+	int i = 0;
+#if defined(__SSE2__)
+	if(vectorized) {
+		//Eight samples at a time. We track the max and min separately because the absolute value of -32768 doesn't fit in an int16.
+		__m128i maxVector = _mm_setzero_si128(), minVector = _mm_setzero_si128();
+		__m128i squaresVector = _mm_setzero_si128(), zero = _mm_setzero_si128();
+		for(; i + 8 <= count; i += 8) {
+			__m128i sampleVector = _mm_loadu_si128((const __m128i *)(samples + i));
+			maxVector = _mm_max_epi16(maxVector, sampleVector);
+			minVector = _mm_min_epi16(minVector, sampleVector);
+			//Each pair of squares sums to at most 2^31, which is exact when read as unsigned, so widen to 64 bits with zeros.
+			__m128i pairSquares = _mm_madd_epi16(sampleVector, sampleVector);
+			squaresVector = _mm_add_epi64(squaresVector, _mm_unpacklo_epi32(pairSquares, zero));
+			squaresVector = _mm_add_epi64(squaresVector, _mm_unpackhi_epi32(pairSquares, zero));
+		}
+		int16_t maxLanes[8], minLanes[8];
+		uint64_t squaresLanes[2];
+		_mm_storeu_si128((__m128i *)maxLanes, maxVector);
+		_mm_storeu_si128((__m128i *)minLanes, minVector);
+		_mm_storeu_si128((__m128i *)squaresLanes, squaresVector);
+		for(int lane = 0; lane < 8; lane++) {
+			maxSample = std::max(maxSample, (int32_t)maxLanes[lane]);
+			minSample = std::min(minSample, (int32_t)minLanes[lane]);
+		}
+		squares = squaresLanes[0] + squaresLanes[1];
+	}
+#endif
+	for(; i < count; i++) {
+		int32_t sample = samples[i];
+		maxSample = std::max(maxSample, sample);
+		minSample = std::min(minSample, sample);
+		squares += (uint64_t)(sample * sample);
+	}
+
+	AudioEnvelope envelope;
+	envelope.samples = count;
+	envelope.peak = (double)std::max(maxSample, -minSample) / (double)0x7FFF;
+	if(envelope.peak >= 1.0) {
+		envelope.peak = 1.0;
+		envelope.clipped = true;
+	}
+	envelope.sumOfSquares = (double)squares / ((double)0x7FFF * (double)0x7FFF);
+	return envelope;
+}
+
 double Utilities::normalize(double x, double length) {
 	return (1.0/length) * x;
 }
@@ -394,7 +512,450 @@ string Utilities::stringTrimRight(std::string str) {
 	return str;
 }
 
+string Utilities::shellQuoteArgument(string argument) {
+	string quoted;
+	#ifdef WIN32
+		quoted = "\"";
+		for(char c : argument) {
+			if(c == '"') {
+				quoted += "\\\"";
+			} else {
+				quoted += c;
+			}
+		}
+		quoted += "\"";
+	#else
+		quoted = "'";
+		for(char c : argument) {
+			if(c == '\'') {
+				quoted += "'\\''";
+			} else {
+				quoted += c;
+			}
+		}
+		quoted += "'";
+	#endif
+	return quoted;
+}
+
+MappedFileBuffer::MappedFileBuffer(string filePath) {
+	#ifdef WIN32
+		fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if(fileHandle == INVALID_HANDLE_VALUE) {
+			throw runtime_error("Failed opening file for mapping: " + filePath);
+		}
+		LARGE_INTEGER fileSize;
+		if(!GetFileSizeEx((HANDLE)fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+			CloseHandle((HANDLE)fileHandle);
+			throw runtime_error("Failed getting size of file, or file is empty: " + filePath);
+		}
+		size = (size_t)fileSize.QuadPart;
+		if((mappingHandle = CreateFileMappingA((HANDLE)fileHandle, NULL, PAGE_READONLY, 0, 0, NULL)) == NULL) {
+			CloseHandle((HANDLE)fileHandle);
+			throw runtime_error("Failed creating file mapping: " + filePath);
+		}
+		if((data = (char *)MapViewOfFile((HANDLE)mappingHandle, FILE_MAP_READ, 0, 0, 0)) == NULL) {
+			CloseHandle((HANDLE)mappingHandle);
+			CloseHandle((HANDLE)fileHandle);
+			throw runtime_error("Failed mapping view of file: " + filePath);
+		}
+	#else
+		int fd;
+		if((fd = open(filePath.c_str(), O_RDONLY)) < 0) {
+			throw runtime_error("Failed opening file for mapping: " + filePath);
+		}
+		struct stat fileStat;
+		if(fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+			close(fd);
+			throw runtime_error("Failed getting size of file, or file is empty: " + filePath);
+		}
+		size = (size_t)fileStat.st_size;
+		void *mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if(mapping == MAP_FAILED) {
+			throw runtime_error("Failed mapping file: " + filePath);
+		}
+		data = (char *)mapping;
+		madvise(mapping, size, MADV_SEQUENTIAL);
+	#endif
+	setg(data, data, data + size);
+}
+
+MappedFileBuffer::~MappedFileBuffer() noexcept(false) {
+	#ifdef WIN32
+		UnmapViewOfFile(data);
+		CloseHandle((HANDLE)mappingHandle);
+		CloseHandle((HANDLE)fileHandle);
+	#else
+		munmap(data, size);
+	#endif
+}
+
+size_t MappedFileBuffer::getSize(void) {
+	return size;
+}
+
+ChildProcessPipe::ChildProcessPipe(string command) {
+	exited = false;
+	exitCode = -1;
+	#ifdef WIN32
+		SECURITY_ATTRIBUTES securityAttributes;
+		securityAttributes.nLength = sizeof(SECURITY_ATTRIBUTES);
+		securityAttributes.bInheritHandle = TRUE;
+		securityAttributes.lpSecurityDescriptor = NULL;
+		HANDLE inputRead, inputWrite, outputRead, outputWrite;
+		if(!CreatePipe(&inputRead, &inputWrite, &securityAttributes, 0)) {
+			throw runtime_error("Failed creating child process input pipe!");
+		}
+		if(!CreatePipe(&outputRead, &outputWrite, &securityAttributes, 0)) {
+			CloseHandle(inputRead);
+			CloseHandle(inputWrite);
+			throw runtime_error("Failed creating child process output pipe!");
+		}
+		//Only the child's ends of the pipes should be inherited.
+		SetHandleInformation(inputWrite, HANDLE_FLAG_INHERIT, 0);
+		SetHandleInformation(outputRead, HANDLE_FLAG_INHERIT, 0);
+		STARTUPINFOA startupInfo;
+		ZeroMemory(&startupInfo, sizeof(startupInfo));
+		startupInfo.cb = sizeof(startupInfo);
+		startupInfo.dwFlags = STARTF_USESTDHANDLES;
+		startupInfo.hStdInput = inputRead;
+		startupInfo.hStdOutput = outputWrite;
+		startupInfo.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+		PROCESS_INFORMATION processInfo;
+		ZeroMemory(&processInfo, sizeof(processInfo));
+		string commandLine = "cmd.exe /c \"" + command + "\"";
+		std::vector<char> commandLineBuffer(commandLine.begin(), commandLine.end());
+		commandLineBuffer.push_back('\0');
+		BOOL created = CreateProcessA(NULL, commandLineBuffer.data(), NULL, NULL, TRUE, 0, NULL, NULL, &startupInfo, &processInfo);
+		CloseHandle(inputRead);
+		CloseHandle(outputWrite);
+		if(!created) {
+			CloseHandle(inputWrite);
+			CloseHandle(outputRead);
+			throw runtime_error("Failed spawning child process!");
+		}
+		CloseHandle(processInfo.hThread);
+		processHandle = processInfo.hProcess;
+		childInput = _fdopen(_open_osfhandle((intptr_t)inputWrite, _O_WRONLY), "wb");
+		childOutput = _fdopen(_open_osfhandle((intptr_t)outputRead, _O_RDONLY), "rb");
+	#else
+		//Spawns are serialized so that a sibling child can't be forked while our ends of these pipes are still inheritable.
+		static SDL_mutex *spawnMutex = SDL_CreateMutex();
+		YerFace_MutexLock_Trivial(spawnMutex);
+		int inputPipe[2], outputPipe[2];
+		if(pipe(inputPipe) != 0) {
+			YerFace_MutexUnlock_Trivial(spawnMutex);
+			throw runtime_error("Failed creating child process input pipe!");
+		}
+		if(pipe(outputPipe) != 0) {
+			close(inputPipe[0]);
+			close(inputPipe[1]);
+			YerFace_MutexUnlock_Trivial(spawnMutex);
+			throw runtime_error("Failed creating child process output pipe!");
+		}
+		fcntl(inputPipe[0], F_SETFD, FD_CLOEXEC);
+		fcntl(inputPipe[1], F_SETFD, FD_CLOEXEC);
+		fcntl(outputPipe[0], F_SETFD, FD_CLOEXEC);
+		fcntl(outputPipe[1], F_SETFD, FD_CLOEXEC);
+		processID = fork();
+		if(processID == 0) {
+			//Whatever we've chosen to ignore (SIGPIPE, most likely) shouldn't be ignored by the child too.
+			signal(SIGPIPE, SIG_DFL);
+			dup2(inputPipe[0], STDIN_FILENO);
+			dup2(outputPipe[1], STDOUT_FILENO);
+			execl("/bin/sh", "sh", "-c", command.c_str(), (char *)NULL);
+			_exit(127);
+		}
+		close(inputPipe[0]);
+		close(outputPipe[1]);
+		YerFace_MutexUnlock_Trivial(spawnMutex);
+		if(processID < 0) {
+			close(inputPipe[1]);
+			close(outputPipe[0]);
+			throw runtime_error("Failed forking child process!");
+		}
+		childInput = fdopen(inputPipe[1], "w");
+		childOutput = fdopen(outputPipe[0], "r");
+	#endif
+	if(childInput == NULL || childOutput == NULL) {
+		throw runtime_error("Failed opening child process pipes!");
+	}
+}
+
+ChildProcessPipe::~ChildProcessPipe() noexcept(false) {
+	wait();
+	if(childOutput != NULL) {
+		fclose(childOutput);
+	}
+}
+
+bool ChildProcessPipe::writeLine(string line) {
+	if(childInput == NULL) {
+		return false;
+	}
+	line += "\n";
+	if(fputs(line.c_str(), childInput) < 0 || fflush(childInput) != 0) {
+		return false;
+	}
+	return true;
+}
+
+bool ChildProcessPipe::readLine(string *line) {
+	line->clear();
+	int c;
+	while((c = fgetc(childOutput)) != EOF) {
+		if(c == '\n') {
+			break;
+		}
+		if(c != '\r') {
+			*line += (char)c;
+		}
+	}
+	return c != EOF || line->length() > 0;
+}
+
+void ChildProcessPipe::closeInput(void) {
+	if(childInput != NULL) {
+		fclose(childInput);
+		childInput = NULL;
+	}
+}
+
+int ChildProcessPipe::wait(void) {
+	closeInput();
+	if(!exited) {
+		#ifdef WIN32
+			WaitForSingleObject((HANDLE)processHandle, INFINITE);
+			DWORD processExitCode;
+			if(GetExitCodeProcess((HANDLE)processHandle, &processExitCode)) {
+				exitCode = (int)processExitCode;
+			}
+			CloseHandle((HANDLE)processHandle);
+		#else
+			int processStatus;
+			pid_t waited;
+			while((waited = waitpid(processID, &processStatus, 0)) < 0 && errno == EINTR);
+			if(waited == processID && WIFEXITED(processStatus)) {
+				exitCode = WEXITSTATUS(processStatus);
+			}
+		#endif
+		exited = true;
+	}
+	return exitCode;
+}
+
 Logger *Utilities::logger = new Logger("Utilities");
 char *Utilities::sdlDataPath = NULL;
 
+uint64_t InstrumentedMutex::nowNanoseconds(void) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+SDL_mutex *InstrumentedMutex::getRegistryMutex(void) {
+	//Mutexes are created during static initialization, so the registry can't rely on a static of its own being ready first.
+	static SDL_mutex *registryMutex = SDL_CreateMutex();
+	if(registryMutex == NULL) {
+		throw runtime_error("Failed creating mutex registry mutex!");
+	}
+	return registryMutex;
+}
+
+size_t InstrumentedMutex::hashSlot(SDL_mutex *mutex) {
+	return (size_t)(((uintptr_t)mutex >> 4) % YERFACE_MUTEX_STATISTICS_SLOTS);
+}
+
+SDL_mutex *InstrumentedMutex::create(const char *file, int line) {
+	SDL_mutex *mutex = SDL_CreateMutex();
+	if(mutex == NULL) {
+		return NULL;
+	}
+	SDL_mutex *registryMutex = getRegistryMutex();
+	YerFace_MutexLock_Trivial(registryMutex);
+	MutexStatistics *site = NULL;
+	for(size_t i = 0; i < sitesUsed; i++) {
+		if(sites[i].line == line && strcmp(sites[i].file, file) == 0) {
+			site = &sites[i];
+			break;
+		}
+	}
+	if(site == NULL && sitesUsed < YERFACE_MUTEX_STATISTICS_SITES) {
+		site = &sites[sitesUsed++];
+		site->file = file;
+		site->line = line;
+	}
+	MutexInstance *instance = NULL;
+	if(site != NULL) {
+		size_t start = hashSlot(mutex);
+		for(size_t i = 0; i < YERFACE_MUTEX_STATISTICS_SLOTS; i++) {
+			MutexInstance *slot = &instances[(start + i) % YERFACE_MUTEX_STATISTICS_SLOTS];
+			SDL_mutex *current = slot->mutex.load();
+			if(current == NULL || current == YERFACE_MUTEX_SLOT_RELEASED) {
+				instance = slot;
+				break;
+			}
+		}
+	}
+	if(instance != NULL) {
+		site->instances++;
+		instance->statistics = site;
+		instance->depth = 0;
+		instance->mutex.store(mutex); //Publishes the slot to findInstance().
+	} else if(!overflowLogged) {
+		overflowLogged = true;
+		YerFace_SLog("Utilities", LOG_SEVERITY_WARNING, "Mutex statistics table is full! Mutexes created from now on (starting at %s:%d) will work, but will not be counted.", file, line);
+	}
+	YerFace_MutexUnlock_Trivial(registryMutex);
+	return mutex;
+}
+
+void InstrumentedMutex::destroy(SDL_mutex *mutex) {
+	if(mutex == NULL) {
+		return;
+	}
+	SDL_mutex *registryMutex = getRegistryMutex();
+	YerFace_MutexLock_Trivial(registryMutex);
+	MutexInstance *instance = findInstance(mutex);
+	if(instance != NULL) {
+		//Probe sequences continue past released slots. Only a released slot at the end of a sequence can go back to being empty.
+		size_t slot = instance - instances;
+		instance->mutex.store(YERFACE_MUTEX_SLOT_RELEASED);
+		while(instances[slot].mutex.load() == YERFACE_MUTEX_SLOT_RELEASED && instances[(slot + 1) % YERFACE_MUTEX_STATISTICS_SLOTS].mutex.load() == NULL) {
+			instances[slot].mutex.store(NULL);
+			slot = (slot + YERFACE_MUTEX_STATISTICS_SLOTS - 1) % YERFACE_MUTEX_STATISTICS_SLOTS;
+		}
+	}
+	YerFace_MutexUnlock_Trivial(registryMutex);
+	SDL_DestroyMutex(mutex);
+}
+
+MutexInstance *InstrumentedMutex::findInstance(SDL_mutex *mutex) {
+	size_t start = hashSlot(mutex);
+	for(size_t i = 0; i < YERFACE_MUTEX_STATISTICS_SLOTS; i++) {
+		MutexInstance *slot = &instances[(start + i) % YERFACE_MUTEX_STATISTICS_SLOTS];
+		SDL_mutex *current = slot->mutex.load();
+		if(current == mutex) {
+			return slot;
+		}
+		if(current == NULL) {
+			break;
+		}
+	}
+	//Not created with YerFace_CreateMutex(), or the statistics table was full. We'll still lock, we just won't count.
+	return NULL;
+}
+
+void InstrumentedMutex::lock(SDL_mutex *mutex, const char *name, const char *file, int line) {
+	MutexInstance *instance = findInstance(mutex);
+	MutexStatistics *stats = instance != NULL ? instance->statistics : NULL;
+	if(stats != NULL && stats->name.load() == NULL) {
+		const char *expected = NULL;
+		stats->name.compare_exchange_strong(expected, name);
+	}
+	int result = SDL_TryLockMutex(mutex);
+	if(result == -1) {
+		YerFace_SLog("Utilities", LOG_SEVERITY_CRIT, "Failed to lock mutex %s (%p). Error was: %s", name, mutex, SDL_GetError());
+		throw runtime_error("Failed to lock mutex.");
+	}
+	if(result == SDL_MUTEX_TIMEDOUT) {
+		//Contended. Block until we get it.
+		uint64_t waitStart = nowNanoseconds();
+		#ifdef YERFACE_MUTEX_DEADLOCK_DETECTION
+		uint32_t delay = 0;
+		while((result = SDL_TryLockMutex(mutex)) == SDL_MUTEX_TIMEDOUT) {
+			if((nowNanoseconds() - waitStart) / 1000000 > YERFACE_MUTEX_DEADLOCK_TIMEOUT) {
+				YerFace_SLog("Utilities", LOG_SEVERITY_CRIT, "Lock attempt on mutex %s (%p) at %s:%d timed out! No more retries...", name, mutex, file, line);
+				throw runtime_error("Break glass! Mutex lock timed out; possible deadlock. (This was probably caused by an earlier exception!!!)");
+			}
+			SDL_Delay(delay);
+			if(delay < 10) {
+				delay++;
+			}
+		}
+		#else
+		result = SDL_LockMutex(mutex);
+		#endif
+		if(result != 0) {
+			YerFace_SLog("Utilities", LOG_SEVERITY_CRIT, "Failed to lock mutex %s (%p). Error was: %s", name, mutex, SDL_GetError());
+			throw runtime_error("Failed to lock mutex.");
+		}
+		if(stats != NULL) {
+			uint64_t waited = nowNanoseconds() - waitStart;
+			stats->contendedAcquisitions++;
+			stats->waitNanoseconds += waited;
+			uint64_t worst = stats->worstWaitNanoseconds.load();
+			while(waited > worst && !stats->worstWaitNanoseconds.compare_exchange_weak(worst, waited)) { }
+		}
+	}
+	if(stats != NULL) {
+		stats->acquisitions++;
+		SDL_threadID self = SDL_ThreadID();
+		if(instance->depth > 0 && instance->owner == self) {
+			instance->depth++;
+		} else {
+			instance->owner = self;
+			instance->depth = 1;
+			instance->lockedAtNanoseconds = nowNanoseconds();
+		}
+	}
+}
+
+void InstrumentedMutex::unlock(SDL_mutex *mutex, const char *name) {
+	MutexInstance *instance = findInstance(mutex);
+	if(instance != NULL && instance->depth > 0) {
+		instance->depth--;
+		if(instance->depth == 0) {
+			instance->statistics->holdNanoseconds += nowNanoseconds() - instance->lockedAtNanoseconds;
+		}
+	}
+	if(SDL_UnlockMutex(mutex) != 0) {
+		YerFace_SLog("Utilities", LOG_SEVERITY_CRIT, "Failed to unlock mutex %s (%p). Error was: %s", name, mutex, SDL_GetError());
+		throw runtime_error("Failed to unlock mutex.");
+	}
+}
+
+int InstrumentedMutex::condWaitTimeout(SDL_cond *cond, SDL_mutex *mutex, Uint32 milliseconds) {
+	//The mutex is released while we wait on the condition, so that time doesn't count as holding it.
+	MutexInstance *instance = findInstance(mutex);
+	if(instance != NULL && instance->depth > 0) {
+		instance->statistics->holdNanoseconds += nowNanoseconds() - instance->lockedAtNanoseconds;
+	}
+	int result = SDL_CondWaitTimeout(cond, mutex, milliseconds);
+	if(instance != NULL && instance->depth > 0) {
+		instance->owner = SDL_ThreadID();
+		instance->lockedAtNanoseconds = nowNanoseconds();
+	}
+	return result;
+}
+
+void InstrumentedMutex::logReport(void) {
+	std::vector<MutexStatistics *> report;
+	SDL_mutex *registryMutex = getRegistryMutex();
+	YerFace_MutexLock_Trivial(registryMutex);
+	for(size_t i = 0; i < sitesUsed; i++) {
+		if(sites[i].acquisitions > 0) {
+			report.push_back(&sites[i]);
+		}
+	}
+	YerFace_MutexUnlock_Trivial(registryMutex);
+	std::sort(report.begin(), report.end(), [](MutexStatistics *a, MutexStatistics *b) {
+		return a->waitNanoseconds.load() > b->waitNanoseconds.load();
+	});
+	Logger::slog("Utilities", LOG_SEVERITY_INFO, "Mutex contention report for %lu mutex creation sites, sorted by total wait time:", (unsigned long)report.size());
+	int rank = 0;
+	for(MutexStatistics *stats : report) {
+		rank++;
+		Logger::slog("Utilities", rank <= 10 ? LOG_SEVERITY_INFO : LOG_SEVERITY_DEBUG1, "  %s (%s:%d) Instances: %lu, Acquisitions: %lu, Contended: %lu, Wait: <Total %.02lfms, Worst %.02lfms>, Hold: <Total %.02lfms>",
+			stats->name.load(), stats->file, stats->line,
+			(unsigned long)stats->instances.load(), (unsigned long)stats->acquisitions.load(), (unsigned long)stats->contendedAcquisitions.load(),
+			(double)stats->waitNanoseconds.load() / 1000000.0, (double)stats->worstWaitNanoseconds.load() / 1000000.0,
+			(double)stats->holdNanoseconds.load() / 1000000.0);
+	}
+}
+
+MutexInstance InstrumentedMutex::instances[YERFACE_MUTEX_STATISTICS_SLOTS];
+MutexStatistics InstrumentedMutex::sites[YERFACE_MUTEX_STATISTICS_SITES];
+size_t InstrumentedMutex::sitesUsed = 0;
+bool InstrumentedMutex::overflowLogged = false;
+
 }; //namespace YerFace
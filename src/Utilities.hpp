@@ -9,7 +9,10 @@
 #include <exception>
 #include <vector>
 #include <fstream>
+#include <streambuf>
 #include <chrono>
+#include <atomic>
+#include <cstdint>
 
 using namespace std;
 using json = nlohmann::json;
@@ -20,6 +23,11 @@ namespace YerFace {
 // #define YERFACE_MUTEX_TRIVIAL
 //// YERFACE_MUTEX_DEBUGGING enables extremely detailed mutex logging
 // #define YERFACE_MUTEX_DEBUGGING
+//// YERFACE_MUTEX_DEADLOCK_DETECTION makes contended locks poll (with backoff) and throw if a lock can't be acquired within YERFACE_MUTEX_DEADLOCK_TIMEOUT milliseconds.
+// #define YERFACE_MUTEX_DEADLOCK_DETECTION
+#define YERFACE_MUTEX_DEADLOCK_TIMEOUT 4000
+//// YERFACE_ALLOCATION_COUNTING replaces the global operator new, so steady-state hot paths can report any heap allocations they make.
+// #define YERFACE_ALLOCATION_COUNTING
 
 
 #ifdef WIN32
@@ -72,50 +80,46 @@ static constexpr cstr portableBasename(cstr str) {
 
 #define YerFace_MutexLock YerFace_MutexLock_Trivial
 #define YerFace_MutexUnlock YerFace_MutexUnlock_Trivial
+#define YerFace_CreateMutex() SDL_CreateMutex()
+#define YerFace_DestroyMutex(X) SDL_DestroyMutex(X)
+#define YerFace_CondWaitTimeout(C, X, MS) SDL_CondWaitTimeout(C, X, MS)
 
 #else // END Trivial mutex macros, BEGIN non-trivial mutex macros
 
 #define YerFace_MutexLock(X) do {														\
-	int _mutexStatus = SDL_MUTEX_TIMEDOUT;												\
-	uint64_t _mutexStart = std::chrono::duration_cast<std::chrono::milliseconds>		\
-		(std::chrono::steady_clock::now().time_since_epoch()).count();					\
 	YERFACE_MUTEX_DEBUGLOG("Utilities", LOG_SEVERITY_DEBUG4,							\
 		"Attempting lock on mutex %s (%p) ...", #X, X);									\
-	while(_mutexStatus == SDL_MUTEX_TIMEDOUT) {											\
-		_mutexStatus = SDL_TryLockMutex(X);												\
-		if(_mutexStatus == -1) {														\
-			YERFACE_MUTEX_DEBUGLOG("Utilities", LOG_SEVERITY_CRIT, "Failed to "			\
-				"lock mutex %s (%p). Error was: %s", #X, X, SDL_GetError());			\
-			throw runtime_error("Failed to lock mutex.");								\
-		} else if(_mutexStatus == SDL_MUTEX_TIMEDOUT) {									\
-			uint64_t _mutexEnd = std::chrono::duration_cast<std::chrono::milliseconds>	\
-				(std::chrono::steady_clock::now().time_since_epoch()).count();			\
-			YERFACE_MUTEX_DEBUGLOG("Utilities", LOG_SEVERITY_DEBUG4,					\
-				"Lock attempt on mutex %s (%p) timed out...", #X, X);					\
-			if(_mutexEnd - _mutexStart > 4000) {										\
-				YerFace_SLog("Utilities", LOG_SEVERITY_CRIT, "Lock attempt on mutex "	\
-					"%s (%p) timed out! No more retries...", #X, X);					\
-				throw runtime_error("Break glass! Mutex lock timed out; possible "		\
-					"deadlock. (This was probably caused by an earlier exception!!!)");	\
-			}																			\
-		}																				\
-	}																					\
+	InstrumentedMutex::lock(X, #X, YERFACE_FILE, __LINE__);								\
 	YERFACE_MUTEX_DEBUGLOG("Utilities", LOG_SEVERITY_DEBUG4,							\
 		"Successfully locked mutex %s (%p) ...", #X, X);								\
 } while(0)
 
 #define YerFace_MutexUnlock(X) do {														\
-	if(SDL_UnlockMutex(X) != 0) {														\
-		YerFace_SLog("Utilities", LOG_SEVERITY_CRIT, "Failed to unlock mutex "			\
-			"%s (%p). Error was: %s", #X, X, SDL_GetError());							\
-		throw runtime_error("Failed to unlock mutex.");									\
-	}																					\
+	InstrumentedMutex::unlock(X, #X);													\
 	YERFACE_MUTEX_DEBUGLOG("Utilities", LOG_SEVERITY_DEBUG4,							\
 		"Successfully unlocked mutex %s (%p) ...", #X, X);								\
 } while(0)
 
+//Mutexes are registered when they are created, so their statistics are keyed by a stable creation site rather than an address which may be reused.
+#define YerFace_CreateMutex() InstrumentedMutex::create(portableBasename(__FILE__), __LINE__)
+#define YerFace_DestroyMutex(X) InstrumentedMutex::destroy(X)
+#define YerFace_CondWaitTimeout(C, X, MS) InstrumentedMutex::condWaitTimeout(C, X, MS)
+
 #endif // End non-trivial mutex macros
 
+#ifdef YERFACE_ALLOCATION_COUNTING
+#define YerFace_AllocationCheckBegin(X) uint64_t X = AllocationCounter::getThreadAllocations()
+#define YerFace_AllocationCheckEnd(logger, X, label) do {								\
+	uint64_t allocations__ = AllocationCounter::getThreadAllocations() - X;				\
+	if(allocations__ > 0) {																\
+		logger->debug1("%s made %lu heap allocations!", label, (unsigned long)allocations__);	\
+	}																					\
+} while(0)
+#else
+#define YerFace_AllocationCheckBegin(X) do { } while(0)
+#define YerFace_AllocationCheckEnd(logger, X, label) do { } while(0)
+#endif
+
 #define YerFace_CarefullyDelete(logger, status, x) do {					\
 	try {																\
 		delete x;														\
@@ -133,6 +137,58 @@ static constexpr cstr portableBasename(cstr str) {
 	}																	\
 } while(0)
 
+#define YERFACE_MUTEX_STATISTICS_SLOTS 1024
+#define YERFACE_MUTEX_STATISTICS_SITES 256
+#define YERFACE_MUTEX_SLOT_RELEASED ((SDL_mutex *)(uintptr_t)1)
+
+//Contention statistics for every mutex created at one place in the source. Sites are never released.
+class MutexStatistics {
+public:
+	const char *file; //Key, along with line.
+	int line;
+	std::atomic<const char *> name; //As spelled by the first YerFace_MutexLock() on any of this site's mutexes.
+	std::atomic<uint64_t> instances, acquisitions, contendedAcquisitions;
+	std::atomic<uint64_t> waitNanoseconds, holdNanoseconds, worstWaitNanoseconds;
+};
+
+//Bookkeeping for one live mutex. Claimed by YerFace_CreateMutex() and released by YerFace_DestroyMutex().
+class MutexInstance {
+public:
+	std::atomic<SDL_mutex *> mutex; //Key. NULL if the slot has never been used, or YERFACE_MUTEX_SLOT_RELEASED after its mutex was destroyed.
+	MutexStatistics *statistics;
+	SDL_threadID owner; //Only touched by the thread holding the mutex.
+	int depth; //Only touched by the thread holding the mutex.
+	uint64_t lockedAtNanoseconds; //Only touched by the thread holding the mutex.
+};
+
+//InstrumentedMutex implements YerFace_CreateMutex / YerFace_DestroyMutex / YerFace_MutexLock / YerFace_MutexUnlock / YerFace_CondWaitTimeout.
+//Locks block (rather than spinning) and per-site contention statistics are recorded, so they can be reported at shutdown via logReport().
+class InstrumentedMutex {
+public:
+	static SDL_mutex *create(const char *file, int line);
+	static void destroy(SDL_mutex *mutex);
+	static void lock(SDL_mutex *mutex, const char *name, const char *file, int line);
+	static void unlock(SDL_mutex *mutex, const char *name);
+	static int condWaitTimeout(SDL_cond *cond, SDL_mutex *mutex, Uint32 milliseconds);
+	static void logReport(void);
+private:
+	static SDL_mutex *getRegistryMutex(void);
+	static MutexInstance *findInstance(SDL_mutex *mutex);
+	static size_t hashSlot(SDL_mutex *mutex);
+	static uint64_t nowNanoseconds(void);
+
+	static MutexInstance instances[YERFACE_MUTEX_STATISTICS_SLOTS];
+	static MutexStatistics sites[YERFACE_MUTEX_STATISTICS_SITES];
+	static size_t sitesUsed;
+	static bool overflowLogged;
+};
+
+//Counts heap allocations made through the global operator new, per thread. Always reads zero unless YERFACE_ALLOCATION_COUNTING is defined.
+class AllocationCounter {
+public:
+	static uint64_t getThreadAllocations(void);
+};
+
 class TimeIntervalComparison {
 public:
 	bool doesAEndBeforeB;
@@ -142,6 +198,56 @@ public:
 	bool doesAStartAfterB;
 };
 
+//Loudness summary of a window of audio. Windows can be combined with accumulate(), so per-packet envelopes can be rolled up into
+//per-video-frame envelopes without revisiting any samples.
+class AudioEnvelope {
+public:
+	AudioEnvelope(void);
+	void accumulate(const AudioEnvelope &other);
+	double getRMS(void) const;
+
+	double peak; //Largest absolute sample, where 1.0 is full scale.
+	bool clipped; //True if any sample hit full scale.
+	double sumOfSquares; //Normalized to full scale, and kept as a sum so windows can be combined before taking the RMS.
+	int samples;
+};
+
+//MappedFileBuffer maps a file read-only into memory and exposes it as a stream buffer, so large model files can be
+//deserialized without copying them through an intermediate read buffer.
+class MappedFileBuffer : public std::streambuf {
+public:
+	MappedFileBuffer(string filePath);
+	~MappedFileBuffer() noexcept(false);
+	size_t getSize(void);
+private:
+	char *data;
+	size_t size;
+	#ifdef WIN32
+	void *fileHandle, *mappingHandle;
+	#endif
+};
+
+//ChildProcessPipe runs a shell command as a child process with its STDIN and STDOUT connected to us, so we can
+//exchange lines of text with it for as long as it lives. The child's STDERR is shared with ours.
+class ChildProcessPipe {
+public:
+	ChildProcessPipe(string command);
+	~ChildProcessPipe() noexcept(false);
+	bool writeLine(string line);
+	bool readLine(string *line);
+	void closeInput(void);
+	int wait(void);
+private:
+	FILE *childInput, *childOutput;
+	bool exited;
+	int exitCode;
+	#ifdef WIN32
+	void *processHandle;
+	#else
+	int processID;
+	#endif
+};
+
 class Logger;
 
 class Utilities {
@@ -154,6 +260,7 @@ public:
 	static double morph(double a, double b, double progress);
 	static double lineDistance(cv::Point2d a, cv::Point2d b);
 	static double lineDistance(cv::Point3d a, cv::Point3d b);
+	static AudioEnvelope calculateAudioEnvelope(const int16_t *samples, int count, bool vectorized = true); //Pass vectorized=false to force the scalar reference loop.
 	static TimeIntervalComparison timeIntervalCompare(double startTimeA, double endTimeA, double startTimeB, double endTimeB);
 	static double degreesToRadians(double degrees);
 	static double radiansToDegrees(double radians, bool normalize = true);
@@ -177,6 +284,7 @@ public:
 	static string stringTrim(std::string str);
 	static string stringTrimLeft(std::string str);
 	static string stringTrimRight(std::string str);
+	static string shellQuoteArgument(string argument);
 
 private:
 	static Logger *logger;
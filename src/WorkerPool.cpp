@@ -7,6 +7,236 @@ using namespace cv;
 
 namespace YerFace {
 
+bool WorkerPoolExecutor::initialized = false;
+int WorkerPoolExecutor::maxConcurrentWorkers = 0;
+int WorkerPoolExecutor::runningWorkers = 0;
+int WorkerPoolExecutor::priorityAgingMilliseconds = 0;
+json WorkerPoolExecutor::stagesConfig = json::object();
+std::vector<WorkerPoolExecutorStage *> WorkerPoolExecutor::stages;
+Logger *WorkerPoolExecutor::logger = NULL;
+SDL_mutex *WorkerPoolExecutor::staticMutex = YerFace_CreateMutex();
+
+void WorkerPoolExecutor::initialize(json config) {
+	YerFace_MutexLock(staticMutex);
+	if(initialized) {
+		YerFace_MutexUnlock(staticMutex);
+		throw logic_error("WorkerPoolExecutor was already initialized!");
+	}
+	if(logger == NULL) {
+		logger = new Logger("WorkerPoolExecutor");
+	}
+	bool enabled = config["YerFace"]["WorkerPoolExecutor"]["enabled"];
+	if(!enabled) {
+		logger->debug1("WorkerPoolExecutor is disabled. Worker pools will not share a CPU budget.");
+		YerFace_MutexUnlock(staticMutex);
+		return;
+	}
+	maxConcurrentWorkers = config["YerFace"]["WorkerPoolExecutor"]["maxConcurrentWorkers"];
+	if(maxConcurrentWorkers < 0) {
+		YerFace_MutexUnlock(staticMutex);
+		throw invalid_argument("WorkerPoolExecutor maxConcurrentWorkers cannot be less than zero.");
+	}
+	if(maxConcurrentWorkers == 0) {
+		maxConcurrentWorkers = SDL_GetCPUCount();
+	}
+	//A budget of one could deadlock a worker waiting on another stage's progress.
+	if(maxConcurrentWorkers < 2) {
+		maxConcurrentWorkers = 2;
+	}
+	priorityAgingMilliseconds = config["YerFace"]["WorkerPoolExecutor"]["priorityAgingMilliseconds"];
+	if(priorityAgingMilliseconds < 0) {
+		YerFace_MutexUnlock(staticMutex);
+		throw invalid_argument("WorkerPoolExecutor priorityAgingMilliseconds cannot be less than zero.");
+	}
+	stagesConfig = config["YerFace"]["WorkerPoolExecutor"]["stages"];
+	if(stagesConfig.find("default") == stagesConfig.end()) {
+		YerFace_MutexUnlock(staticMutex);
+		throw invalid_argument("WorkerPoolExecutor stages must include a default entry.");
+	}
+	runningWorkers = 0;
+	initialized = true;
+	logger->debug1("WorkerPoolExecutor initialized with a budget of %d concurrent workers.", maxConcurrentWorkers);
+	YerFace_MutexUnlock(staticMutex);
+}
+
+void WorkerPoolExecutor::shutdown(void) {
+	YerFace_MutexLock(staticMutex);
+	for(WorkerPoolExecutorStage *stage : stages) {
+		if(stage->running > 0 || stage->waiting > 0) {
+			logger->err("Stage %s still has %d running and %d waiting workers at shutdown!", stage->name.c_str(), stage->running, stage->waiting);
+		}
+		SDL_DestroyCond(stage->cond);
+		delete stage;
+	}
+	stages.clear();
+	initialized = false;
+	if(logger != NULL) {
+		delete logger;
+		logger = NULL;
+	}
+	YerFace_MutexUnlock(staticMutex);
+}
+
+WorkerPoolExecutorStage *WorkerPoolExecutor::registerStage(string name) {
+	YerFace_MutexLock(staticMutex);
+	if(!initialized) {
+		YerFace_MutexUnlock(staticMutex);
+		return NULL;
+	}
+	for(WorkerPoolExecutorStage *stage : stages) {
+		if(stage->name == name) {
+			YerFace_MutexUnlock(staticMutex);
+			return stage;
+		}
+	}
+	json stageConfig = stagesConfig["default"];
+	if(stagesConfig.find(name) != stagesConfig.end()) {
+		stageConfig = stagesConfig[name];
+	}
+	WorkerPoolExecutorStage *stage = new WorkerPoolExecutorStage();
+	stage->name = name;
+	stage->priority = stageConfig.value("priority", (int)stagesConfig["default"]["priority"]);
+	stage->maxConcurrentWorkers = stageConfig.value("maxConcurrentWorkers", 0);
+	stage->exempt = stageConfig.value("exempt", false);
+	stage->running = 0;
+	stage->waiting = 0;
+	stage->waitingSince = 0;
+	if(stage->maxConcurrentWorkers < 0) {
+		delete stage;
+		YerFace_MutexUnlock(staticMutex);
+		throw invalid_argument("WorkerPoolExecutor stage maxConcurrentWorkers cannot be less than zero.");
+	}
+	if((stage->cond = SDL_CreateCond()) == NULL) {
+		delete stage;
+		YerFace_MutexUnlock(staticMutex);
+		throw runtime_error("Failed creating condition!");
+	}
+	stages.push_back(stage);
+	logger->debug1("Registered stage %s with priority %d, maxConcurrentWorkers %d%s.", stage->name.c_str(), stage->priority, stage->maxConcurrentWorkers, stage->exempt ? " (EXEMPT)" : "");
+	YerFace_MutexUnlock(staticMutex);
+	return stage;
+}
+
+bool WorkerPoolExecutor::canRun(WorkerPoolExecutorStage *stage) {
+	if(!initialized) {
+		return true;
+	}
+	if(stage->maxConcurrentWorkers > 0 && stage->running >= stage->maxConcurrentWorkers) {
+		return false;
+	}
+	if(runningWorkers >= maxConcurrentWorkers) {
+		return false;
+	}
+	//Yield to any higher priority stage which is waiting and eligible to run.
+	Uint32 now = SDL_GetTicks();
+	int myPriority = effectivePriority(stage, now);
+	for(WorkerPoolExecutorStage *other : stages) {
+		if(other->waiting > 0 && effectivePriority(other, now) > myPriority) {
+			if(other->maxConcurrentWorkers == 0 || other->running < other->maxConcurrentWorkers) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+int WorkerPoolExecutor::effectivePriority(WorkerPoolExecutorStage *stage, Uint32 now) {
+	//NOTE: Must be called while holding staticMutex.
+	//A waiting stage gains a point of priority for every priorityAgingMilliseconds it has waited, so a steady stream of
+	//higher priority work can delay a lower priority stage, but never starve it.
+	if(stage->waiting < 1 || priorityAgingMilliseconds < 1) {
+		return stage->priority;
+	}
+	return stage->priority + (int)((now - stage->waitingSince) / (Uint32)priorityAgingMilliseconds);
+}
+
+void WorkerPoolExecutor::wakeNextStage(void) {
+	//NOTE: Must be called while holding staticMutex.
+	//Only one slot frees up at a time, so only one waiter (from the stage which would get the slot) needs waking.
+	WorkerPoolExecutorStage *next = NULL;
+	int nextPriority = 0;
+	Uint32 now = SDL_GetTicks();
+	for(WorkerPoolExecutorStage *stage : stages) {
+		if(stage->waiting < 1) {
+			continue;
+		}
+		int priority = effectivePriority(stage, now);
+		if((next == NULL || priority > nextPriority) && canRun(stage)) {
+			next = stage;
+			nextPriority = priority;
+		}
+	}
+	if(next != NULL) {
+		SDL_CondSignal(next->cond);
+	}
+}
+
+void WorkerPoolExecutor::acquireSlot(WorkerPoolExecutorStage *stage) {
+	if(stage == NULL || stage->exempt) {
+		return;
+	}
+	YerFace_MutexLock(staticMutex);
+	if(stage->waiting == 0) {
+		stage->waitingSince = SDL_GetTicks();
+	}
+	stage->waiting++;
+	while(!canRun(stage)) {
+		if(YerFace_CondWaitTimeout(stage->cond, staticMutex, 100) < 0) {
+			stage->waiting--;
+			YerFace_MutexUnlock(staticMutex);
+			throw runtime_error("CondWaitTimeout() failed!");
+		}
+	}
+	stage->waiting--;
+	stage->running++;
+	runningWorkers++;
+	//This stage was just served, so anybody else from it who is still waiting starts aging over again.
+	stage->waitingSince = SDL_GetTicks();
+	//With this stage no longer waiting, a lower priority stage may have become eligible for a remaining slot.
+	wakeNextStage();
+	YerFace_MutexUnlock(staticMutex);
+}
+
+int WorkerPoolExecutor::capWorkers(WorkerPoolExecutorStage *stage, int numWorkers) {
+	//There's no sense starting more threads than could ever hold executor slots at the same time.
+	if(stage == NULL || stage->exempt) {
+		return numWorkers;
+	}
+	YerFace_MutexLock(staticMutex);
+	int cap = maxConcurrentWorkers;
+	if(stage->maxConcurrentWorkers > 0 && stage->maxConcurrentWorkers < cap) {
+		cap = stage->maxConcurrentWorkers;
+	}
+	YerFace_MutexUnlock(staticMutex);
+	return std::min(numWorkers, cap);
+}
+
+bool WorkerPoolExecutor::tryAcquireSlot(WorkerPoolExecutorStage *stage) {
+	if(stage == NULL || stage->exempt) {
+		return true;
+	}
+	bool acquired = false;
+	YerFace_MutexLock(staticMutex);
+	if(canRun(stage)) {
+		stage->running++;
+		runningWorkers++;
+		acquired = true;
+	}
+	YerFace_MutexUnlock(staticMutex);
+	return acquired;
+}
+
+void WorkerPoolExecutor::releaseSlot(WorkerPoolExecutorStage *stage) {
+	if(stage == NULL || stage->exempt) {
+		return;
+	}
+	YerFace_MutexLock(staticMutex);
+	stage->running--;
+	runningWorkers--;
+	wakeNextStage();
+	YerFace_MutexUnlock(staticMutex);
+}
+
 WorkerPool::WorkerPool(json config, Status *myStatus, FrameServer *myFrameServer, WorkerPoolParameters myParameters) {
 	status = myStatus;
 	if(status == NULL) {
@@ -20,7 +250,7 @@ WorkerPool::WorkerPool(json config, Status *myStatus, FrameServer *myFrameServer
 
 	string loggerName = "WorkerPool<" + parameters.name + ">";
 	logger = new Logger(loggerName.c_str());
-	if((myMutex = SDL_CreateMutex()) == NULL) {
+	if((myMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
 	if((myCond = SDL_CreateCond()) == NULL) {
@@ -35,6 +265,10 @@ WorkerPool::WorkerPool(json config, Status *myStatus, FrameServer *myFrameServer
 	}
 
 	running = true;
+	executorStage = WorkerPoolExecutor::registerStage(parameters.name);
+	pendingTasks = 0;
+	idleWorkers = 0;
+	nextTaskWorker = 0;
 
 	//Hook into the frame lifecycle.
 
@@ -56,15 +290,27 @@ WorkerPool::WorkerPool(json config, Status *myStatus, FrameServer *myFrameServer
 	if(parameters.numWorkers < 1) {
 		throw invalid_argument("NumWorkers can't be zero!");
 	}
+	int cappedNumWorkers = WorkerPoolExecutor::capWorkers(executorStage, parameters.numWorkers);
+	if(cappedNumWorkers < parameters.numWorkers) {
+		logger->debug1("Capping NumWorkers from %d to %d, since no more than that could ever run at once under the WorkerPoolExecutor budget.", parameters.numWorkers, cappedNumWorkers);
+		parameters.numWorkers = cappedNumWorkers;
+	}
+	//All of the workers must exist before any of them start, since any worker may try to steal from any other.
 	for(int i = 1; i <= parameters.numWorkers; i++) {
 		WorkerPoolWorker *worker = new WorkerPoolWorker();
 		worker->num = i;
+		worker->thread = NULL;
 		worker->ptr = parameters.usrPtr;
 		worker->pool = this;
+		if((worker->tasksMutex = YerFace_CreateMutex()) == NULL) {
+			throw runtime_error("Failed creating mutex!");
+		}
+		workers.push_back(worker);
+	}
+	for(auto worker : workers) {
 		if((worker->thread = SDL_CreateThread(outerWorkerLoop, parameters.name.c_str(), (void *)worker)) == NULL) {
 			throw runtime_error("Failed starting thread!");
 		}
-		workers.push_back(worker);
 	}
 
 	logger->debug1("WorkerPool object constructed with NumWorkers: %d", parameters.numWorkers);
@@ -83,11 +329,19 @@ WorkerPool::~WorkerPool() noexcept(false) {
 
 	for(auto worker : workers) {
 		SDL_WaitThread(worker->thread, NULL);
+	}
+
+	if(pendingTasks > 0) {
+		logger->err("There are still %d submitted tasks pending! Woe is me!", (int)pendingTasks);
+	}
+
+	for(auto worker : workers) {
+		YerFace_DestroyMutex(worker->tasksMutex);
 		delete worker;
 	}
 
 	SDL_DestroyCond(myCond);
-	SDL_DestroyMutex(myMutex);
+	YerFace_DestroyMutex(myMutex);
 	delete logger;
 }
 
@@ -97,6 +351,61 @@ void WorkerPool::sendWorkerSignal(void) {
 	YerFace_MutexUnlock(myMutex);
 }
 
+void WorkerPool::submitTask(WorkerPoolTask task) {
+	if(task == NULL) {
+		throw invalid_argument("task cannot be NULL");
+	}
+	WorkerPoolWorker *worker = workers[nextTaskWorker++ % workers.size()];
+	YerFace_MutexLock(worker->tasksMutex);
+	worker->tasks.push_back(task);
+	YerFace_MutexUnlock(worker->tasksMutex);
+
+	//NOTE: pendingTasks must be incremented BEFORE idleWorkers is checked. (The worker loop does the opposite.) This way a worker can never go to sleep on a task we did not signal for.
+	pendingTasks++;
+	if(idleWorkers > 0) {
+		sendWorkerSignal();
+	}
+}
+
+bool WorkerPool::runNextTask(WorkerPoolWorker *worker) {
+	if(pendingTasks <= 0) {
+		return false;
+	}
+
+	bool taskSet = false;
+	WorkerPoolTask task;
+
+	//Prefer our own deque, oldest task first.
+	YerFace_MutexLock(worker->tasksMutex);
+	if(worker->tasks.size() > 0) {
+		task = worker->tasks.front();
+		worker->tasks.pop_front();
+		taskSet = true;
+	}
+	YerFace_MutexUnlock(worker->tasksMutex);
+
+	//Otherwise, try to steal from somebody else.
+	size_t numWorkers = workers.size();
+	for(size_t i = 1; !taskSet && i < numWorkers; i++) {
+		WorkerPoolWorker *victim = workers[(worker->num - 1 + i) % numWorkers];
+		YerFace_MutexLock(victim->tasksMutex);
+		if(victim->tasks.size() > 0) {
+			task = victim->tasks.back();
+			victim->tasks.pop_back();
+			taskSet = true;
+			logger->debug4("Thread #%d stole a task from Thread #%d.", worker->num, victim->num);
+		}
+		YerFace_MutexUnlock(victim->tasksMutex);
+	}
+
+	if(!taskSet) {
+		return false;
+	}
+	pendingTasks--;
+	task(worker);
+	return true;
+}
+
 void WorkerPool::stopWorkerNow(void) {
 	YerFace_MutexLock(myMutex);
 	running = false;
@@ -127,34 +436,62 @@ int WorkerPool::outerWorkerLoop(void *ptr) {
 			self->parameters.initializer(worker, self->parameters.usrPtr);
 		}
 
+		//Polling a handler which turns out to have nothing to do shouldn't cost (or queue for) an executor slot.
+		//Workers only queue for a slot when they have reason to expect work: pending tasks, a wake-up signal, or a handler which just did work.
+		bool expectWork = true;
+		bool slotRefused = false;
 		YerFace_MutexLock(self->myMutex);
 		while(!self->frameServerDrained && self->running) {
 			// self->logger->debug4("Thread #%d Top of Loop", worker->num);
 
 			if(self->status->getIsPaused() && self->status->getIsRunning()) {
-				YerFace_MutexUnlock(self->myMutex);
-				SDL_Delay(100);
-				YerFace_MutexLock(self->myMutex);
+				if(YerFace_CondWaitTimeout(self->myCond, self->myMutex, 100) < 0) {
+					throw runtime_error("CondWaitTimeout() failed!");
+				}
 				continue;
 			}
 
 			YerFace_MutexUnlock(self->myMutex);
-			bool didWork = self->parameters.handler(worker);
+			bool didWork = false;
+			if(expectWork || self->pendingTasks > 0) {
+				WorkerPoolExecutor::acquireSlot(self->executorStage);
+				slotRefused = false;
+			} else {
+				slotRefused = !WorkerPoolExecutor::tryAcquireSlot(self->executorStage);
+			}
+			if(!slotRefused) {
+				try {
+					didWork = self->runNextTask(worker);
+					if(self->parameters.handler != NULL) {
+						didWork = self->parameters.handler(worker) || didWork;
+					}
+				} catch(exception &e) {
+					WorkerPoolExecutor::releaseSlot(self->executorStage);
+					throw;
+				}
+				WorkerPoolExecutor::releaseSlot(self->executorStage);
+			}
+			expectWork = didWork;
 			YerFace_MutexLock(self->myMutex);
 
 			//If there is no work available, go to sleep and wait.
-			if(!didWork) {
+			self->idleWorkers++;
+			if(!didWork && self->pendingTasks <= 0) {
 				// self->logger->verbose("Thread #%d entering CondWait...", worker->num);
-				int result = SDL_CondWaitTimeout(self->myCond, self->myMutex, 1000);
+				//A refused poll comes back around sooner, since nobody will signal us when the executor frees up.
+				int result = YerFace_CondWaitTimeout(self->myCond, self->myMutex, slotRefused ? 100 : 1000);
 				if(result < 0) {
 					throw runtime_error("CondWaitTimeout() failed!");
 				} else if(result == SDL_MUTEX_TIMEDOUT) {
-					if(!self->status->getIsPaused() && !self->frameServerDrained) {
+					if(!slotRefused && !self->status->getIsPaused() && !self->frameServerDrained) {
 						self->logger->warning("Thread #%d timed out waiting for Condition signal!", worker->num);
 					}
+				} else {
+					expectWork = true;
 				}
 				// self->logger->verbose("Thread #%d left CondWait!", worker->num);
 			}
+			self->idleWorkers--;
 			if(self->status->getEmergency()) {
 				self->logger->debug1("Thread #%d honoring emergency stop.", worker->num);
 				self->running = false;
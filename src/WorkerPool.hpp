@@ -7,11 +7,18 @@
 
 #include "SDL.h"
 
+#include <deque>
+#include <atomic>
+
 using namespace std;
 
 namespace YerFace {
 
 class WorkerPool;
+class WorkerPoolWorker;
+
+//A unit of work submitted via WorkerPool::submitTask(). Any task-specific data should be captured by the function object.
+typedef function<void(WorkerPoolWorker *worker)> WorkerPoolTask;
 
 class WorkerPoolWorker {
 public:
@@ -19,6 +26,9 @@ public:
 	SDL_Thread *thread;
 	void *ptr;
 	WorkerPool *pool;
+
+	SDL_mutex *tasksMutex;
+	std::deque<WorkerPoolTask> tasks; //Owner pops from the front, thieves steal from the back.
 };
 
 typedef function<void(WorkerPoolWorker *worker, void *ptr)> WorkerPoolWorkerInitializer;
@@ -35,7 +45,47 @@ public:
 	WorkerPoolWorkerDeinitializer deinitializer;
 	void *usrPtr;
 
-	WorkerPoolWorkerHandler handler;
+	WorkerPoolWorkerHandler handler; //Optional if all work will be pushed via WorkerPool::submitTask().
+};
+
+class WorkerPoolExecutorStage {
+public:
+	string name;
+	int priority; //When the executor is saturated, waiting stages with higher priority run first.
+	int maxConcurrentWorkers; //Zero means no per-stage cap.
+	bool exempt; //Exempt stages never wait on the executor. (For stages which block on I/O by design.)
+	int running, waiting; //Only workers which expect to have work count as waiting.
+	Uint32 waitingSince; //When this stage last started waiting, or was last given a slot while others kept waiting. (SDL ticks.)
+	SDL_cond *cond; //Waiting workers of this stage sleep here, so a freed slot can wake exactly one of them.
+};
+
+//WorkerPoolExecutor is a process-wide admission controller shared by every WorkerPool.
+//Each pool still owns its threads (since workers carry per-thread state like loaded models),
+//but a worker must hold an executor slot while it is actually doing work. This keeps the
+//number of busy threads at or below the configured budget and lets upstream stages win.
+//Idle polls only take a slot if one is free right now, and never queue for one.
+class WorkerPoolExecutor {
+public:
+	static void initialize(json config);
+	static void shutdown(void);
+	static WorkerPoolExecutorStage *registerStage(string name);
+	static void acquireSlot(WorkerPoolExecutorStage *stage);
+	static bool tryAcquireSlot(WorkerPoolExecutorStage *stage);
+	static void releaseSlot(WorkerPoolExecutorStage *stage);
+	static int capWorkers(WorkerPoolExecutorStage *stage, int numWorkers);
+private:
+	static bool canRun(WorkerPoolExecutorStage *stage);
+	static int effectivePriority(WorkerPoolExecutorStage *stage, Uint32 now);
+	static void wakeNextStage(void);
+
+	static bool initialized;
+	static int maxConcurrentWorkers;
+	static int runningWorkers;
+	static int priorityAgingMilliseconds;
+	static json stagesConfig;
+	static std::vector<WorkerPoolExecutorStage *> stages;
+	static Logger *logger;
+	static SDL_mutex *staticMutex;
 };
 
 class WorkerPool {
@@ -44,7 +94,9 @@ public:
 	~WorkerPool() noexcept(false);
 	void sendWorkerSignal(void);
 	void stopWorkerNow(void);
+	void submitTask(WorkerPoolTask task);
 private:
+	bool runNextTask(WorkerPoolWorker *worker);
 	static void handleFrameServerDrainedEvent(void *userdata);
 	static int outerWorkerLoop(void *ptr);
 
@@ -52,6 +104,7 @@ private:
 	FrameServer *frameServer;
 
 	WorkerPoolParameters parameters;
+	WorkerPoolExecutorStage *executorStage;
 
 	Logger *logger;
 	SDL_mutex *myMutex;
@@ -59,7 +112,10 @@ private:
 
 	bool frameServerDrained, running;
 
-	std::list<WorkerPoolWorker *> workers;
+	std::vector<WorkerPoolWorker *> workers;
+
+	std::atomic<int> pendingTasks, idleWorkers;
+	std::atomic<unsigned int> nextTaskWorker;
 };
 
 }; //namespace YerFace
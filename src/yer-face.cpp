@@ -14,11 +14,15 @@
 #include "EventLogger.hpp"
 #include "PreviewHUD.hpp"
 #include "WorkerPool.hpp"
+#include "ChunkedProcessor.hpp"
+#include "BatchProcessor.hpp"
+#include "OutputFrameFormat.hpp"
 
 #include <iostream>
 #include <sstream>
 #include <cstdio>
 #include <cstdlib>
+#include <algorithm>
 
 using namespace std;
 using namespace cv;
@@ -31,6 +35,9 @@ string inVideoFormat;
 string inVideoSize;
 string inVideoRate;
 string inVideoCodec;
+string decoderThreadCountString;
+int decoderThreadCount = 0;
+string decoderThreadType;
 
 string inAudio;
 string inAudioFormat;
@@ -57,6 +64,21 @@ bool previewAudio = false;
 bool tryAudioInVideo = false;
 bool openInputAudio = false;
 bool stdinPipeUsed = false;
+bool audioOnly = false;
+double audioOnlyFrameRate = 30.0;
+
+string batchManifest;
+bool batchWorker = false;
+string convertEventData;
+string outEventDataFormat;
+int maxConcurrentWorkers = -1;
+bool childProcess = false;
+int parallelChunks = 0;
+int chunkIndex = -1;
+double chunkStartTime = -1.0;
+double chunkEndTime = -1.0;
+double inputStartTime = 0.0;
+double inputEndTime = -1.0;
 
 int verbosity = 0, logSeverityFilter = LOG_SEVERITY_FILTERDEFAULT;
 
@@ -65,12 +87,14 @@ json config = NULL;
 SDLWindowRenderer sdlWindowRenderer;
 bool windowInitializationFailed;
 WorkerPool *videoCaptureWorkerPool;
+bool videoCaptureSetFrameSize; //Only touched by the video capture worker.
 
 Status *status = NULL;
 Logger *logger = NULL;
 SDLDriver *sdlDriver = NULL;
 FFmpegDriver *ffmpegDriver = NULL;
 FrameServer *frameServer = NULL;
+FrameStatusCheckpoint previewDisplayedCheckpoint;
 FaceDetector *faceDetector = NULL;
 FaceTracker *faceTracker = NULL;
 FaceMapper *faceMapper = NULL;
@@ -108,17 +132,25 @@ void videoCaptureInitializer(WorkerPoolWorker *worker, void *ptr);
 bool videoCaptureHandler(WorkerPoolWorker *worker);
 void videoCaptureDeinitializer(WorkerPoolWorker *worker, void *ptr);
 void parseConfigFile(void);
+int runParallelChunks(int argc, char *argv[]);
+int runBatchManifest(int argc, char *argv[]);
+int runBatchWorker(void);
+void releaseCachedModels(void);
+int runConvertEventData(void);
+std::vector<string> filterChildArguments(int argc, char *argv[], std::vector<string> reservedArguments);
 void handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps);
 void handleFrameServerDrainedEvent(void *userdata);
 void renderPreviewHUD(Mat previewFrame, FrameNumber frameNumber, int density, bool mirrorMode);
 
 int main(int argc, char *argv[]) {
+	int result = 1;
 	try {
-		return yerface(argc, argv);
+		result = yerface(argc, argv);
+		releaseCachedModels();
 	} catch(exception &e) {
 		Logger::slog("Main", LOG_SEVERITY_CRIT, "Uncaught exception in parent thread: %s", e.what());
 	}
-	return 1;
+	return result;
 }
 
 int yerface(int argc, char *argv[]) {
@@ -128,10 +160,14 @@ int yerface(int argc, char *argv[]) {
 		"{configFile||Required configuration file. (Indicate the full or relative path to your 'yer-face-config.json' file. Omit to search common locations.)}"
 		"{lowLatency||If true, will tweak behavior across the system to minimize latency. (Don't use this if the input is pre-recorded!)}"
 		"{inVideo||Video file, URL, or device to open. (Or '-' for STDIN.)}"
+		"{audioOnly||If true, video is never decoded and faces are not tracked. Frames are synthesized from the audio timeline at audioOnlyFrameRate, and carry only phonemes and events. The audio comes from inAudio, or from inVideo if inAudio is blank.}"
+		"{audioOnlyFrameRate|30.0|Frame rate of the synthesized frames in audioOnly mode.}"
 		"{inVideoFormat||Tell libav to use a specific format to interpret the inVideo. Leave blank for auto-detection.}"
 		"{inVideoSize||Tell libav to attempt a specific resolution when interpreting inVideo. Leave blank for auto-detection.}"
 		"{inVideoRate||Tell libav to attempt a specific framerate when interpreting inVideo. Leave blank for auto-detection.}"
 		"{inVideoCodec||Tell libav to attempt a specific codec when interpreting inVideo. Leave blank for auto-detection.}"
+		"{decoderThreadCount||Number of threads libav should use for each decoder. Zero lets libav decide based on the number of CPUs. Leave blank to use the configuration file setting.}"
+		"{decoderThreadType||Decoder threading strategy. One of \"frame\", \"slice\", \"frame+slice\", or \"auto\" (slice threading only in lowLatency mode, otherwise both). Leave blank to use the configuration file setting.}"
 		"{inAudio||Audio file, URL, or device to open. Alternatively: '' (blank string, the default) we will try to read the audio from inVideo. '-' we will try to read the audio from STDIN. 'ignore' we will ignore all audio from all sources.}"
 		"{inAudioFormat||Tell libav to use a specific format to interpret the inAudio. Leave blank for auto-detection.}"
 		"{inAudioChannels||Tell libav to attempt a specific number of channels when interpreting inAudio. Leave blank for auto-detection.}"
@@ -139,14 +175,26 @@ int yerface(int argc, char *argv[]) {
 		"{inAudioCodec||Tell libav to attempt a specific codec when interpreting inAudio. Leave blank for auto-detection.}"
 		"{inAudioChannelMap||Alter the input audio channel mapping. Set to \"left\" to interpret only the left channel, \"right\" to interpret only the right channel, and leave blank for the default.}"
 		"{inEventData||Input event data / replay file. (Previously generated outEventData, for re-processing recorded sessions.)}"
+		"{startTime|0.0|Seconds into the input to start processing. We seek to the nearest keyframe before this time, and frames before it are discarded. (Offline mode only.)}"
+		"{endTime|-1.0|Seconds into the input to stop processing. (Negative means the end of the input. Offline mode only.)}"
 		"{inEventDataStartSeconds|0.0|Offset for input event data / replay file timestamps. (Useful if the capture session was trimmed.)}"
 		"{outEventData||Output event data / replay file. (Includes performance capture data.)}"
+		"{outEventDataFormat||Format of the outEventData file. One of \"json\" or \"binary\". Leave blank to use the configuration file setting.}"
+		"{convertEventData||Binary (or JSON) event data file to convert to JSON. The result is written to outEventData, and then we exit.}"
 		"{outVideo||Output file for captured video and audio. Together with the \"outEventData\" file, this can be used to re-run a previous capture session.}"
 		"{outLogFile||If specified, log messages will be written to this file. If \"-\" or not specified, log messages will be written to STDERR.}"
 		"{outLogColors||If true, log colorization will be forced on. If false, log colorization will be forced off. If \"auto\" or not specified, log colorization will auto-detect.}"
 		"{previewAudio||If true, will preview processed audio out the computer's sound device.}"
 		"{previewMirror||If true, mirror mode (horizontal reflection) of the preview will be forced on. If false, mirror mode will be forced off. If \"auto\" or not specified, mirror mode will be enabled for lowLatency mode and disabled otherwise.}"
 		"{headless||If set, all video display and audio playback is disabled. Intended to be suitable for jobs running in the terminal.}"
+		"{maxConcurrentWorkers|-1|If zero or greater, overrides the WorkerPoolExecutor maxConcurrentWorkers setting from the configuration file. (Zero means one per CPU.)}"
+		"{childProcess||Used internally by parallelChunks and batchManifest. Indicates this process is one of several sibling processes sharing the machine.}"
+		"{batchManifest||JSON file listing many jobs to run, several at a time, in headless batch worker processes. Each job is an object of command line arguments, and must include at least inVideo and outEventData. Other arguments given alongside batchManifest are passed to every job.}"
+		"{batchWorker||Used internally by batchManifest. Reads jobs from STDIN, one per line, and runs them one after another in this process, so that models are only loaded once.}"
+		"{parallelChunks|0|If greater than one, split the inVideo file into this many keyframe-aligned chunks and process them in parallel child processes, then stitch the outEventData back together. (Offline mode only.)}"
+		"{chunkIndex|-1|Used internally by parallelChunks. Zero-based index of the chunk this process is handling.}"
+		"{chunkStartTime|-1.0|Used internally by parallelChunks. Start of the output time range for this chunk, in seconds.}"
+		"{chunkEndTime|-1.0|Used internally by parallelChunks. End of the output time range for this chunk, in seconds. (Negative means the end of the input.)}"
 		"{version||Emit the version string to STDOUT and exit.}"
 		"{verbosity verbose v||Adjust the log level filter. Indicate a positive number to increase the verbosity, a negative number to decrease the verbosity, or specify with no integer to increase the verbosity to a moderate degree.)}"
 		);
@@ -179,10 +227,16 @@ int yerface(int argc, char *argv[]) {
 		Logger::setLoggingFilter((LogMessageSeverity)logSeverityFilter);
 	}
 	configFile = parser.get<string>("configFile");
+	batchManifest = parser.get<string>("batchManifest");
+	batchWorker = parser.has("batchWorker") && parser.get<bool>("batchWorker");
+	convertEventData = parser.get<string>("convertEventData");
 	inVideo = parser.get<string>("inVideo");
-	if(inVideo.length() == 0) {
+	audioOnly = parser.has("audioOnly") && parser.get<bool>("audioOnly");
+	audioOnlyFrameRate = parser.get<double>("audioOnlyFrameRate");
+	if(inVideo.length() == 0 && batchManifest.length() == 0 && !batchWorker && convertEventData.length() == 0 && !(audioOnly && parser.get<string>("inAudio").length() > 0)) {
 		throw invalid_argument("--inVideo is a required argument, but is blank or not specified!");
 	}
+	stdinPipeUsed = false;
 	if(inVideo == "-") {
 		inVideo = "pipe:0";
 		stdinPipeUsed = true;
@@ -191,6 +245,11 @@ int yerface(int argc, char *argv[]) {
 	inVideoSize = parser.get<string>("inVideoSize");
 	inVideoRate = parser.get<string>("inVideoRate");
 	inVideoCodec = parser.get<string>("inVideoCodec");
+	decoderThreadCountString = parser.get<string>("decoderThreadCount");
+	if(decoderThreadCountString.length() > 0) {
+		decoderThreadCount = parser.get<int>("decoderThreadCount");
+	}
+	decoderThreadType = parser.get<string>("decoderThreadType");
 	inAudio = parser.get<string>("inAudio");
 	if(inAudio == "-") {
 		inAudio = "pipe:0";
@@ -199,6 +258,9 @@ int yerface(int argc, char *argv[]) {
 		}
 		stdinPipeUsed = true;
 	}
+	if(audioOnly && inAudio == "ignore") {
+		throw invalid_argument("--audioOnly needs audio, so --inAudio cannot be \"ignore\"!");
+	}
 	if(inAudio.length() > 0) {
 		if(inAudio == "ignore") {
 			openInputAudio = false;
@@ -219,6 +281,7 @@ int yerface(int argc, char *argv[]) {
 	inEventData = parser.get<string>("inEventData");
 	inEventDataStartSeconds = parser.get<double>("inEventDataStartSeconds");
 	outEventData = parser.get<string>("outEventData");
+	outEventDataFormat = parser.get<string>("outEventDataFormat");
 	outVideo = parser.get<string>("outVideo");
 	outLogFile = parser.get<string>("outLogFile");
 	outLogColors = parser.get<string>("outLogColors");
@@ -226,6 +289,14 @@ int yerface(int argc, char *argv[]) {
 	headless = parser.has("headless") && parser.get<bool>("headless");
 	previewAudio = parser.has("previewAudio") && parser.get<bool>("previewAudio");
 	previewMirror = parser.get<string>("previewMirror");
+	maxConcurrentWorkers = parser.get<int>("maxConcurrentWorkers");
+	childProcess = parser.has("childProcess") && parser.get<bool>("childProcess");
+	parallelChunks = parser.get<int>("parallelChunks");
+	chunkIndex = parser.get<int>("chunkIndex");
+	chunkStartTime = parser.get<double>("chunkStartTime");
+	chunkEndTime = parser.get<double>("chunkEndTime");
+	inputStartTime = parser.get<double>("startTime");
+	inputEndTime = parser.get<double>("endTime");
 
 	if(!parser.check()) {
 		parser.printErrors();
@@ -233,9 +304,24 @@ int yerface(int argc, char *argv[]) {
 		return 1;
 	}
 
+	//Batch workers run each of their jobs by calling back into here.
+	if(batchWorker) {
+		return runBatchWorker();
+	}
+
+	//A batch worker runs many jobs in this process, so nothing may be left over from the last one.
 	sdlWindowRenderer.window = NULL;
 	sdlWindowRenderer.renderer = NULL;
 	windowInitializationFailed = false;
+	videoCaptureSetFrameSize = false;
+	frameSizeValid = false;
+	frameServerDrained = false;
+	previewDisplayFrameNumbers.clear();
+	frameMetricsTicks.clear();
+	faceDetector = NULL;
+	faceTracker = NULL;
+	faceMapper = NULL;
+	sphinxDriver = NULL;
 
 	if(outLogFile.length() == 0 || outLogFile == "-") {
 		outLogFile = "-";
@@ -268,26 +354,58 @@ int yerface(int argc, char *argv[]) {
 	logger->info("Log filter is set to: %s", Logger::getSeverityString((LogMessageSeverity)logSeverityFilter).c_str());
 	logger->info("Log colorization mode is: %s", outLogColorsString.c_str());
 
+	//Initialize configuration.
+	parseConfigFile();
+	if(decoderThreadCountString.length() > 0) {
+		config["YerFace"]["FFmpegDriver"]["decoderThreadCount"] = decoderThreadCount;
+	}
+	if(decoderThreadType.length() > 0) {
+		config["YerFace"]["FFmpegDriver"]["decoderThreadType"] = decoderThreadType;
+	}
+	if(outEventDataFormat.length() > 0) {
+		config["YerFace"]["OutputDriver"]["outputFileFormat"] = outEventDataFormat;
+	}
+
+	if(convertEventData.length() > 0) {
+		int result = runConvertEventData();
+		delete logger;
+		Logger::setLoggingTarget(stderr);
+		return result;
+	}
+
+	//Parallel chunked processing and batch processing hand everything off to child processes, then we're done.
+	if(parallelChunks > 1 || batchManifest.length() > 0) {
+		int result = batchManifest.length() > 0 ? runBatchManifest(argc, argv) : runParallelChunks(argc, argv);
+		delete logger;
+		Logger::setLoggingTarget(stderr);
+		return result;
+	}
+	if(maxConcurrentWorkers >= 0) {
+		config["YerFace"]["WorkerPoolExecutor"]["maxConcurrentWorkers"] = maxConcurrentWorkers;
+	}
+	if(childProcess) {
+		//Sibling processes would all fight over the same websocket server port.
+		config["YerFace"]["OutputDriver"]["websocketServerEnabled"] = false;
+	}
+
 	//Create locks and conditions.
-	if((frameSizeMutex = SDL_CreateMutex()) == NULL) {
+	if((frameSizeMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
-	if((previewDisplayMutex = SDL_CreateMutex()) == NULL) {
+	if((previewDisplayMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
 	if((previewDisplayCond = SDL_CreateCond()) == NULL) {
 		throw runtime_error("Failed creating condition!");
 	}
-	if((frameServerDrainedMutex = SDL_CreateMutex()) == NULL) {
+	if((frameServerDrainedMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
-	if((frameMetricsMutex = SDL_CreateMutex()) == NULL) {
+	if((frameMetricsMutex = YerFace_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
 
-
-	//Initialize configuration.
-	parseConfigFile();
+	WorkerPoolExecutor::initialize(config);
 
 	//Instantiate our classes.
 	status = new Status(lowLatency);
@@ -295,23 +413,64 @@ int yerface(int argc, char *argv[]) {
 	previewMetrics = new Metrics(config, "YerFace[Preview/Event Loop]", false);
 	frameServer = new FrameServer(config, status, lowLatency);
 	previewHUD = new PreviewHUD(config, status, frameServer, previewMirrorBool);
-	ffmpegDriver = new FFmpegDriver(status, frameServer, lowLatency, false);
-	ffmpegDriver->openInputMedia(inVideo, AVMEDIA_TYPE_VIDEO, inVideoFormat, inVideoSize, "", inVideoRate, inVideoCodec, inAudioChannelMap, tryAudioInVideo);
-	if(openInputAudio) {
-		ffmpegDriver->openInputMedia(inAudio, AVMEDIA_TYPE_AUDIO, inAudioFormat, "", inAudioChannels, inAudioRate, inAudioCodec, inAudioChannelMap, true);
+	ffmpegDriver = new FFmpegDriver(config, status, frameServer, lowLatency, false);
+	if(audioOnly) {
+		if(outVideo.length() > 0) {
+			throw invalid_argument("--audioOnly cannot be combined with --outVideo.");
+		}
+		if(openInputAudio) {
+			ffmpegDriver->openInputMedia(inAudio, AVMEDIA_TYPE_AUDIO, inAudioFormat, "", inAudioChannels, inAudioRate, inAudioCodec, inAudioChannelMap, true);
+		} else {
+			ffmpegDriver->openInputMedia(inVideo, AVMEDIA_TYPE_AUDIO, inVideoFormat, "", inAudioChannels, inAudioRate, inAudioCodec, inAudioChannelMap, true);
+		}
+		if(!ffmpegDriver->getIsAudioInputPresent()) {
+			throw invalid_argument("--audioOnly was specified, but no audio stream could be opened!");
+		}
+		ffmpegDriver->openSyntheticVideo(audioOnlyFrameRate);
+	} else {
+		ffmpegDriver->openInputMedia(inVideo, AVMEDIA_TYPE_VIDEO, inVideoFormat, inVideoSize, "", inVideoRate, inVideoCodec, inAudioChannelMap, tryAudioInVideo);
+		if(openInputAudio) {
+			ffmpegDriver->openInputMedia(inAudio, AVMEDIA_TYPE_AUDIO, inAudioFormat, "", inAudioChannels, inAudioRate, inAudioCodec, inAudioChannelMap, true);
+		}
 	}
 	if(outVideo.length() > 0) {
 		ffmpegDriver->openOutputMedia(outVideo);
 	}
+	double replayStartTime = -1.0;
+	if(chunkIndex >= 0) {
+		//Start early enough to let the smoothing buffers warm up before the first frame we actually output.
+		double warmupSeconds = config["YerFace"]["ChunkedProcessor"]["warmupSeconds"];
+		replayStartTime = std::max(0.0, chunkStartTime - warmupSeconds);
+		ffmpegDriver->setInputTimeRange(replayStartTime, chunkEndTime);
+	} else if(inputStartTime != 0.0 || inputEndTime >= 0.0) {
+		if(lowLatency) {
+			throw invalid_argument("--startTime and --endTime cannot be used in lowLatency mode.");
+		}
+		ffmpegDriver->setInputTimeRange(inputStartTime, inputEndTime);
+		replayStartTime = inputStartTime;
+	}
 	sdlDriver = new SDLDriver(config, status, frameServer, ffmpegDriver, headless, previewAudio && ffmpegDriver->getIsAudioInputPresent());
-	faceDetector = new FaceDetector(config, status, frameServer);
-	faceTracker = new FaceTracker(config, status, sdlDriver, frameServer, faceDetector);
-	faceMapper = new FaceMapper(config, status, frameServer, faceTracker, previewHUD);
+	//In audio only mode the face subsystems are never created, so frames pass straight through their stages.
+	if(!audioOnly) {
+		faceDetector = new FaceDetector(config, status, frameServer, lowLatency);
+		faceTracker = new FaceTracker(config, status, sdlDriver, frameServer, faceDetector);
+		faceMapper = new FaceMapper(config, status, frameServer, faceTracker, previewHUD);
+	}
 	outputDriver = new OutputDriver(config, outEventData, status, frameServer, faceTracker, sdlDriver);
+	if(chunkIndex >= 0) {
+		outputDriver->setOutputTimeRange(chunkStartTime, chunkEndTime);
+		if(chunkIndex > 0) {
+			//The stitched output already gets its automatic basis flag from the first chunk.
+			outputDriver->suppressAutoBasis();
+		}
+	}
 	if(ffmpegDriver->getIsAudioInputPresent()) {
 		sphinxDriver = new SphinxDriver(config, status, frameServer, ffmpegDriver, sdlDriver, outputDriver, previewHUD, lowLatency);
 	}
 	eventLogger = new EventLogger(config, inEventData, inEventDataStartSeconds, status, outputDriver, frameServer);
+	if(replayStartTime > 0.0) {
+		eventLogger->setReplayStartTime(replayStartTime);
+	}
 
 	outputDriver->setEventLogger(eventLogger);
 
@@ -332,7 +491,7 @@ int yerface(int argc, char *argv[]) {
 	if(!headless) {
 		frameStatusChangeCallback.newStatus = FRAME_STATUS_PREVIEW_DISPLAY;
 		frameServer->onFrameStatusChangeEvent(frameStatusChangeCallback);
-		frameServer->registerFrameStatusCheckpoint(FRAME_STATUS_PREVIEW_DISPLAY, "main.PreviewDisplayed");
+		previewDisplayedCheckpoint = frameServer->registerFrameStatusCheckpoint(FRAME_STATUS_PREVIEW_DISPLAY, "main.PreviewDisplayed");
 	}
 	frameStatusChangeCallback.newStatus = FRAME_STATUS_GONE;
 	frameServer->onFrameStatusChangeEvent(frameStatusChangeCallback);
@@ -378,17 +537,14 @@ int yerface(int argc, char *argv[]) {
 			while(previewFrames.size() > 0) {
 				if(previewTargetFrameNumber != -1) {
 					// We had a previous "target" preview frame, we should release it from the pipeline.
-					frameServer->setWorkingFrameStatusCheckpoint(previewTargetFrameNumber, FRAME_STATUS_PREVIEW_DISPLAY, "main.PreviewDisplayed");
+					frameServer->setWorkingFrameStatusCheckpoint(previewTargetFrameNumber, FRAME_STATUS_PREVIEW_DISPLAY, previewDisplayedCheckpoint);
 				}
 				previewTargetFrameNumber = previewFrames.back();
 				previewFrames.pop_back();
 			}
 
 			if(previewTargetFrameNumber != -1) {
-				WorkingFrame *previewFrame = frameServer->getWorkingFrame(previewTargetFrameNumber);
-				YerFace_MutexLock(previewFrame->previewFrameMutex);
-				Mat previewFrameCopy = previewFrame->previewFrame.clone();
-				YerFace_MutexUnlock(previewFrame->previewFrameMutex);
+				Mat previewFrameCopy = frameServer->getWorkingFramePreview(previewTargetFrameNumber);
 				previewHUD->doRenderPreviewHUD(previewFrameCopy, previewTargetFrameNumber);
 				sdlDriver->doRenderPreviewFrame(previewFrameCopy);
 			}
@@ -397,7 +553,7 @@ int yerface(int argc, char *argv[]) {
 		// If we're shutting down, don't hang on to the previous frame.
 		if(!status->getIsRunning()) {
 			if(previewTargetFrameNumber != -1) {
-				frameServer->setWorkingFrameStatusCheckpoint(previewTargetFrameNumber, FRAME_STATUS_PREVIEW_DISPLAY, "main.PreviewDisplayed");
+				frameServer->setWorkingFrameStatusCheckpoint(previewTargetFrameNumber, FRAME_STATUS_PREVIEW_DISPLAY, previewDisplayedCheckpoint);
 				previewTargetFrameNumber = -1;
 			}
 		}
@@ -411,7 +567,7 @@ int yerface(int argc, char *argv[]) {
 		YerFace_MutexLock(previewDisplayMutex);
 		if(status->getIsRunning() && previewDisplayFrameNumbers.size() == 0) {
 			// Condition timeout needs to be very short because our our responsiveness to input events depends on it.
-			int result = SDL_CondWaitTimeout(previewDisplayCond, previewDisplayMutex, 1);
+			int result = YerFace_CondWaitTimeout(previewDisplayCond, previewDisplayMutex, 1);
 			if(result < 0) {
 				throw runtime_error("CondWaitTimeout() failed!");
 			}
@@ -446,6 +602,8 @@ int yerface(int argc, char *argv[]) {
 	YerFace_CarefullyDelete(logger, status, sdlDriver);
 	YerFace_CarefullyDelete(logger, status, previewMetrics);
 	YerFace_CarefullyDelete(logger, status, metrics);
+	WorkerPoolExecutor::shutdown();
+	InstrumentedMutex::logReport();
 	YerFace_CarefullyDelete_NoStatus(logger, status);
 	try {
 		logger->notice("Goodbye!");
@@ -459,11 +617,11 @@ int yerface(int argc, char *argv[]) {
 	// Otherwise this line will have no effect.
 	Logger::setLoggingTarget(stderr);
 
-	SDL_DestroyMutex(frameSizeMutex);
-	SDL_DestroyMutex(previewDisplayMutex);
+	YerFace_DestroyMutex(frameSizeMutex);
+	YerFace_DestroyMutex(previewDisplayMutex);
 	SDL_DestroyCond(previewDisplayCond);
-	SDL_DestroyMutex(frameServerDrainedMutex);
-	SDL_DestroyMutex(frameMetricsMutex);
+	YerFace_DestroyMutex(frameServerDrainedMutex);
+	YerFace_DestroyMutex(frameMetricsMutex);
 
 	return 0;
 }
@@ -476,16 +634,15 @@ void videoCaptureInitializer(WorkerPoolWorker *worker, void *ptr) {
 bool videoCaptureHandler(WorkerPoolWorker *worker) {
 	VideoFrame videoFrame;
 	bool didWork = false;
-	static bool didSetFrameSizeValid = false;
 
 	int demuxerRunning = ffmpegDriver->pollForNextVideoFrame(&videoFrame);
 	if(videoFrame.valid) {
-		if(!didSetFrameSizeValid) {
+		if(!videoCaptureSetFrameSize) {
 			YerFace_MutexLock(frameSizeMutex);
 			if(!frameSizeValid) {
 				frameSize = videoFrame.frameCV.size();
 				frameSizeValid = true;
-				didSetFrameSizeValid = true;
+				videoCaptureSetFrameSize = true;
 			}
 			YerFace_MutexUnlock(frameSizeMutex);
 		}
@@ -553,6 +710,132 @@ void parseConfigFile(void) {
 	}
 }
 
+int runParallelChunks(int argc, char *argv[]) {
+	if(lowLatency) {
+		throw invalid_argument("parallelChunks cannot be used in lowLatency mode.");
+	}
+	if(outVideo.length() > 0) {
+		throw invalid_argument("parallelChunks cannot be used together with outVideo.");
+	}
+	if(stdinPipeUsed) {
+		throw invalid_argument("parallelChunks cannot read from STDIN.");
+	}
+	if(audioOnly) {
+		throw invalid_argument("parallelChunks cannot be used in audioOnly mode.");
+	}
+	if(inputStartTime != 0.0 || inputEndTime >= 0.0) {
+		throw invalid_argument("parallelChunks cannot be used together with startTime or endTime.");
+	}
+
+	//Children get all of our arguments, except for the ones the ChunkedProcessor sets for each child.
+	std::vector<string> passthroughArguments = filterChildArguments(argc, argv, { "parallelChunks", "outEventData", "outLogFile", "headless", "previewAudio", "configFile", "chunkIndex", "chunkStartTime", "chunkEndTime", "maxConcurrentWorkers", "childProcess" });
+
+	ChunkedProcessor chunkedProcessor(config, argv[0], passthroughArguments, inVideo, inVideoFormat, outEventData, parallelChunks);
+	if(!chunkedProcessor.run()) {
+		logger->err("Parallel chunked processing failed!");
+		return 1;
+	}
+	logger->notice("Goodbye!");
+	return 0;
+}
+
+int runConvertEventData(void) {
+	if(outEventData.length() == 0) {
+		throw invalid_argument("convertEventData requires outEventData.");
+	}
+	OutputFrameFileReader eventReader(convertEventData);
+	ofstream outputFilestream;
+	outputFilestream.open(outEventData, ofstream::out | ofstream::binary | ofstream::trunc);
+	if(outputFilestream.fail()) {
+		throw invalid_argument("could not open outEventData for writing");
+	}
+	logger->info("Converting %s event data %s to JSON...", OutputFrameFormat::formatName(eventReader.getFormat()), convertEventData.c_str());
+	FrameNumber frames = 0;
+	json frame;
+	while(eventReader.readFrame(&frame)) {
+		outputFilestream << frame.dump(-1, ' ', true) << "\n";
+		frames++;
+	}
+	outputFilestream.close();
+	logger->notice("Converted " YERFACE_FRAMENUMBER_FORMAT " frames into %s. Goodbye!", frames, outEventData.c_str());
+	return 0;
+}
+
+int runBatchManifest(int argc, char *argv[]) {
+	if(lowLatency) {
+		throw invalid_argument("batchManifest cannot be used in lowLatency mode.");
+	}
+
+	//Every job gets our arguments as defaults, except for the ones which only make sense per job.
+	std::vector<string> passthroughArguments = filterChildArguments(argc, argv, { "batchManifest", "batchWorker", "inVideo", "inAudio", "inEventData", "outEventData", "outVideo", "outLogFile", "headless", "previewAudio", "configFile", "maxConcurrentWorkers", "childProcess" });
+
+	BatchProcessor batchProcessor(config, argv[0], passthroughArguments, batchManifest);
+	if(!batchProcessor.run()) {
+		logger->err("One or more batch jobs failed!");
+		return 1;
+	}
+	logger->notice("Goodbye!");
+	return 0;
+}
+
+int runBatchWorker(void) {
+	//Each line on STDIN is a job holding its complete command line. We answer each one with a line on STDOUT.
+	Logger::slog("BatchWorker", LOG_SEVERITY_DEBUG1, "Batch worker waiting for jobs...");
+	string line;
+	while(getline(cin, line)) {
+		if(line.length() == 0) {
+			continue;
+		}
+		json request = json::parse(line);
+		std::vector<string> arguments = request["arguments"];
+		std::vector<char *> jobArgv;
+		for(string &argument : arguments) {
+			jobArgv.push_back((char *)argument.c_str());
+		}
+		jobArgv.push_back(NULL);
+
+		int result = 1;
+		bool jobThrew = false;
+		try {
+			result = yerface((int)arguments.size(), jobArgv.data());
+		} catch(exception &e) {
+			Logger::slog("BatchWorker", LOG_SEVERITY_CRIT, "Uncaught exception while running job: %s", e.what());
+			jobThrew = true;
+		}
+
+		json reply;
+		reply["job"] = request["job"];
+		reply["result"] = result;
+		fprintf(stdout, "%s\n", reply.dump().c_str());
+		fflush(stdout);
+		if(jobThrew) {
+			//Whatever the failed job left behind can't be trusted to run another one.
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void releaseCachedModels(void) {
+	FaceDetector::releaseCachedModels();
+	FaceTracker::releaseCachedModels();
+	SphinxDriver::releaseCachedDecoders();
+}
+
+std::vector<string> filterChildArguments(int argc, char *argv[], std::vector<string> reservedArguments) {
+	std::vector<string> passthroughArguments;
+	for(int i = 1; i < argc; i++) {
+		string argument = argv[i];
+		size_t keyStart = argument.find_first_not_of('-');
+		string key = keyStart == string::npos ? "" : argument.substr(keyStart, argument.find('=') - keyStart);
+		if(std::find(reservedArguments.begin(), reservedArguments.end(), key) == reservedArguments.end()) {
+			passthroughArguments.push_back(argument);
+		}
+	}
+	passthroughArguments.push_back("--configFile=" + configFile);
+	return passthroughArguments;
+}
+
 void handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps) {
 	FrameNumber frameNumber = frameTimestamps.frameNumber;
 	switch(newStatus) {
@@ -585,9 +868,11 @@ void handleFrameServerDrainedEvent(void *userdata) {
 }
 
 void renderPreviewHUD(Mat previewFrame, FrameNumber frameNumber, int density, bool mirrorMode) {
-	faceDetector->renderPreviewHUD(previewFrame, frameNumber, density, mirrorMode);
-	faceTracker->renderPreviewHUD(previewFrame, frameNumber, density, mirrorMode);
-	faceMapper->renderPreviewHUD(previewFrame, frameNumber, density, mirrorMode);
+	if(!audioOnly) {
+		faceDetector->renderPreviewHUD(previewFrame, frameNumber, density, mirrorMode);
+		faceTracker->renderPreviewHUD(previewFrame, frameNumber, density, mirrorMode);
+		faceMapper->renderPreviewHUD(previewFrame, frameNumber, density, mirrorMode);
+	}
 	if(sphinxDriver != NULL) {
 		sphinxDriver->renderPreviewHUD(previewFrame, frameNumber, density, mirrorMode);
 	}
@@ -0,0 +1,141 @@
+#include "Utilities.hpp"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace YerFace;
+
+namespace {
+
+//Deterministic noise across the whole int16 range, so failures are reproducible.
+std::vector<int16_t> generateSamples(size_t count, uint32_t seed) {
+	std::vector<int16_t> samples(count);
+	uint32_t state = seed;
+	for(size_t i = 0; i < count; i++) {
+		state = state * 1664525 + 1013904223;
+		samples[i] = (int16_t)(state >> 16);
+	}
+	return samples;
+}
+
+void expectSameEnvelope(const AudioEnvelope &a, const AudioEnvelope &b) {
+	//Both paths do exact integer math and the same final division, so the results must match exactly.
+	EXPECT_EQ(a.peak, b.peak);
+	EXPECT_EQ(a.clipped, b.clipped);
+	EXPECT_EQ(a.sumOfSquares, b.sumOfSquares);
+	EXPECT_EQ(a.samples, b.samples);
+}
+
+void expectVectorizedMatchesScalar(const int16_t *samples, int count) {
+	SCOPED_TRACE(testing::Message() << "count = " << count);
+	expectSameEnvelope(Utilities::calculateAudioEnvelope(samples, count), Utilities::calculateAudioEnvelope(samples, count, false));
+}
+
+} //namespace
+
+TEST(AudioEnvelopeTest, KnownValues) {
+	int16_t samples[] = { 3, -4 };
+	AudioEnvelope envelope = Utilities::calculateAudioEnvelope(samples, 2);
+	EXPECT_EQ(envelope.samples, 2);
+	EXPECT_DOUBLE_EQ(envelope.peak, 4.0 / 32767.0);
+	EXPECT_FALSE(envelope.clipped);
+	EXPECT_DOUBLE_EQ(envelope.sumOfSquares, 25.0 / (32767.0 * 32767.0));
+	EXPECT_DOUBLE_EQ(envelope.getRMS(), sqrt(12.5) / 32767.0);
+}
+
+TEST(AudioEnvelopeTest, EmptyBuffer) {
+	AudioEnvelope envelope = Utilities::calculateAudioEnvelope(NULL, 0);
+	EXPECT_EQ(envelope.samples, 0);
+	EXPECT_EQ(envelope.peak, 0.0);
+	EXPECT_FALSE(envelope.clipped);
+	EXPECT_EQ(envelope.getRMS(), 0.0);
+}
+
+TEST(AudioEnvelopeTest, VectorizedMatchesScalarOnOddCountsAndTails) {
+	std::vector<int16_t> samples = generateSamples(1031, 1);
+	//Every count up to a few vectors wide, so each tail length gets exercised, plus some longer odd runs.
+	for(int count = 0; count <= 40; count++) {
+		expectVectorizedMatchesScalar(samples.data(), count);
+	}
+	for(int count : { 255, 257, 1023, 1025, 1031 }) {
+		expectVectorizedMatchesScalar(samples.data(), count);
+	}
+	//Unaligned starting points.
+	for(int offset = 1; offset < 8; offset++) {
+		expectVectorizedMatchesScalar(samples.data() + offset, 1031 - offset);
+	}
+}
+
+TEST(AudioEnvelopeTest, VectorizedMatchesScalarOnInt16Min) {
+	for(int count : { 1, 7, 8, 9, 15, 16, 17, 1024 }) {
+		std::vector<int16_t> samples(count, INT16_MIN);
+		expectVectorizedMatchesScalar(samples.data(), count);
+		AudioEnvelope envelope = Utilities::calculateAudioEnvelope(samples.data(), count);
+		EXPECT_EQ(envelope.peak, 1.0);
+		EXPECT_TRUE(envelope.clipped);
+		EXPECT_DOUBLE_EQ(envelope.sumOfSquares, (double)count * 32768.0 * 32768.0 / (32767.0 * 32767.0));
+	}
+
+	//A lone INT16_MIN in the tail, after the vector loop, must still be caught.
+	std::vector<int16_t> samples(19, 100);
+	samples[18] = INT16_MIN;
+	expectVectorizedMatchesScalar(samples.data(), 19);
+	EXPECT_TRUE(Utilities::calculateAudioEnvelope(samples.data(), 19).clipped);
+}
+
+TEST(AudioEnvelopeTest, VectorizedMatchesScalarOnFullScaleExtremes) {
+	//Alternating extremes make every pair of squares sum to its largest possible value.
+	std::vector<int16_t> samples(1027);
+	for(size_t i = 0; i < samples.size(); i++) {
+		samples[i] = (i % 2 == 0) ? INT16_MIN : INT16_MAX;
+	}
+	expectVectorizedMatchesScalar(samples.data(), (int)samples.size());
+	std::fill(samples.begin(), samples.end(), INT16_MIN);
+	expectVectorizedMatchesScalar(samples.data(), (int)samples.size());
+}
+
+TEST(AudioEnvelopeTest, AccumulateMatchesWholeBuffer) {
+	std::vector<int16_t> samples = generateSamples(1000, 2);
+	AudioEnvelope whole = Utilities::calculateAudioEnvelope(samples.data(), 1000);
+	AudioEnvelope combined;
+	combined.accumulate(Utilities::calculateAudioEnvelope(samples.data(), 333));
+	combined.accumulate(Utilities::calculateAudioEnvelope(samples.data() + 333, 667));
+	EXPECT_EQ(combined.samples, whole.samples);
+	EXPECT_EQ(combined.peak, whole.peak);
+	EXPECT_EQ(combined.clipped, whole.clipped);
+	EXPECT_DOUBLE_EQ(combined.sumOfSquares, whole.sumOfSquares);
+}
+
+//Micro-benchmark. Reports the time per call of each path, but only asserts that they agree, so it can't flake on a busy machine.
+TEST(AudioEnvelopeBenchmark, VectorizedAgainstScalar) {
+	const int count = 1024;
+	const int iterations = 20000;
+	std::vector<int16_t> samples = generateSamples(count, 3);
+
+	double results[2];
+	AudioEnvelope envelopes[2];
+	for(int pass = 0; pass < 2; pass++) {
+		bool vectorized = (pass == 0);
+		double peakSum = 0.0;
+		auto start = std::chrono::steady_clock::now();
+		for(int i = 0; i < iterations; i++) {
+			envelopes[pass] = Utilities::calculateAudioEnvelope(samples.data(), count, vectorized);
+			peakSum += envelopes[pass].peak; //Keeps the calls from being optimized away.
+		}
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		results[pass] = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / (double)iterations;
+		EXPECT_GT(peakSum, 0.0);
+	}
+	expectSameEnvelope(envelopes[0], envelopes[1]);
+
+	cout << "calculateAudioEnvelope(" << count << " samples): vectorized " << results[0] << " ns, scalar " << results[1] << " ns" << endl;
+	RecordProperty("VectorizedNanoseconds", (int)results[0]);
+	RecordProperty("ScalarNanoseconds", (int)results[1]);
+}